@@ -0,0 +1,221 @@
+/**
+ * Copyright (C) 2020-2021 Photon Vision.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <string>
+#include <vector>
+
+#include <frc/geometry/Pose2d.h>
+#include <frc/geometry/Transform2d.h>
+#include <units/angle.h>
+#include <units/length.h>
+
+#include "jni.h"
+#include "org_photonvision_PhotonJNI.h"
+#include "photonlib/PhotonResultColumns.h"
+#include "photonlib/SimVisionSystem.h"
+
+using photonlib::PhotonResultColumns;
+
+namespace {
+// Values the Java side packs per pose and per target.
+constexpr jsize kPoseSize = 3;
+constexpr jsize kTargetSize = 6;
+static_assert(sizeof(photonlib::SimPackedTarget) ==
+              kTargetSize * sizeof(jdouble));
+
+// A native SimVisionSystem together with storage reused across batches, so
+// steady-state sweeps don't allocate.
+struct SimHandle {
+  SimHandle(const std::string& name, units::degree_t camDiagFOV,
+            units::degree_t camPitch, frc::Transform2d cameraToRobot,
+            units::meter_t cameraHeightOffGround, units::meter_t maxLEDRange,
+            int cameraResWidth, int cameraResHeight, double minTargetArea)
+      : system(name, camDiagFOV, camPitch, cameraToRobot,
+               cameraHeightOffGround, maxLEDRange, cameraResWidth,
+               cameraResHeight, minTargetArea) {}
+
+  photonlib::SimVisionSystem system;
+  std::vector<double> packed;
+  std::vector<frc::Pose2d> poses;
+  std::vector<photonlib::PhotonPipelineResult> results;
+};
+
+// A zero handle is one the Java side has already closed. The entry points
+// ignore it rather than dereferencing null.
+SimHandle* FromHandle(jlong handle) {
+  return reinterpret_cast<SimHandle*>(handle);
+}
+
+// Writes the first count results of the last batch into the Java arrays,
+// which the caller has checked are long enough.
+bool WriteResults(JNIEnv* env, const SimHandle& sim, jint count,
+                  jdoubleArray results, jintArray targetCounts,
+                  jint capacity) {
+  size_t stride = PhotonResultColumns::Size(capacity);
+  auto out =
+      static_cast<double*>(env->GetPrimitiveArrayCritical(results, nullptr));
+  if (!out) return false;
+  auto counts =
+      static_cast<jint*>(env->GetPrimitiveArrayCritical(targetCounts, nullptr));
+  if (!counts) {
+    env->ReleasePrimitiveArrayCritical(results, out, JNI_ABORT);
+    return false;
+  }
+  for (jint i = 0; i < count; ++i) {
+    counts[i] = PhotonResultColumns::Write(sim.results[i], out + i * stride,
+                                           capacity);
+  }
+  env->ReleasePrimitiveArrayCritical(targetCounts, counts, 0);
+  env->ReleasePrimitiveArrayCritical(results, out, 0);
+  return true;
+}
+
+frc::Transform2d MakeTransform(double x, double y, double degrees) {
+  return frc::Transform2d(
+      frc::Translation2d(units::meter_t(x), units::meter_t(y)),
+      frc::Rotation2d(units::degree_t(degrees)));
+}
+}  // namespace
+
+/*
+ * Class:     org_photonvision_PhotonJNI
+ * Method:    simCreate
+ * Signature: (Ljava/lang/String;DDDDDDDIID)J
+ */
+JNIEXPORT jlong JNICALL Java_org_photonvision_PhotonJNI_simCreate(
+    JNIEnv* env, jclass, jstring name, jdouble camDiagFOVDegrees,
+    jdouble camPitchDegrees, jdouble cameraToRobotX, jdouble cameraToRobotY,
+    jdouble cameraToRobotDegrees, jdouble cameraHeightOffGroundMeters,
+    jdouble maxLEDRangeMeters, jint cameraResWidth, jint cameraResHeight,
+    jdouble minTargetArea) {
+  const char* chars = env->GetStringUTFChars(name, nullptr);
+  if (!chars) return 0;
+  std::string camName = chars;
+  env->ReleaseStringUTFChars(name, chars);
+
+  auto handle = new SimHandle(
+      camName, units::degree_t(camDiagFOVDegrees),
+      units::degree_t(camPitchDegrees),
+      MakeTransform(cameraToRobotX, cameraToRobotY, cameraToRobotDegrees),
+      units::meter_t(cameraHeightOffGroundMeters),
+      units::meter_t(maxLEDRangeMeters), cameraResWidth, cameraResHeight,
+      minTargetArea);
+  return reinterpret_cast<jlong>(handle);
+}
+
+/*
+ * Class:     org_photonvision_PhotonJNI
+ * Method:    simDestroy
+ * Signature: (J)V
+ */
+JNIEXPORT void JNICALL Java_org_photonvision_PhotonJNI_simDestroy(
+    JNIEnv*, jclass, jlong handle) {
+  delete FromHandle(handle);
+}
+
+/*
+ * Class:     org_photonvision_PhotonJNI
+ * Method:    simMoveCamera
+ * Signature: (JDDDDD)V
+ */
+JNIEXPORT void JNICALL Java_org_photonvision_PhotonJNI_simMoveCamera(
+    JNIEnv*, jclass, jlong handle, jdouble cameraToRobotX,
+    jdouble cameraToRobotY, jdouble cameraToRobotDegrees,
+    jdouble cameraHeightOffGroundMeters, jdouble camPitchDegrees) {
+  auto sim = FromHandle(handle);
+  if (!sim) return;
+  sim->system.MoveCamera(
+      MakeTransform(cameraToRobotX, cameraToRobotY, cameraToRobotDegrees),
+      units::meter_t(cameraHeightOffGroundMeters),
+      units::degree_t(camPitchDegrees));
+}
+
+/*
+ * Class:     org_photonvision_PhotonJNI
+ * Method:    simAddTargets
+ * Signature: (J[DI)Z
+ */
+JNIEXPORT jboolean JNICALL Java_org_photonvision_PhotonJNI_simAddTargets(
+    JNIEnv* env, jclass, jlong handle, jdoubleArray targets, jint count) {
+  auto sim = FromHandle(handle);
+  if (!sim || count < 0 ||
+      env->GetArrayLength(targets) < count * kTargetSize) {
+    return JNI_FALSE;
+  }
+  // SimPackedTarget is kTargetSize doubles, so the array copies straight in.
+  std::vector<photonlib::SimPackedTarget> packed(count);
+  env->GetDoubleArrayRegion(targets, 0, count * kTargetSize,
+                            reinterpret_cast<jdouble*>(packed.data()));
+  return sim->system.AddTargets(packed) ? JNI_TRUE : JNI_FALSE;
+}
+
+/*
+ * Class:     org_photonvision_PhotonJNI
+ * Method:    simProcessFrames
+ * Signature: (J[DI[D[II)Z
+ */
+JNIEXPORT jboolean JNICALL Java_org_photonvision_PhotonJNI_simProcessFrames(
+    JNIEnv* env, jclass, jlong handle, jdoubleArray poses, jint count,
+    jdoubleArray results, jintArray targetCounts, jint capacity) {
+  auto sim = FromHandle(handle);
+  size_t stride = PhotonResultColumns::Size(capacity);
+  if (!sim || count < 0 || capacity < 0 ||
+      env->GetArrayLength(poses) < count * kPoseSize ||
+      static_cast<size_t>(env->GetArrayLength(results)) < count * stride ||
+      env->GetArrayLength(targetCounts) < count) {
+    return JNI_FALSE;
+  }
+
+  sim->packed.resize(count * kPoseSize);
+  env->GetDoubleArrayRegion(poses, 0, count * kPoseSize, sim->packed.data());
+  sim->poses.resize(count);
+  for (jint i = 0; i < count; ++i) {
+    const double* pose = &sim->packed[i * kPoseSize];
+    sim->poses[i] =
+        frc::Pose2d(units::meter_t(pose[0]), units::meter_t(pose[1]),
+                    frc::Rotation2d(units::degree_t(pose[2])));
+  }
+
+  // Simulate outside the critical sections, which must stay short.
+  sim->results.resize(count);
+  sim->system.ProcessFrames(sim->poses, sim->results);
+
+  return WriteResults(env, *sim, count, results, targetCounts, capacity)
+             ? JNI_TRUE
+             : JNI_FALSE;
+}
+
+/*
+ * Class:     org_photonvision_PhotonJNI
+ * Method:    simCopyResults
+ * Signature: (JI[D[II)Z
+ */
+JNIEXPORT jboolean JNICALL Java_org_photonvision_PhotonJNI_simCopyResults(
+    JNIEnv* env, jclass, jlong handle, jint count, jdoubleArray results,
+    jintArray targetCounts, jint capacity) {
+  auto sim = FromHandle(handle);
+  size_t stride = PhotonResultColumns::Size(capacity);
+  if (!sim || count < 0 || capacity < 0 ||
+      static_cast<size_t>(count) > sim->results.size() ||
+      static_cast<size_t>(env->GetArrayLength(results)) < count * stride ||
+      env->GetArrayLength(targetCounts) < count) {
+    return JNI_FALSE;
+  }
+  return WriteResults(env, *sim, count, results, targetCounts, capacity)
+             ? JNI_TRUE
+             : JNI_FALSE;
+}
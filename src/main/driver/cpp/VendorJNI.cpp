@@ -15,8 +15,25 @@
  * along with this program.  If not, see <https://www.gnu.org/licenses/>.
  */
 
-#include "com_vendor_jni_VendorJNI.h"
+#include <cstdint>
+
 #include "jni.h"
+#include "org_photonvision_PhotonJNI.h"
+#include "photonlib/PhotonResultColumns.h"
+
+using photonlib::PhotonResultColumns;
+
+namespace {
+// Returns the first length bytes of a direct ByteBuffer, or an empty range if
+// the buffer isn't direct or is shorter than that.
+wpi::ArrayRef<uint8_t> GetInput(JNIEnv* env, jobject buffer, jint length) {
+  auto data = static_cast<const uint8_t*>(env->GetDirectBufferAddress(buffer));
+  if (!data || length < 0 || length > env->GetDirectBufferCapacity(buffer)) {
+    return {};
+  }
+  return wpi::ArrayRef<uint8_t>(data, length);
+}
+}  // namespace
 
 JNIEXPORT jint JNICALL JNI_OnLoad(JavaVM* vm, void* reserved) {
   // Check to ensure the JNI version is valid
@@ -25,22 +42,50 @@ JNIEXPORT jint JNICALL JNI_OnLoad(JavaVM* vm, void* reserved) {
   if (vm->GetEnv(reinterpret_cast<void**>(&env), JNI_VERSION_1_6) != JNI_OK)
     return JNI_ERR;
 
-  // In here is also where you store things like class references
-  // if they are ever needed
-
   return JNI_VERSION_1_6;
 }
 
 JNIEXPORT void JNICALL JNI_OnUnload(JavaVM* vm, void* reserved) {}
 
 /*
- * Class:     com_vendor_jni_VendorJNI
- * Method:    initialize
- * Signature: ()I
+ * Class:     org_photonvision_PhotonJNI
+ * Method:    decodeResult
+ * Signature: (Ljava/nio/ByteBuffer;I[DI)I
+ */
+JNIEXPORT jint JNICALL Java_org_photonvision_PhotonJNI_decodeResult(
+    JNIEnv* env, jclass, jobject input, jint length, jdoubleArray output,
+    jint capacity) {
+  auto data = GetInput(env, input, length);
+  if (data.empty() || capacity < 0 ||
+      static_cast<size_t>(env->GetArrayLength(output)) <
+          PhotonResultColumns::Size(capacity)) {
+    return -1;
+  }
+
+  // Decoding makes no JNI calls, so the array can be written in place.
+  auto out =
+      static_cast<double*>(env->GetPrimitiveArrayCritical(output, nullptr));
+  if (!out) return -1;
+  int count = PhotonResultColumns::Decode(data, out, capacity);
+  env->ReleasePrimitiveArrayCritical(output, out, count < 0 ? JNI_ABORT : 0);
+  return count;
+}
+
+/*
+ * Class:     org_photonvision_PhotonJNI
+ * Method:    decodeResultDirect
+ * Signature: (Ljava/nio/ByteBuffer;ILjava/nio/ByteBuffer;I)I
  */
-JNIEXPORT jint JNICALL
-Java_com_vendor_jni_VendorJNI_initialize
-  (JNIEnv*, jclass)
-{
-  return 0;
+JNIEXPORT jint JNICALL Java_org_photonvision_PhotonJNI_decodeResultDirect(
+    JNIEnv* env, jclass, jobject input, jint length, jobject output,
+    jint capacity) {
+  auto data = GetInput(env, input, length);
+  auto out = static_cast<double*>(env->GetDirectBufferAddress(output));
+  if (data.empty() || !out || capacity < 0 ||
+      reinterpret_cast<uintptr_t>(out) % alignof(double) != 0 ||
+      static_cast<size_t>(env->GetDirectBufferCapacity(output)) <
+          PhotonResultColumns::Size(capacity) * sizeof(double)) {
+    return -1;
+  }
+  return PhotonResultColumns::Decode(data, out, capacity);
 }
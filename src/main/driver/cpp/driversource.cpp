@@ -17,6 +17,103 @@
 
 #include "driverheader.h"
 
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <type_traits>
+
+#include <networktables/NetworkTable.h>
+#include <networktables/NetworkTableEntry.h>
+#include <networktables/NetworkTableInstance.h>
+#include <networktables/NetworkTableValue.h>
+
+#include "photonlib/PhotonPipelineResult.h"
+#include "photonlib/PhotonResultChannel.h"
+#include "photonlib/PhotonResultColumns.h"
+
+using photonlib::PhotonResultColumns;
+
+// The targets are decoded as rows of doubles in Column order.
+static_assert(std::is_standard_layout<photon_target_t>::value &&
+                  sizeof(photon_target_t) ==
+                      PhotonResultColumns::kColumnCount * sizeof(double),
+              "photon_target_t must match PhotonResultColumns::Column");
+
+struct photon_camera_t {
+  nt::NetworkTableEntry rawBytesEntry;
+  std::shared_ptr<photonlib::PhotonResultChannel> directChannel;
+  // The results returned last, to tell whether there is a newer one. Values
+  // are replaced rather than changed when published, so identity suffices.
+  std::shared_ptr<const photonlib::PhotonPipelineResult> lastDirect;
+  std::shared_ptr<nt::Value> lastValue;
+};
+
+namespace {
+void FillResult(const photonlib::PhotonPipelineResult& source,
+                photon_result_t* result) {
+  auto targets = source.GetTargets();
+  result->latency_ms = source.GetLatency().to<double>() * 1000;
+  result->target_count = static_cast<int32_t>(targets.size());
+  size_t written = std::min<size_t>(targets.size(), result->capacity);
+  for (size_t i = 0; i < written; ++i) {
+    const auto& target = targets[i];
+    auto pose = target.GetCameraRelativePose();
+    result->targets[i] = {target.GetYaw(),
+                          target.GetPitch(),
+                          target.GetArea(),
+                          target.GetSkew(),
+                          pose.Translation().X().to<double>(),
+                          pose.Translation().Y().to<double>(),
+                          pose.Rotation().Degrees().to<double>()};
+  }
+}
+}  // namespace
+
 extern "C" {
-void c_doThing(void) {}
+int photon_decode(const uint8_t* data, size_t size, photon_result_t* result) {
+  if (!data || !result || (result->capacity > 0 && !result->targets)) {
+    return PHOTON_ERROR_ARGUMENT;
+  }
+  int count = PhotonResultColumns::DecodeRows(
+      wpi::ArrayRef<uint8_t>(data, size), &result->latency_ms,
+      reinterpret_cast<double*>(result->targets), result->capacity);
+  if (count < 0) return PHOTON_ERROR_MALFORMED;
+  result->target_count = count;
+  return 0;
+}
+
+photon_camera_t* photon_camera_open(const char* name) {
+  if (!name) return nullptr;
+  auto table = nt::NetworkTableInstance::GetDefault()
+                   .GetTable("photonvision")
+                   ->GetSubTable(name);
+  return new photon_camera_t{
+      table->GetEntry("rawBytes"),
+      photonlib::PhotonResultChannel::Get(table->GetPath()), nullptr, nullptr};
+}
+
+void photon_camera_close(photon_camera_t* camera) { delete camera; }
+
+int photon_camera_poll(photon_camera_t* camera, photon_result_t* result) {
+  if (!camera || !result || (result->capacity > 0 && !result->targets)) {
+    return PHOTON_ERROR_ARGUMENT;
+  }
+
+  // Results from a simulated camera in this process skip NetworkTables, as
+  // in PhotonCamera::GetLatestResult.
+  if (auto direct = camera->directChannel->Latest()) {
+    if (direct == camera->lastDirect) return 0;
+    camera->lastDirect = direct;
+    FillResult(*direct, result);
+    return 1;
+  }
+
+  auto value = camera->rawBytesEntry.GetValue();
+  if (!value || !value->IsRaw() || value == camera->lastValue) return 0;
+  camera->lastValue = value;
+  const auto& raw = value->GetRaw();
+  int status = photon_decode(reinterpret_cast<const uint8_t*>(raw.data()),
+                             raw.size(), result);
+  return status < 0 ? status : 1;
+}
 }  // extern "C"
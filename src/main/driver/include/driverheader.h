@@ -17,6 +17,92 @@
 
 #pragma once
 
+/*
+ * A C interface to the PhotonDriver library, for callers that can't use the
+ * C++ API, e.g. through a foreign function interface. Nothing here allocates
+ * on the caller's behalf: results are decoded into storage the caller owns.
+ */
+
+#ifdef __cplusplus
+#include <cstddef>
+#include <cstdint>
+#else
+#include <stddef.h>
+#include <stdint.h>
+#endif
+
+#ifdef __cplusplus
 extern "C" {
-void c_doThing(void);
+#endif
+
+/** The photon_* functions return these on failure. */
+#define PHOTON_ERROR_MALFORMED (-1)
+#define PHOTON_ERROR_ARGUMENT (-2)
+
+/** A tracked target. Angles are in degrees and lengths in meters. */
+typedef struct photon_target_t {
+  double yaw;
+  double pitch;
+  double area;
+  double skew;
+  /** The target's pose relative to the camera. */
+  double x;
+  double y;
+  double rotation;
+} photon_target_t;
+
+/**
+ * A pipeline result. Before decoding, the caller points targets at an array
+ * of capacity targets.
+ */
+typedef struct photon_result_t {
+  double latency_ms;
+  /**
+   * The number of targets in the result. If this is more than capacity, only
+   * the first capacity are written.
+   */
+  int32_t target_count;
+  uint32_t capacity;
+  photon_target_t* targets;
+} photon_result_t;
+
+/** A camera opened with photon_camera_open. */
+typedef struct photon_camera_t photon_camera_t;
+
+/**
+ * Decodes a pipeline result packet, as published on a camera's rawBytes
+ * NetworkTables entry.
+ * @param data   The packet data.
+ * @param size   The size of the packet in bytes.
+ * @param result The result to fill in.
+ * @return 0, PHOTON_ERROR_MALFORMED if the packet is malformed, or
+ *         PHOTON_ERROR_ARGUMENT if a pointer is null.
+ */
+int photon_decode(const uint8_t* data, size_t size, photon_result_t* result);
+
+/**
+ * Opens a camera by the name it has in the PhotonVision UI, on the default
+ * NetworkTables instance.
+ * @param name The name of the camera.
+ * @return The camera, or null if name is null.
+ */
+photon_camera_t* photon_camera_open(const char* name);
+
+/**
+ * Closes a camera. Does nothing if camera is null.
+ * @param camera The camera.
+ */
+void photon_camera_close(photon_camera_t* camera);
+
+/**
+ * Decodes the camera's latest result, if it is newer than the one returned
+ * by the previous call.
+ * @param camera The camera.
+ * @param result The result to fill in.
+ * @return 1 if there was a new result, 0 if not, or a PHOTON_ERROR code.
+ */
+int photon_camera_poll(photon_camera_t* camera, photon_result_t* result);
+
+#ifdef __cplusplus
 }  // extern "C"
+#endif
@@ -0,0 +1,220 @@
+/**
+ * Copyright (C) 2020-2021 Photon Vision.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+package org.photonvision;
+
+import java.util.ArrayList;
+import java.util.List;
+
+import edu.wpi.first.wpilibj.geometry.Pose2d;
+import edu.wpi.first.wpilibj.geometry.Rotation2d;
+import edu.wpi.first.wpilibj.geometry.Transform2d;
+import edu.wpi.first.wpilibj.geometry.Translation2d;
+
+/**
+ * A {@link SimVisionSystem} backed by the native simulator in the PhotonDriver
+ * library. It is much faster with many targets, and simulates whole batches
+ * of robot poses in a single native call, which suits simulation sweeps and
+ * offline tools. Results are returned to the caller rather than published to
+ * NetworkTables.
+ *
+ * <p>The native simulator is freed by {@link #close()}, after which every
+ * other method throws.
+ */
+public class NativeSimVisionSystem implements AutoCloseable {
+    private static final int POSE_SIZE = 3;
+    private static final int TARGET_SIZE = 6;
+
+    private long handle;
+    private double[] poseData = new double[0];
+    private double[] resultData = new double[0];
+    private int[] targetCounts = new int[0];
+
+    /**
+     * Returns whether the native simulator is available.
+     * @return Whether the PhotonDriver library was loaded.
+     */
+    public static boolean isAvailable() {
+        return PhotonJNI.isLoaded();
+    }
+
+    /**
+     * Returns the number of values one pose's result takes in the arrays of
+     * {@link #processFrames(double[], int, double[], int[], int)}.
+     * @param capacity The largest number of targets per pose.
+     * @return The number of values.
+     */
+    public static int resultStride(int capacity) {
+        return 1 + PhotonResultBuffer.COLUMNS * capacity;
+    }
+
+    /**
+     * Creates a native simulated vision system. The parameters are those of
+     * {@link SimVisionSystem#SimVisionSystem}.
+     * @throws IllegalStateException If the native simulator is not available.
+     */
+    public NativeSimVisionSystem(String camName, double camDiagFOVDegrees, double camPitchDegrees, Transform2d cameraToRobot, double cameraHeightOffGroundMeters, double maxLEDRangeMeters, int cameraResWidth, int cameraResHeight, double minTargetArea){
+        if (!isAvailable()) {
+            throw new IllegalStateException("The PhotonDriver native library is not available");
+        }
+        handle = PhotonJNI.simCreate(camName, camDiagFOVDegrees, camPitchDegrees,
+            cameraToRobot.getTranslation().getX(), cameraToRobot.getTranslation().getY(),
+            cameraToRobot.getRotation().getDegrees(), cameraHeightOffGroundMeters,
+            maxLEDRangeMeters, cameraResWidth, cameraResHeight, minTargetArea);
+    }
+
+    /**
+     * Add a target on the field which your vision system is designed to detect.
+     * @param tgt The target.
+     * @throws IllegalArgumentException If the target has a non-finite value or a non-positive size.
+     */
+    public void addSimVisionTarget(SimVisionTarget tgt){
+        addSimVisionTargets(List.of(tgt));
+    }
+
+    /**
+     * Add many targets in a single native call.
+     * @param tgts The targets.
+     * @throws IllegalArgumentException If any target has a non-finite value or a non-positive size. The other targets are still added.
+     * @throws IllegalStateException If this has been closed.
+     */
+    public void addSimVisionTargets(List<SimVisionTarget> tgts){
+        double[] packed = new double[tgts.size() * TARGET_SIZE];
+        for (int i = 0; i < tgts.size(); i++) {
+            var tgt = tgts.get(i);
+            int offset = i * TARGET_SIZE;
+            packed[offset] = tgt.targetPos.getTranslation().getX();
+            packed[offset + 1] = tgt.targetPos.getTranslation().getY();
+            packed[offset + 2] = tgt.targetPos.getRotation().getRadians();
+            packed[offset + 3] = tgt.targetHeightAboveGroundMeters;
+            packed[offset + 4] = tgt.targetWidthMeters;
+            packed[offset + 5] = tgt.targetHeightMeters;
+        }
+        checkOpen();
+        if (!PhotonJNI.simAddTargets(handle, packed, tgts.size())) {
+            throw new IllegalArgumentException("Targets must have finite values and a positive size");
+        }
+    }
+
+    /**
+     * Adjust the camera position relative to the robot.
+     * @param newCameraToRobot New Tranform from the robot to the camera
+     * @param newCamHeightMeters New height of the camera off the floor
+     * @param newCamPitchDegrees New pitch of the camera axis back from horizontal
+     * @throws IllegalStateException If this has been closed.
+     */
+    public void moveCamera(Transform2d newCameraToRobot, double newCamHeightMeters, double newCamPitchDegrees){
+        checkOpen();
+        PhotonJNI.simMoveCamera(handle, newCameraToRobot.getTranslation().getX(),
+            newCameraToRobot.getTranslation().getY(),
+            newCameraToRobot.getRotation().getDegrees(), newCamHeightMeters,
+            newCamPitchDegrees);
+    }
+
+    /**
+     * Simulates the camera at many robot poses, writing the results into
+     * caller-owned arrays. Nothing is allocated, so this is the call to use
+     * for large sweeps.
+     * @param poses Three values per pose: x and y in meters, then the rotation in degrees.
+     * @param count The number of poses.
+     * @param results Filled with the result of pose i at offset i * resultStride(capacity), laid out as in {@link PhotonResultBuffer}.
+     * @param targetCounts Filled with the number of targets seen at each pose, which may be more than capacity.
+     * @param capacity The largest number of targets to write per pose.
+     * @return False if an array is too short.
+     * @throws IllegalStateException If this has been closed.
+     */
+    public boolean processFrames(double[] poses, int count, double[] results, int[] targetCounts, int capacity){
+        checkOpen();
+        return PhotonJNI.simProcessFrames(handle, poses, count, results, targetCounts, capacity);
+    }
+
+    /**
+     * Simulates the camera at many robot poses.
+     * @param robotPosesMeters The robot poses.
+     * @return The result at each pose.
+     */
+    public List<PhotonPipelineResult> processFrames(List<Pose2d> robotPosesMeters){
+        int count = robotPosesMeters.size();
+        if (poseData.length < count * POSE_SIZE) {
+            poseData = new double[count * POSE_SIZE];
+            targetCounts = new int[count];
+        }
+        for (int i = 0; i < count; i++) {
+            var pose = robotPosesMeters.get(i);
+            poseData[i * POSE_SIZE] = pose.getTranslation().getX();
+            poseData[i * POSE_SIZE + 1] = pose.getTranslation().getY();
+            poseData[i * POSE_SIZE + 2] = pose.getRotation().getDegrees();
+        }
+
+        // Start with room for a few targets per pose. If some pose saw more,
+        // copy the batch out again with more room rather than simulating it
+        // again.
+        int capacity = 4;
+        if (resultData.length < count * resultStride(capacity)) {
+            resultData = new double[count * resultStride(capacity)];
+        }
+        if (!processFrames(poseData, count, resultData, targetCounts, capacity)) {
+            throw new IllegalStateException("The native simulator failed to process the poses");
+        }
+        int most = 0;
+        for (int i = 0; i < count; i++) most = Math.max(most, targetCounts[i]);
+        if (most > capacity) {
+            capacity = most;
+            if (resultData.length < count * resultStride(capacity)) {
+                resultData = new double[count * resultStride(capacity)];
+            }
+            if (!PhotonJNI.simCopyResults(handle, count, resultData, targetCounts, capacity)) {
+                throw new IllegalStateException("The native simulator failed to copy the results");
+            }
+        }
+
+        var results = new ArrayList<PhotonPipelineResult>(count);
+        int stride = resultStride(capacity);
+        for (int i = 0; i < count; i++) {
+            int offset = i * stride;
+            var targets = new ArrayList<PhotonTrackedTarget>(targetCounts[i]);
+            for (int t = 0; t < targetCounts[i]; t++) {
+                targets.add(new PhotonTrackedTarget(
+                    resultData[offset + 1 + PhotonResultBuffer.YAW * capacity + t],
+                    resultData[offset + 1 + PhotonResultBuffer.PITCH * capacity + t],
+                    resultData[offset + 1 + PhotonResultBuffer.AREA * capacity + t],
+                    resultData[offset + 1 + PhotonResultBuffer.SKEW * capacity + t],
+                    new Transform2d(new Translation2d(
+                        resultData[offset + 1 + PhotonResultBuffer.X * capacity + t],
+                        resultData[offset + 1 + PhotonResultBuffer.Y * capacity + t]),
+                        Rotation2d.fromDegrees(
+                            resultData[offset + 1 + PhotonResultBuffer.ROTATION * capacity + t]))));
+            }
+            results.add(new PhotonPipelineResult(resultData[offset], targets));
+        }
+        return results;
+    }
+
+    private void checkOpen() {
+        if (handle == 0) {
+            throw new IllegalStateException("The native simulator has been closed");
+        }
+    }
+
+    @Override
+    public void close(){
+        if (handle != 0) {
+            PhotonJNI.simDestroy(handle);
+            handle = 0;
+        }
+    }
+}
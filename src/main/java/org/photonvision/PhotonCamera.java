@@ -25,6 +25,8 @@ import edu.wpi.first.networktables.NetworkTableInstance;
  * Represents a camera that is connected to PhotonVision.
  */
 public class PhotonCamera {
+  private static final byte[] EMPTY_BYTES = new byte[0];
+
   final NetworkTableEntry rawBytesEntry;
   final NetworkTableEntry driverModeEntry;
   final NetworkTableEntry inputSaveImgEntry;
@@ -90,6 +92,18 @@ public class PhotonCamera {
     return ret;
   }
 
+  /**
+   * Decodes the latest pipeline result into a buffer. Unlike
+   * {@link #getLatestResult()}, no per-target objects are created.
+   *
+   * @param buffer The buffer to decode into.
+   * @return Whether there was a well-formed result. If not, the buffer is
+   *     left empty.
+   */
+  public boolean getLatestResult(PhotonResultBuffer buffer) {
+    return buffer.decode(rawBytesEntry.getRaw(EMPTY_BYTES));
+  }
+
   /**
    * Returns whether the camera is in driver mode.
    * @return Whether the camera is in driver mode.
@@ -0,0 +1,168 @@
+/**
+ * Copyright (C) 2020-2021 Photon Vision.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+package org.photonvision;
+
+import edu.wpi.first.wpiutil.RuntimeLoader;
+
+import java.io.IOException;
+import java.nio.ByteBuffer;
+
+/**
+ * Native entry points of the PhotonDriver library. If the library can't be
+ * loaded, {@link #isLoaded()} returns false and callers fall back to Java.
+ */
+public final class PhotonJNI {
+  private static boolean loaded;
+
+  static {
+    try {
+      var loader = new RuntimeLoader<>("PhotonDriver",
+          RuntimeLoader.getDefaultExtractionRoot(), PhotonJNI.class);
+      loader.loadLibrary();
+      loaded = true;
+    } catch (IOException | UnsatisfiedLinkError ex) {
+      loaded = false;
+    }
+  }
+
+  private PhotonJNI() {
+  }
+
+  /**
+   * Returns whether the native library was loaded.
+   *
+   * @return Whether the native library was loaded.
+   */
+  public static boolean isLoaded() {
+    return loaded;
+  }
+
+  /**
+   * Decodes a pipeline result packet into columns, as laid out by
+   * {@link PhotonResultBuffer}.
+   *
+   * @param input    A direct buffer holding the packet.
+   * @param length   The length of the packet in bytes.
+   * @param output   Filled with the result; must hold 1 + 7 * capacity values.
+   * @param capacity The largest number of targets to write.
+   * @return The number of targets in the packet, or -1 if it is malformed.
+   */
+  public static native int decodeResult(ByteBuffer input, int length,
+                                        double[] output, int capacity);
+
+  /**
+   * Like {@link #decodeResult(ByteBuffer, int, double[], int)}, but decodes
+   * into a direct buffer of doubles in native byte order.
+   *
+   * @param input    A direct buffer holding the packet.
+   * @param length   The length of the packet in bytes.
+   * @param output   A direct buffer of at least 8 * (1 + 7 * capacity) bytes.
+   * @param capacity The largest number of targets to write.
+   * @return The number of targets in the packet, or -1 if it is malformed.
+   */
+  public static native int decodeResultDirect(ByteBuffer input, int length,
+                                              ByteBuffer output, int capacity);
+
+  /**
+   * Creates a native SimVisionSystem. The parameters are those of the
+   * {@link SimVisionSystem} constructor, with the camera transform split into
+   * its translation in meters and rotation in degrees.
+   *
+   * @return A handle to pass to the other sim methods.
+   */
+  public static native long simCreate(String camName, double camDiagFOVDegrees,
+                                      double camPitchDegrees,
+                                      double cameraToRobotX,
+                                      double cameraToRobotY,
+                                      double cameraToRobotDegrees,
+                                      double cameraHeightOffGroundMeters,
+                                      double maxLEDRangeMeters,
+                                      int cameraResWidth, int cameraResHeight,
+                                      double minTargetArea);
+
+  /**
+   * Destroys a native SimVisionSystem.
+   *
+   * @param handle The handle from {@link #simCreate}.
+   */
+  public static native void simDestroy(long handle);
+
+  /**
+   * Moves the camera of a native SimVisionSystem.
+   *
+   * @param handle The handle from {@link #simCreate}.
+   */
+  public static native void simMoveCamera(long handle, double cameraToRobotX,
+                                          double cameraToRobotY,
+                                          double cameraToRobotDegrees,
+                                          double cameraHeightOffGroundMeters,
+                                          double camPitchDegrees);
+
+  /**
+   * Adds targets to a native SimVisionSystem in one call.
+   *
+   * @param handle  The handle from {@link #simCreate}.
+   * @param targets Six values per target: x and y in meters, the rotation in
+   *                radians, then the height above the ground, width and
+   *                height in meters.
+   * @param count   The number of targets.
+   * @return False if the array is too short, or if any target had a
+   *     non-finite value or a non-positive size. Such targets are skipped.
+   */
+  public static native boolean simAddTargets(long handle, double[] targets,
+                                             int count);
+
+  /**
+   * Simulates a native SimVisionSystem at many robot poses in one call.
+   *
+   * @param handle       The handle from {@link #simCreate}.
+   * @param poses        Three values per pose: x and y in meters, then the
+   *                     rotation in degrees.
+   * @param count        The number of poses.
+   * @param results      Filled with one result per pose, each laid out as in
+   *                     {@link PhotonResultBuffer} and 1 + 7 * capacity
+   *                     values long.
+   * @param targetCounts Filled with the number of targets seen at each pose,
+   *                     which may be more than capacity.
+   * @param capacity     The largest number of targets to write per pose.
+   * @return False if an array is too short.
+   */
+  public static native boolean simProcessFrames(long handle, double[] poses,
+                                                int count, double[] results,
+                                                int[] targetCounts,
+                                                int capacity);
+
+  /**
+   * Copies the results of the last {@link #simProcessFrames} call again,
+   * without simulating, e.g. with a larger capacity after some pose saw more
+   * targets than fit.
+   *
+   * @param handle       The handle from {@link #simCreate}.
+   * @param count        The number of results to copy, at most the number of
+   *                     poses in the last batch.
+   * @param results      As in {@link #simProcessFrames}.
+   * @param targetCounts As in {@link #simProcessFrames}.
+   * @param capacity     The largest number of targets to write per pose.
+   * @return False if an array is too short, or count is more than the last
+   *     batch had.
+   */
+  public static native boolean simCopyResults(long handle, int count,
+                                              double[] results,
+                                              int[] targetCounts,
+                                              int capacity);
+}
@@ -0,0 +1,224 @@
+/**
+ * Copyright (C) 2020-2021 Photon Vision.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+package org.photonvision;
+
+import edu.wpi.first.wpilibj.geometry.Rotation2d;
+import edu.wpi.first.wpilibj.geometry.Transform2d;
+import edu.wpi.first.wpilibj.geometry.Translation2d;
+
+import java.nio.ByteBuffer;
+
+/**
+ * Holds a pipeline result as columns of doubles, one column per target field,
+ * and decodes packets into it in place. Unlike
+ * {@link PhotonCamera#getLatestResult()}, decoding allocates nothing once the
+ * buffer is large enough, which keeps the garbage collector quiet in tight
+ * robot loops. The native PhotonDriver library is used when it is available.
+ *
+ * <p>The data is laid out as the latency in milliseconds, then
+ * {@link #getCapacity()} yaws, then as many pitches, and so on in column order.
+ */
+public class PhotonResultBuffer {
+  public static final int YAW = 0;
+  public static final int PITCH = 1;
+  public static final int AREA = 2;
+  public static final int SKEW = 3;
+  public static final int X = 4;
+  public static final int Y = 5;
+  public static final int ROTATION = 6;
+  public static final int COLUMNS = 7;
+
+  // The latency, the has-targets flag and the target count.
+  private static final int HEADER_SIZE = Double.BYTES + 2;
+
+  private double[] data;
+  private int capacity;
+  private int targetCount;
+  private ByteBuffer input = ByteBuffer.allocateDirect(256);
+
+  /**
+   * Constructs an empty buffer with room for 8 targets.
+   */
+  public PhotonResultBuffer() {
+    this(8);
+  }
+
+  /**
+   * Constructs an empty buffer.
+   *
+   * @param capacity The number of targets to make room for. The buffer grows
+   *                 if a result holds more.
+   */
+  public PhotonResultBuffer(int capacity) {
+    this.capacity = Math.max(capacity, 1);
+    data = new double[1 + COLUMNS * this.capacity];
+  }
+
+  /**
+   * Decodes a pipeline result packet, replacing the buffer's contents.
+   *
+   * @param packet The packet data.
+   * @return Whether the packet was well formed. If not, the buffer is left
+   *     empty.
+   */
+  public boolean decode(byte[] packet) {
+    return decode(packet, packet.length);
+  }
+
+  /**
+   * Decodes the first length bytes of a packet, replacing the buffer's
+   * contents.
+   *
+   * @param packet The packet data.
+   * @param length The length of the packet.
+   * @return Whether the packet was well formed. If not, the buffer is left
+   *     empty.
+   */
+  public boolean decode(byte[] packet, int length) {
+    if (input.capacity() < length) {
+      input = ByteBuffer.allocateDirect(Math.max(length, 2 * input.capacity()));
+    }
+    input.clear();
+    input.put(packet, 0, length);
+
+    int count = decodeInput(length);
+    if (count > capacity) {
+      capacity = Math.max(count, 2 * capacity);
+      data = new double[1 + COLUMNS * capacity];
+      count = decodeInput(length);
+    }
+    if (count < 0) {
+      data[0] = 0;
+      targetCount = 0;
+      return false;
+    }
+    targetCount = count;
+    return true;
+  }
+
+  private int decodeInput(int length) {
+    if (length > 0 && PhotonJNI.isLoaded()) {
+      return PhotonJNI.decodeResult(input, length, data, capacity);
+    }
+
+    // Same as the native decoder. The input buffer is big-endian, as Packet
+    // writes doubles.
+    if (length < HEADER_SIZE) return -1;
+    int count = input.get(HEADER_SIZE - 1);
+    if (count < 0 || length < HEADER_SIZE + count * COLUMNS * Double.BYTES) {
+      return -1;
+    }
+    data[0] = input.getDouble(0);
+    int written = Math.min(count, capacity);
+    for (int i = 0; i < written; i++) {
+      int offset = HEADER_SIZE + i * COLUMNS * Double.BYTES;
+      for (int column = 0; column < COLUMNS; column++) {
+        data[1 + column * capacity + i] =
+            input.getDouble(offset + column * Double.BYTES);
+      }
+    }
+    return count;
+  }
+
+  /**
+   * Returns the latency in the pipeline.
+   *
+   * @return The latency in milliseconds.
+   */
+  public double getLatencyMillis() {
+    return data[0];
+  }
+
+  /**
+   * Returns whether the pipeline has targets.
+   *
+   * @return Whether the pipeline has targets.
+   */
+  public boolean hasTargets() {
+    return targetCount > 0;
+  }
+
+  /**
+   * Returns the number of targets.
+   *
+   * @return The number of targets.
+   */
+  public int getTargetCount() {
+    return targetCount;
+  }
+
+  /**
+   * Returns a field of a target.
+   *
+   * @param column The field, e.g. {@link #YAW}.
+   * @param target The index of the target.
+   * @return The field.
+   */
+  public double get(int column, int target) {
+    return data[1 + column * capacity + target];
+  }
+
+  public double getYaw(int target) {
+    return get(YAW, target);
+  }
+
+  public double getPitch(int target) {
+    return get(PITCH, target);
+  }
+
+  public double getArea(int target) {
+    return get(AREA, target);
+  }
+
+  public double getSkew(int target) {
+    return get(SKEW, target);
+  }
+
+  /**
+   * Returns a target as a PhotonTrackedTarget. This allocates, so prefer the
+   * per-field getters in loops.
+   *
+   * @param target The index of the target.
+   * @return The target.
+   */
+  public PhotonTrackedTarget getTarget(int target) {
+    return new PhotonTrackedTarget(getYaw(target), getPitch(target),
+        getArea(target), getSkew(target),
+        new Transform2d(new Translation2d(get(X, target), get(Y, target)),
+            Rotation2d.fromDegrees(get(ROTATION, target))));
+  }
+
+  /**
+   * Returns the number of targets there is room for without growing.
+   *
+   * @return The capacity.
+   */
+  public int getCapacity() {
+    return capacity;
+  }
+
+  /**
+   * Returns the underlying array, laid out as described above. It is
+   * replaced when the buffer grows.
+   *
+   * @return The array.
+   */
+  public double[] getData() {
+    return data;
+  }
+}
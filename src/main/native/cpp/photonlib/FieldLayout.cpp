@@ -0,0 +1,135 @@
+/**
+ * Copyright (C) 2020-2021 Photon Vision.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "photonlib/FieldLayout.h"
+
+#include <algorithm>
+#include <fstream>
+#include <limits>
+#include <sstream>
+
+#include <frc/DriverStation.h>
+#include <units/angle.h>
+#include <wpi/json.h>
+
+namespace photonlib {
+
+FieldLayout::FieldLayout(wpi::ArrayRef<FieldTarget> targets)
+    : targets(targets.begin(), targets.end()) {
+  tree.reserve(this->targets.size());
+  for (size_t i = 0; i < this->targets.size(); ++i) {
+    auto& translation = this->targets[i].pose.Translation();
+    tree.push_back({translation.X().to<double>(),
+                    translation.Y().to<double>(), static_cast<int>(i)});
+  }
+  Build(0, tree.size(), 0);
+}
+
+FieldLayout FieldLayout::FromJson(wpi::StringRef json) {
+  std::vector<FieldTarget> targets;
+  try {
+    auto layout = wpi::json::parse(json);
+    for (auto& tgt : layout.at("targets")) {
+      targets.push_back(
+          {frc::Pose2d(units::meter_t(tgt.at("x").get<double>()),
+                       units::meter_t(tgt.at("y").get<double>()),
+                       units::degree_t(tgt.at("rotation").get<double>())),
+           units::meter_t(tgt.at("heightAboveGround").get<double>()),
+           units::meter_t(tgt.at("width").get<double>()),
+           units::meter_t(tgt.at("height").get<double>())});
+    }
+  } catch (const wpi::json::exception& e) {
+    frc::DriverStation::ReportError(
+        std::string("Could not parse field layout: ") + e.what());
+    return FieldLayout();
+  }
+  return FieldLayout(targets);
+}
+
+FieldLayout FieldLayout::LoadJson(const std::string& path) {
+  std::ifstream file(path);
+  if (!file) {
+    frc::DriverStation::ReportError("Could not open field layout " + path);
+    return FieldLayout();
+  }
+  std::stringstream contents;
+  contents << file.rdbuf();
+  return FromJson(contents.str());
+}
+
+void FieldLayout::Build(size_t lo, size_t hi, int depth) {
+  if (hi - lo <= 1) return;
+  size_t mid = lo + (hi - lo) / 2;
+  bool splitX = depth % 2 == 0;
+  std::nth_element(tree.begin() + lo, tree.begin() + mid, tree.begin() + hi,
+                   [splitX](const KdNode& a, const KdNode& b) {
+                     return splitX ? a.x < b.x : a.y < b.y;
+                   });
+  Build(lo, mid, depth + 1);
+  Build(mid + 1, hi, depth + 1);
+}
+
+void FieldLayout::Search(size_t lo, size_t hi, int depth, double x, double y,
+                         int& best, double& bestDist2) const {
+  if (lo >= hi) return;
+  size_t mid = lo + (hi - lo) / 2;
+  const KdNode& node = tree[mid];
+
+  double dx = node.x - x;
+  double dy = node.y - y;
+  double dist2 = dx * dx + dy * dy;
+  if (dist2 < bestDist2) {
+    bestDist2 = dist2;
+    best = node.index;
+  }
+
+  // Descend into the side containing the query first, then visit the other
+  // side only if the splitting plane is closer than the best match so far.
+  double delta = depth % 2 == 0 ? x - node.x : y - node.y;
+  if (delta < 0) {
+    Search(lo, mid, depth + 1, x, y, best, bestDist2);
+    if (delta * delta < bestDist2) {
+      Search(mid + 1, hi, depth + 1, x, y, best, bestDist2);
+    }
+  } else {
+    Search(mid + 1, hi, depth + 1, x, y, best, bestDist2);
+    if (delta * delta < bestDist2) {
+      Search(lo, mid, depth + 1, x, y, best, bestDist2);
+    }
+  }
+}
+
+int FieldLayout::FindNearest(const frc::Translation2d& point,
+                             units::meter_t maxDistance) const {
+  int best = -1;
+  double bestDist2 = maxDistance.to<double>() * maxDistance.to<double>();
+  Search(0, tree.size(), 0, point.X().to<double>(), point.Y().to<double>(),
+         best, bestDist2);
+  return best;
+}
+
+int FieldLayout::Associate(const frc::Pose2d& robotPose,
+                           const frc::Transform2d& cameraToRobot,
+                           const frc::Translation2d& cameraToTarget,
+                           units::meter_t maxDistance) const {
+  frc::Pose2d cameraPose = robotPose.TransformBy(cameraToRobot.Inverse());
+  frc::Translation2d predicted =
+      cameraPose.Translation() + cameraToTarget.RotateBy(cameraPose.Rotation());
+  return FindNearest(predicted, maxDistance);
+}
+
+}  // namespace photonlib
@@ -0,0 +1,519 @@
+/**
+ * Copyright (C) 2020-2021 Photon Vision.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "photonlib/PhotonArchive.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include <frc/DriverStation.h>
+#include <frc/geometry/Transform2d.h>
+#include <units/angle.h>
+#include <units/length.h>
+#include <wpi/MathExtras.h>
+
+namespace photonlib {
+
+namespace {
+// "PVAR" as a little endian uint32.
+constexpr uint32_t kMagic = 0x52415650;
+constexpr uint32_t kVersion = 1;
+constexpr size_t kFileHeaderSize = 2 * sizeof(uint32_t);
+constexpr size_t kBlockHeaderSize =
+    (2 + PhotonArchive::kColumnCount) * sizeof(uint32_t);
+constexpr double kMicrosPerSecond = 1e6;
+
+void PutUint32(uint32_t value, std::vector<uint8_t>& out) {
+  for (int i = 0; i < 4; ++i) out.push_back(value >> (8 * i));
+}
+
+uint32_t GetUint32(const uint8_t* data) {
+  uint32_t value = 0;
+  for (int i = 0; i < 4; ++i) value |= static_cast<uint32_t>(data[i]) << 8 * i;
+  return value;
+}
+
+uint64_t ZigZag(int64_t value) {
+  return (static_cast<uint64_t>(value) << 1) ^
+         static_cast<uint64_t>(value >> 63);
+}
+
+int64_t UnZigZag(uint64_t value) {
+  return static_cast<int64_t>((value >> 1) ^ (~(value & 1) + 1));
+}
+
+void PutVarint(uint64_t value, std::vector<uint8_t>& out) {
+  while (value >= 0x80) {
+    out.push_back(static_cast<uint8_t>(value) | 0x80);
+    value >>= 7;
+  }
+  out.push_back(static_cast<uint8_t>(value));
+}
+
+bool GetVarint(const uint8_t*& data, const uint8_t* end, uint64_t& value) {
+  value = 0;
+  for (int shift = 0; shift < 64 && data != end; shift += 7) {
+    uint8_t byte = *data++;
+    value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+    if (!(byte & 0x80)) return true;
+  }
+  return false;
+}
+
+// Writes bits most significant first.
+class BitWriter {
+ public:
+  explicit BitWriter(std::vector<uint8_t>& out) : out(out) {}
+
+  void Write(uint64_t value, int count) {
+    while (count > 0) {
+      int n = std::min(8 - used, count);
+      auto chunk =
+          static_cast<uint8_t>((value >> (count - n)) & ((1 << n) - 1));
+      current |= chunk << (8 - used - n);
+      used += n;
+      count -= n;
+      if (used == 8) {
+        out.push_back(current);
+        current = 0;
+        used = 0;
+      }
+    }
+  }
+
+  void Finish() {
+    if (used > 0) out.push_back(current);
+  }
+
+ private:
+  std::vector<uint8_t>& out;
+  uint8_t current = 0;
+  int used = 0;
+};
+
+class BitReader {
+ public:
+  BitReader(const uint8_t* data, size_t size) : data(data), size(size) {}
+
+  bool Read(int count, uint64_t& value) {
+    if (count > 0 && static_cast<uint64_t>(count) > size * 8 - pos) {
+      return false;
+    }
+    value = 0;
+    while (count > 0) {
+      int used = pos % 8;
+      int n = std::min(8 - used, count);
+      uint8_t byte = data[pos / 8];
+      value = (value << n) | ((byte >> (8 - used - n)) & ((1 << n) - 1));
+      pos += n;
+      count -= n;
+    }
+    return true;
+  }
+
+ private:
+  const uint8_t* data;
+  size_t size;
+  uint64_t pos = 0;
+};
+
+uint64_t ToBits(double value) {
+  uint64_t bits;
+  std::memcpy(&bits, &value, sizeof(bits));
+  return bits;
+}
+
+double FromBits(uint64_t bits) {
+  double value;
+  std::memcpy(&value, &bits, sizeof(value));
+  return value;
+}
+
+// Gorilla-style XOR compression. Each value after the first is XORed with
+// the one before; a zero XOR takes one bit, and otherwise only its
+// meaningful bits are kept, reusing the previous window of leading and
+// trailing zeros when they fit in it.
+void EncodeDoubles(const std::vector<double>& values,
+                   std::vector<uint8_t>& out) {
+  BitWriter writer(out);
+  uint64_t previous = 0;
+  int windowLeading = -1;
+  int windowTrailing = 0;
+  for (size_t i = 0; i < values.size(); ++i) {
+    uint64_t bits = ToBits(values[i]);
+    if (i == 0) {
+      writer.Write(bits, 64);
+      previous = bits;
+      continue;
+    }
+    uint64_t x = bits ^ previous;
+    previous = bits;
+    if (x == 0) {
+      writer.Write(0, 1);
+      continue;
+    }
+    int leading = std::min<int>(wpi::countLeadingZeros(x), 31);
+    int trailing = wpi::countTrailingZeros(x);
+    if (windowLeading >= 0 && leading >= windowLeading &&
+        trailing >= windowTrailing) {
+      writer.Write(0b10, 2);
+      writer.Write(x >> windowTrailing, 64 - windowLeading - windowTrailing);
+    } else {
+      int length = 64 - leading - trailing;
+      writer.Write(0b11, 2);
+      writer.Write(leading, 5);
+      // A length of 64 doesn't fit in 6 bits, and is written as 0.
+      writer.Write(length & 63, 6);
+      writer.Write(x >> trailing, length);
+      windowLeading = leading;
+      windowTrailing = trailing;
+    }
+  }
+  writer.Finish();
+}
+
+bool DecodeDoubles(const uint8_t* data, size_t size, size_t count,
+                   std::vector<double>& values) {
+  values.resize(count);
+  BitReader reader(data, size);
+  uint64_t previous = 0;
+  int windowLeading = -1;
+  int windowTrailing = 0;
+  for (size_t i = 0; i < count; ++i) {
+    if (i == 0) {
+      if (!reader.Read(64, previous)) return false;
+      values[i] = FromBits(previous);
+      continue;
+    }
+    uint64_t flag;
+    if (!reader.Read(1, flag)) return false;
+    if (flag) {
+      uint64_t newWindow;
+      if (!reader.Read(1, newWindow)) return false;
+      if (newWindow) {
+        uint64_t leading;
+        uint64_t length;
+        if (!reader.Read(5, leading) || !reader.Read(6, length)) return false;
+        if (length == 0) length = 64;
+        if (leading + length > 64) return false;
+        windowLeading = leading;
+        windowTrailing = 64 - leading - length;
+      } else if (windowLeading < 0) {
+        return false;
+      }
+      uint64_t meaningful;
+      if (!reader.Read(64 - windowLeading - windowTrailing, meaningful)) {
+        return false;
+      }
+      previous ^= meaningful << windowTrailing;
+    }
+    values[i] = FromBits(previous);
+  }
+  return true;
+}
+
+int64_t ToMicros(units::second_t time) {
+  return std::llround(time.to<double>() * kMicrosPerSecond);
+}
+}  // namespace
+
+PhotonArchiveWriter::PhotonArchiveWriter(const std::string& path,
+                                         size_t framesPerBlock)
+    : file(path, std::ios::binary | std::ios::trunc),
+      framesPerBlock(std::max<size_t>(framesPerBlock, 1)) {
+  if (!file) {
+    frc::DriverStation::ReportError("Could not create archive " + path);
+    return;
+  }
+  std::vector<uint8_t> header;
+  PutUint32(kMagic, header);
+  PutUint32(kVersion, header);
+  file.write(reinterpret_cast<const char*>(header.data()), header.size());
+}
+
+PhotonArchiveWriter::~PhotonArchiveWriter() { Close(); }
+
+bool PhotonArchiveWriter::Append(units::second_t time,
+                                 const PhotonPipelineResult& result) {
+  if (!IsOpen()) return false;
+
+  times.push_back(ToMicros(time));
+  latencies.push_back(ToMicros(result.GetLatency()));
+  auto resultTargets = result.GetTargets();
+  targetCounts.push_back(resultTargets.size());
+  for (const auto& target : resultTargets) {
+    auto pose = target.GetCameraRelativePose();
+    targets[PhotonResultColumns::kYaw].push_back(target.GetYaw());
+    targets[PhotonResultColumns::kPitch].push_back(target.GetPitch());
+    targets[PhotonResultColumns::kArea].push_back(target.GetArea());
+    targets[PhotonResultColumns::kSkew].push_back(target.GetSkew());
+    targets[PhotonResultColumns::kX].push_back(
+        pose.Translation().X().to<double>());
+    targets[PhotonResultColumns::kY].push_back(
+        pose.Translation().Y().to<double>());
+    targets[PhotonResultColumns::kRotation].push_back(
+        pose.Rotation().Degrees().to<double>());
+  }
+
+  if (times.size() >= framesPerBlock) return WriteBlock();
+  return true;
+}
+
+bool PhotonArchiveWriter::Close() {
+  if (!file.is_open()) return false;
+  bool ok = WriteBlock();
+  file.close();
+  return ok && !file.fail();
+}
+
+bool PhotonArchiveWriter::WriteBlock() {
+  if (times.empty()) return IsOpen();
+
+  // Encode the columns one after another, remembering where each ends.
+  encoded.clear();
+  std::array<size_t, PhotonArchive::kColumnCount> ends;
+
+  int64_t previousTime = 0;
+  int64_t previousDelta = 0;
+  for (int64_t time : times) {
+    int64_t delta = time - previousTime;
+    PutVarint(ZigZag(delta - previousDelta), encoded);
+    previousTime = time;
+    previousDelta = delta;
+  }
+  ends[PhotonArchive::kTime] = encoded.size();
+
+  int64_t previousLatency = 0;
+  for (int64_t latency : latencies) {
+    PutVarint(ZigZag(latency - previousLatency), encoded);
+    previousLatency = latency;
+  }
+  ends[PhotonArchive::kLatency] = encoded.size();
+
+  for (uint32_t count : targetCounts) PutVarint(count, encoded);
+  ends[PhotonArchive::kTargetCount] = encoded.size();
+
+  for (int column = 0; column < PhotonResultColumns::kColumnCount; ++column) {
+    EncodeDoubles(targets[column], encoded);
+    ends[PhotonArchive::kYaw + column] = encoded.size();
+  }
+
+  std::vector<uint8_t> header;
+  PutUint32(times.size(), header);
+  PutUint32(targets[0].size(), header);
+  size_t start = 0;
+  for (size_t end : ends) {
+    PutUint32(end - start, header);
+    start = end;
+  }
+  file.write(reinterpret_cast<const char*>(header.data()), header.size());
+  file.write(reinterpret_cast<const char*>(encoded.data()), encoded.size());
+
+  times.clear();
+  latencies.clear();
+  targetCounts.clear();
+  for (auto& column : targets) column.clear();
+  return IsOpen();
+}
+
+PhotonPipelineResult PhotonArchiveBlock::GetResult(size_t frame) const {
+  std::vector<PhotonTrackedTarget> frameTargets;
+  for (size_t i = firstTargets[frame]; i < firstTargets[frame + 1]; ++i) {
+    frameTargets.emplace_back(
+        targets[PhotonResultColumns::kYaw][i],
+        targets[PhotonResultColumns::kPitch][i],
+        targets[PhotonResultColumns::kArea][i],
+        targets[PhotonResultColumns::kSkew][i],
+        frc::Transform2d(
+            frc::Translation2d(
+                units::meter_t(targets[PhotonResultColumns::kX][i]),
+                units::meter_t(targets[PhotonResultColumns::kY][i])),
+            units::degree_t(targets[PhotonResultColumns::kRotation][i])));
+  }
+  return PhotonPipelineResult(units::second_t(latencyMillis[frame] / 1000.0),
+                              frameTargets);
+}
+
+PhotonArchiveReader::PhotonArchiveReader(const std::string& path)
+    : file(path, std::ios::binary) {
+  if (!file) {
+    frc::DriverStation::ReportError("Could not open archive " + path);
+    return;
+  }
+
+  file.seekg(0, std::ios::end);
+  uint64_t fileSize = file.tellg();
+  file.seekg(0);
+
+  // Walk the block headers, checking that the blocks fill the file exactly.
+  uint8_t header[kBlockHeaderSize];
+  bool valid = fileSize >= kFileHeaderSize &&
+               file.read(reinterpret_cast<char*>(header), kFileHeaderSize) &&
+               GetUint32(header) == kMagic &&
+               GetUint32(header + 4) == kVersion;
+  uint64_t offset = kFileHeaderSize;
+  while (valid && offset < fileSize) {
+    valid = fileSize - offset >= kBlockHeaderSize &&
+            file.read(reinterpret_cast<char*>(header), kBlockHeaderSize);
+    if (!valid) break;
+    BlockInfo block;
+    block.frameCount = GetUint32(header);
+    block.targetCount = GetUint32(header + 4);
+    uint64_t payload = 0;
+    for (int column = 0; column < PhotonArchive::kColumnCount; ++column) {
+      block.columnSizes[column] = GetUint32(header + 8 + 4 * column);
+      payload += block.columnSizes[column];
+    }
+    block.offset = offset + kBlockHeaderSize;
+    offset = block.offset + payload;
+    valid = offset <= fileSize && file.seekg(offset);
+
+    // Every frame takes at least a byte in each frame column, and every
+    // target at least a bit in each target column, so the counts can't be
+    // larger than that.
+    for (int column = 0; valid && column < PhotonArchive::kColumnCount;
+         ++column) {
+      uint64_t size = block.columnSizes[column];
+      valid = column < PhotonArchive::kYaw ? block.frameCount <= size
+                                           : block.targetCount <= size * 8;
+    }
+    blocks.push_back(block);
+    frameCount += block.frameCount;
+  }
+
+  if (!valid) {
+    frc::DriverStation::ReportError("Could not parse archive " + path);
+    file.close();
+    blocks.clear();
+    frameCount = 0;
+  }
+}
+
+bool PhotonArchiveReader::ReadBlock(size_t index, uint32_t columns,
+                                    PhotonArchiveBlock& block) {
+  block.times.clear();
+  block.latencyMillis.clear();
+  block.targetCounts.clear();
+  block.firstTargets.clear();
+  for (auto& column : block.targets) column.clear();
+  block.frameCount = 0;
+  if (!IsOpen() || index >= blocks.size()) return false;
+
+  const BlockInfo& info = blocks[index];
+  constexpr uint32_t kTargetColumns =
+      PhotonArchive::kAllColumns &
+      ~(PhotonArchive::Mask(PhotonArchive::kTime) |
+        PhotonArchive::Mask(PhotonArchive::kLatency) |
+        PhotonArchive::Mask(PhotonArchive::kTargetCount));
+  if (columns & kTargetColumns) {
+    columns |= PhotonArchive::Mask(PhotonArchive::kTargetCount);
+  }
+
+  file.clear();
+  uint64_t offset = info.offset;
+  for (int column = 0; column < PhotonArchive::kColumnCount; ++column) {
+    uint32_t size = info.columnSizes[column];
+    uint64_t start = offset;
+    offset += size;
+    if (!(columns & PhotonArchive::Mask(static_cast<PhotonArchive::Column>(
+                        column)))) {
+      continue;
+    }
+
+    columnData.resize(size);
+    if (!file.seekg(start) ||
+        !file.read(reinterpret_cast<char*>(columnData.data()), size)) {
+      return false;
+    }
+    const uint8_t* data = columnData.data();
+    const uint8_t* end = data + size;
+    uint64_t value;
+
+    switch (column) {
+      case PhotonArchive::kTime: {
+        uint64_t time = 0;
+        uint64_t delta = 0;
+        block.times.reserve(info.frameCount);
+        for (uint32_t i = 0; i < info.frameCount; ++i) {
+          if (!GetVarint(data, end, value)) return false;
+          delta += UnZigZag(value);
+          time += delta;
+          block.times.emplace_back(static_cast<int64_t>(time) /
+                                   kMicrosPerSecond);
+        }
+        break;
+      }
+      case PhotonArchive::kLatency: {
+        uint64_t latency = 0;
+        block.latencyMillis.reserve(info.frameCount);
+        for (uint32_t i = 0; i < info.frameCount; ++i) {
+          if (!GetVarint(data, end, value)) return false;
+          latency += UnZigZag(value);
+          block.latencyMillis.push_back(static_cast<int64_t>(latency) /
+                                        1000.0);
+        }
+        break;
+      }
+      case PhotonArchive::kTargetCount: {
+        block.targetCounts.reserve(info.frameCount);
+        block.firstTargets.reserve(info.frameCount + 1);
+        block.firstTargets.push_back(0);
+        for (uint32_t i = 0; i < info.frameCount; ++i) {
+          if (!GetVarint(data, end, value) ||
+              value > info.targetCount - block.firstTargets.back()) {
+            return false;
+          }
+          block.targetCounts.push_back(value);
+          block.firstTargets.push_back(block.firstTargets.back() + value);
+        }
+        if (block.firstTargets.back() != info.targetCount) return false;
+        break;
+      }
+      default:
+        if (!DecodeDoubles(data, size, info.targetCount,
+                           block.targets[column - PhotonArchive::kYaw])) {
+          return false;
+        }
+        data = end;
+        break;
+    }
+    if (data != end) return false;
+  }
+
+  block.frameCount = info.frameCount;
+  return true;
+}
+
+bool PhotonArchiveReader::ReadAll(std::vector<units::second_t>& times,
+                                  std::vector<PhotonPipelineResult>& results) {
+  times.clear();
+  results.clear();
+  times.reserve(frameCount);
+  results.reserve(frameCount);
+  PhotonArchiveBlock block;
+  for (size_t i = 0; i < blocks.size(); ++i) {
+    if (!ReadBlock(i, PhotonArchive::kAllColumns, block)) return false;
+    times.insert(times.end(), block.times.begin(), block.times.end());
+    for (size_t frame = 0; frame < block.Size(); ++frame) {
+      results.push_back(block.GetResult(frame));
+    }
+  }
+  return IsOpen();
+}
+
+}  // namespace photonlib
@@ -18,6 +18,7 @@
 #include "photonlib/PhotonCamera.h"
 
 #include "photonlib/Packet.h"
+#include "photonlib/PhotonTrace.h"
 
 namespace photonlib {
 PhotonCamera::PhotonCamera(std::shared_ptr<nt::NetworkTable> rootTable)
@@ -26,7 +27,8 @@ PhotonCamera::PhotonCamera(std::shared_ptr<nt::NetworkTable> rootTable)
       inputSaveImgEntry(rootTable->GetEntry("inputSaveImgCmd")),
       outputSaveImgEntry(rootTable->GetEntry("outputSaveImgCmd")),
       pipelineIndexEntry(rootTable->GetEntry("pipelineIndex")),
-      ledModeEntry(mainTable->GetEntry("ledMode")) {
+      ledModeEntry(mainTable->GetEntry("ledMode")),
+      directChannel(PhotonResultChannel::Get(rootTable->GetPath())) {
   driverMode = driverModeEntry.GetBoolean(false);
   pipelineIndex = static_cast<int>(pipelineIndexEntry.GetDouble(0.0));
   mode = GetLEDMode();
@@ -38,20 +40,44 @@ PhotonCamera::PhotonCamera(const std::string& cameraName)
                        ->GetSubTable(cameraName)) {}
 
 PhotonPipelineResult PhotonCamera::GetLatestResult() const {
-  // Clear the current packet.
-  packet.Clear();
+  PHOTON_TRACE_SCOPE("PhotonCamera::GetLatestResult");
+  if (auto direct = directChannel->Latest()) {
+    return *direct;
+  }
 
   // Create the new result;
   PhotonPipelineResult result;
+  DecodeLatest(result);
+  return result;
+}
+
+std::shared_ptr<const PhotonPipelineResult> PhotonCamera::GetLatestResultPtr()
+    const {
+  PHOTON_TRACE_SCOPE("PhotonCamera::GetLatestResultPtr");
+  if (auto direct = directChannel->Latest()) {
+    return direct;
+  }
+  auto result = std::make_shared<PhotonPipelineResult>();
+  DecodeLatest(*result);
+  return result;
+}
+
+void PhotonCamera::DecodeLatest(PhotonPipelineResult& result) const {
+  // Clear the current packet.
+  packet.Clear();
 
   // Fill the packet with latest data and populate result.
-  std::string value = rawBytesEntry.GetValue()->GetRaw();
-  std::vector<char> bytes{value.begin(), value.end()};
+  std::vector<char> bytes;
+  {
+    PHOTON_TRACE_SCOPE("PhotonCamera::GetLatestResult fetch");
+    std::string value = rawBytesEntry.GetValue()->GetRaw();
+    bytes.assign(value.begin(), value.end());
+  }
 
+  PHOTON_TRACE_SCOPE("PhotonCamera::GetLatestResult decode");
   photonlib::Packet packet{bytes};
 
   packet >> result;
-  return result;
 }
 
 void PhotonCamera::SetDriverMode(bool driverMode) {
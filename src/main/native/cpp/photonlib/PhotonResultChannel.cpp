@@ -0,0 +1,63 @@
+/**
+ * Copyright (C) 2020-2021 Photon Vision.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "photonlib/PhotonResultChannel.h"
+
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+
+namespace photonlib {
+
+std::shared_ptr<PhotonResultChannel> PhotonResultChannel::Get(
+    wpi::StringRef tablePath) {
+  static std::mutex registryMutex;
+  static std::unordered_map<std::string, std::shared_ptr<PhotonResultChannel>>
+      registry;
+
+  std::lock_guard<std::mutex> lock(registryMutex);
+  auto& channel = registry[tablePath.str()];
+  if (!channel) channel = std::make_shared<PhotonResultChannel>();
+  return channel;
+}
+
+void PhotonResultChannel::Publish(PhotonPipelineResult result,
+                                  std::weak_ptr<const void> publisher) {
+  // One allocation holds both the result and its publisher; readers get a
+  // pointer to the result that shares it.
+  auto publication = std::make_shared<const Publication>(
+      Publication{std::move(result), std::move(publisher)});
+  // The old result is released here, after the exchange.
+  std::atomic_exchange(&latest, std::move(publication));
+  published.store(true, std::memory_order_release);
+}
+
+void PhotonResultChannel::Clear() {
+  std::atomic_exchange(&latest, std::shared_ptr<const Publication>());
+  published.store(false, std::memory_order_release);
+}
+
+std::shared_ptr<const PhotonPipelineResult> PhotonResultChannel::Latest()
+    const {
+  if (!published.load(std::memory_order_acquire)) return nullptr;
+  auto publication = std::atomic_load(&latest);
+  if (!publication || publication->publisher.expired()) return nullptr;
+  return std::shared_ptr<const PhotonPipelineResult>(publication,
+                                                     &publication->result);
+}
+
+}  // namespace photonlib
@@ -0,0 +1,108 @@
+/**
+ * Copyright (C) 2020-2021 Photon Vision.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "photonlib/PhotonResultColumns.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include <wpi/Endian.h>
+
+namespace photonlib {
+
+namespace {
+// The latency, the has-targets flag and the target count.
+constexpr size_t kHeaderSize = sizeof(double) + 2;
+constexpr size_t kTargetSize =
+    PhotonResultColumns::kColumnCount * sizeof(double);
+
+// Reads a double in network byte order, as Packet writes it.
+double ReadDouble(const uint8_t* data) {
+  uint8_t bytes[sizeof(double)];
+  std::memcpy(bytes, data, sizeof(double));
+  if constexpr (wpi::support::endian::system_endianness() ==
+                wpi::support::endianness::little) {
+    std::reverse(bytes, bytes + sizeof(double));
+  }
+  double value;
+  std::memcpy(&value, bytes, sizeof(double));
+  return value;
+}
+
+// Returns the number of targets in a packet, or -1 if it is too short to
+// hold them.
+int ReadCount(wpi::ArrayRef<uint8_t> data) {
+  if (data.size() < kHeaderSize) return -1;
+  auto count = static_cast<int8_t>(data[kHeaderSize - 1]);
+  if (count < 0 || data.size() < kHeaderSize + count * kTargetSize) return -1;
+  return count;
+}
+}  // namespace
+
+int PhotonResultColumns::Decode(wpi::ArrayRef<uint8_t> data, double* out,
+                                size_t capacity) {
+  int count = ReadCount(data);
+  if (count < 0) return -1;
+
+  out[0] = ReadDouble(data.data());
+  size_t written = std::min<size_t>(count, capacity);
+  const uint8_t* target = data.data() + kHeaderSize;
+  for (size_t i = 0; i < written; ++i, target += kTargetSize) {
+    for (int column = 0; column < kColumnCount; ++column) {
+      out[Index(static_cast<Column>(column), i, capacity)] =
+          ReadDouble(target + column * sizeof(double));
+    }
+  }
+  return count;
+}
+
+int PhotonResultColumns::DecodeRows(wpi::ArrayRef<uint8_t> data,
+                                    double* latency, double* rows,
+                                    size_t capacity) {
+  int count = ReadCount(data);
+  if (count < 0) return -1;
+
+  *latency = ReadDouble(data.data());
+  size_t written = std::min<size_t>(count, capacity) * kColumnCount;
+  const uint8_t* value = data.data() + kHeaderSize;
+  for (size_t i = 0; i < written; ++i, value += sizeof(double)) {
+    rows[i] = ReadDouble(value);
+  }
+  return count;
+}
+
+int PhotonResultColumns::Write(const PhotonPipelineResult& result,
+                               double* out, size_t capacity) {
+  auto targets = result.GetTargets();
+  out[0] = result.GetLatency().to<double>() * 1000;
+  size_t written = std::min(targets.size(), capacity);
+  for (size_t i = 0; i < written; ++i) {
+    const auto& target = targets[i];
+    auto pose = target.GetCameraRelativePose();
+    out[Index(kYaw, i, capacity)] = target.GetYaw();
+    out[Index(kPitch, i, capacity)] = target.GetPitch();
+    out[Index(kArea, i, capacity)] = target.GetArea();
+    out[Index(kSkew, i, capacity)] = target.GetSkew();
+    out[Index(kX, i, capacity)] = pose.Translation().X().to<double>();
+    out[Index(kY, i, capacity)] = pose.Translation().Y().to<double>();
+    out[Index(kRotation, i, capacity)] =
+        pose.Rotation().Degrees().to<double>();
+  }
+  return static_cast<int>(targets.size());
+}
+
+}  // namespace photonlib
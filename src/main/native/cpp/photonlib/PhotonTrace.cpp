@@ -0,0 +1,204 @@
+/**
+ * Copyright (C) 2020-2021 Photon Vision.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "photonlib/PhotonTrace.h"
+
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <frc/DriverStation.h>
+
+namespace photonlib {
+
+std::atomic<bool> PhotonTrace::enabledFlag{true};
+
+namespace {
+struct Span {
+  const char* name;
+  int64_t startNs;
+  int64_t durationNs;
+};
+
+// The spans of one thread. Only that thread writes spans, and it publishes
+// each one by bumping count, so readers see only finished spans.
+struct ThreadBuffer {
+  explicit ThreadBuffer(int id)
+      : id(id), spans(new Span[PhotonTrace::kSpansPerThread]) {}
+
+  int id;
+  std::unique_ptr<Span[]> spans;
+  std::atomic<size_t> count{0};
+  std::atomic<size_t> dropped{0};
+};
+
+// Buffers outlive their threads so that spans can be written out after a
+// thread exits. An exited thread's buffer goes on the free list and is taken
+// by the next thread to record a span, keeping its spans, so memory is bounded
+// by the most threads recording at once rather than by every thread ever
+// seen. The lock is only taken when a thread records its first span, when it
+// exits and when spans are read.
+struct Registry {
+  std::mutex mutex;
+  std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+  std::vector<ThreadBuffer*> freeBuffers;
+};
+
+Registry& GetRegistry() {
+  // Never destroyed, so threads still running at exit can keep recording.
+  static Registry* registry = new Registry;
+  return *registry;
+}
+
+thread_local ThreadBuffer* threadBuffer = nullptr;
+thread_local bool threadExited = false;
+
+// Gives the thread's buffer back to the registry when the thread exits.
+struct ThreadBufferOwner {
+  ~ThreadBufferOwner() {
+    threadExited = true;
+    if (!threadBuffer) return;
+    auto& registry = GetRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    registry.freeBuffers.push_back(threadBuffer);
+    threadBuffer = nullptr;
+  }
+};
+
+// Returns null once the thread has given its buffer back, e.g. for spans
+// recorded by other thread_local destructors.
+ThreadBuffer* GetThreadBuffer() {
+  if (threadBuffer || threadExited) return threadBuffer;
+  thread_local ThreadBufferOwner owner;
+  (void)owner;
+  auto& registry = GetRegistry();
+  std::lock_guard<std::mutex> lock(registry.mutex);
+  if (!registry.freeBuffers.empty()) {
+    threadBuffer = registry.freeBuffers.back();
+    registry.freeBuffers.pop_back();
+  } else {
+    registry.buffers.push_back(
+        std::make_unique<ThreadBuffer>(registry.buffers.size() + 1));
+    threadBuffer = registry.buffers.back().get();
+  }
+  return threadBuffer;
+}
+
+int64_t ToNanoseconds(std::chrono::steady_clock::time_point time) {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             time.time_since_epoch())
+      .count();
+}
+
+// Writes a span name as a JSON string.
+void WriteName(std::ofstream& file, const char* name) {
+  file << '"';
+  for (const char* c = name; *c; ++c) {
+    if (*c == '"' || *c == '\\') {
+      file << '\\' << *c;
+    } else if (static_cast<unsigned char>(*c) >= 0x20) {
+      file << *c;
+    }
+  }
+  file << '"';
+}
+}  // namespace
+
+void PhotonTrace::Record(const char* name,
+                         std::chrono::steady_clock::time_point start,
+                         std::chrono::steady_clock::time_point end) {
+  if (!IsEnabled()) return;
+  ThreadBuffer* buffer = GetThreadBuffer();
+  if (!buffer) return;
+  size_t count = buffer->count.load(std::memory_order_relaxed);
+  if (count >= kSpansPerThread) {
+    buffer->dropped.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+  int64_t startNs = ToNanoseconds(start);
+  buffer->spans[count] = {name, startNs, ToNanoseconds(end) - startNs};
+  buffer->count.store(count + 1, std::memory_order_release);
+}
+
+size_t PhotonTrace::GetSpanCount() {
+  auto& registry = GetRegistry();
+  std::lock_guard<std::mutex> lock(registry.mutex);
+  size_t total = 0;
+  for (auto& buffer : registry.buffers) {
+    total += buffer->count.load(std::memory_order_acquire);
+  }
+  return total;
+}
+
+size_t PhotonTrace::GetDroppedCount() {
+  auto& registry = GetRegistry();
+  std::lock_guard<std::mutex> lock(registry.mutex);
+  size_t total = 0;
+  for (auto& buffer : registry.buffers) {
+    total += buffer->dropped.load(std::memory_order_relaxed);
+  }
+  return total;
+}
+
+bool PhotonTrace::WriteChromeJson(const std::string& path) {
+  std::ofstream file(path);
+  if (!file) {
+    frc::DriverStation::ReportError("Could not write trace " + path);
+    return false;
+  }
+
+  // Complete ("X") events, with times in microseconds.
+  file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+  bool first = true;
+  char numbers[96];
+  auto& registry = GetRegistry();
+  std::lock_guard<std::mutex> lock(registry.mutex);
+  for (auto& buffer : registry.buffers) {
+    size_t count = buffer->count.load(std::memory_order_acquire);
+    for (size_t i = 0; i < count; ++i) {
+      const Span& span = buffer->spans[i];
+      file << (first ? "\n" : ",\n") << "{\"name\":";
+      WriteName(file, span.name);
+      std::snprintf(numbers, sizeof(numbers),
+                    ",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,"
+                    "\"tid\":%d}",
+                    span.startNs / 1000.0, span.durationNs / 1000.0,
+                    buffer->id);
+      file << numbers;
+      first = false;
+    }
+  }
+  file << "\n]}\n";
+  if (!file) {
+    frc::DriverStation::ReportError("Could not write trace " + path);
+    return false;
+  }
+  return true;
+}
+
+void PhotonTrace::Clear() {
+  auto& registry = GetRegistry();
+  std::lock_guard<std::mutex> lock(registry.mutex);
+  for (auto& buffer : registry.buffers) {
+    buffer->count.store(0, std::memory_order_relaxed);
+    buffer->dropped.store(0, std::memory_order_relaxed);
+  }
+}
+
+}  // namespace photonlib
@@ -0,0 +1,121 @@
+/**
+ * Copyright (C) 2020-2021 Photon Vision.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "photonlib/PoseFusionEstimator.h"
+
+#include <algorithm>
+
+#include <frc/geometry/Transform2d.h>
+
+#include "photonlib/PoseHistory.h"
+
+namespace photonlib {
+
+PoseFusionEstimator::PoseFusionEstimator(size_t historySize,
+                                         double translationWeight,
+                                         double rotationWeight)
+    : translationWeight(translationWeight),
+      rotationWeight(rotationWeight),
+      samples(std::max<size_t>(historySize, 1)) {}
+
+void PoseFusionEstimator::ResetPose(const frc::Pose2d& pose,
+                                    const frc::Pose2d& odometryPose,
+                                    units::second_t timestamp) {
+  head = 0;
+  count = 1;
+  samples[0] = {timestamp, odometryPose, pose};
+  estimate = pose;
+}
+
+frc::Pose2d PoseFusionEstimator::UpdateOdometry(
+    const frc::Pose2d& odometryPose, units::second_t timestamp) {
+  if (count == 0) {
+    estimate = odometryPose;
+  } else {
+    const Sample& latest = At(count - 1);
+    if (timestamp <= latest.timestamp) return estimate;
+    estimate = latest.fused.TransformBy(
+        frc::Transform2d(latest.odometry, odometryPose));
+  }
+
+  // Overwrite the oldest sample once the buffer is full.
+  if (count == samples.size()) {
+    head = (head + 1) % samples.size();
+    --count;
+  }
+  At(count++) = {timestamp, odometryPose, estimate};
+  return estimate;
+}
+
+size_t PoseFusionEstimator::UpperBound(units::second_t timestamp) const {
+  size_t lo = 0;
+  size_t hi = count;
+  while (lo < hi) {
+    size_t mid = lo + (hi - lo) / 2;
+    if (At(mid).timestamp <= timestamp) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  return lo;
+}
+
+bool PoseFusionEstimator::AddVisionMeasurement(const frc::Pose2d& visionPose,
+                                               units::second_t timestamp) {
+  size_t upper = UpperBound(timestamp);
+  if (upper == 0) return false;
+
+  // Find where odometry and the fused estimate were when the frame was
+  // captured.
+  const Sample& before = At(upper - 1);
+  frc::Pose2d odometryAtCapture = before.odometry;
+  frc::Pose2d fusedAtCapture = before.fused;
+  if (upper < count) {
+    const Sample& after = At(upper);
+    double t = (timestamp - before.timestamp) /
+               (after.timestamp - before.timestamp);
+    odometryAtCapture =
+        PoseHistory::Interpolate(before.odometry, after.odometry, t);
+    fusedAtCapture = PoseHistory::Interpolate(before.fused, after.fused, t);
+  }
+
+  frc::Translation2d translation =
+      fusedAtCapture.Translation() +
+      (visionPose.Translation() - fusedAtCapture.Translation()) *
+          translationWeight;
+  frc::Rotation2d rotation = fusedAtCapture.Rotation().RotateBy(
+      units::radian_t((visionPose.Rotation() - fusedAtCapture.Rotation())
+                          .Radians() *
+                      rotationWeight));
+  frc::Pose2d corrected(translation, rotation);
+
+  // Rewind: re-express every later sample relative to the corrected pose,
+  // keeping the motion odometry measured since the capture time.
+  if (upper == count) {
+    At(count - 1).fused = corrected.TransformBy(
+        frc::Transform2d(odometryAtCapture, At(count - 1).odometry));
+  }
+  for (size_t i = upper; i < count; ++i) {
+    At(i).fused = corrected.TransformBy(
+        frc::Transform2d(odometryAtCapture, At(i).odometry));
+  }
+  estimate = At(count - 1).fused;
+  return true;
+}
+
+}  // namespace photonlib
@@ -0,0 +1,73 @@
+/**
+ * Copyright (C) 2020-2021 Photon Vision.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "photonlib/PoseHistory.h"
+
+#include <algorithm>
+
+#include <frc/geometry/Twist2d.h>
+
+namespace photonlib {
+
+PoseHistory::PoseHistory(size_t capacity)
+    : entries(std::max<size_t>(capacity, 1)) {}
+
+void PoseHistory::AddSample(units::second_t timestamp,
+                            const frc::Pose2d& pose) {
+  if (count > 0 && timestamp <= At(count - 1).timestamp) return;
+
+  if (count == entries.size()) {
+    head = (head + 1) % entries.size();
+    --count;
+  }
+  entries[(head + count) % entries.size()] = {timestamp, pose};
+  ++count;
+}
+
+std::optional<frc::Pose2d> PoseHistory::Sample(
+    units::second_t timestamp) const {
+  if (count == 0 || timestamp < At(0).timestamp) return std::nullopt;
+  if (timestamp >= At(count - 1).timestamp) return At(count - 1).pose;
+
+  // Find the first sample newer than the timestamp. The checks above
+  // guarantee it exists and is not the oldest.
+  size_t lo = 1;
+  size_t hi = count - 1;
+  while (lo < hi) {
+    size_t mid = lo + (hi - lo) / 2;
+    if (At(mid).timestamp <= timestamp) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+
+  const Entry& before = At(lo - 1);
+  const Entry& after = At(lo);
+  return Interpolate(
+      before.pose, after.pose,
+      (timestamp - before.timestamp) / (after.timestamp - before.timestamp));
+}
+
+frc::Pose2d PoseHistory::Interpolate(const frc::Pose2d& start,
+                                     const frc::Pose2d& end, double t) {
+  frc::Twist2d twist = start.Log(end);
+  return start.Exp(
+      frc::Twist2d{twist.dx * t, twist.dy * t, twist.dtheta * t});
+}
+
+}  // namespace photonlib
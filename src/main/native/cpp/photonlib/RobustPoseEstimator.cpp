@@ -0,0 +1,122 @@
+/**
+ * Copyright (C) 2020-2021 Photon Vision.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "photonlib/RobustPoseEstimator.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+#include "photonlib/PhotonUtils.h"
+
+namespace photonlib {
+
+RobustPoseEstimator::RobustPoseEstimator(
+    units::meter_t cameraHeight, units::radian_t cameraPitch,
+    const frc::Transform2d& cameraToRobot, units::meter_t inlierThreshold,
+    int maxIterations, units::second_t timeBudget, double consensusFraction,
+    uint64_t seed)
+    : cameraHeight(cameraHeight),
+      cameraPitch(cameraPitch),
+      cameraToRobot(cameraToRobot),
+      inlierThreshold(inlierThreshold),
+      maxIterations(std::max(maxIterations, 1)),
+      timeBudget(timeBudget),
+      consensusFraction(consensusFraction),
+      rng(seed) {}
+
+void RobustPoseEstimator::Reseed(uint64_t seed) { rng.Seed(seed); }
+
+size_t RobustPoseEstimator::CountInliers(
+    const frc::Pose2d& hypothesis,
+    wpi::SmallVectorImpl<size_t>& inliers) const {
+  inliers.clear();
+  for (size_t i = 0; i < hypotheses.size(); ++i) {
+    if (hypotheses[i].Translation().Distance(hypothesis.Translation()) <
+        inlierThreshold) {
+      inliers.push_back(i);
+    }
+  }
+  return inliers.size();
+}
+
+RobustPoseEstimate RobustPoseEstimator::Estimate(
+    wpi::ArrayRef<PoseObservation> observations,
+    const frc::Rotation2d& gyroAngle) {
+  RobustPoseEstimate estimate;
+  if (observations.empty()) return estimate;
+
+  auto start = std::chrono::steady_clock::now();
+  auto budget = std::chrono::duration<double>(timeBudget.to<double>());
+
+  // Every observation yields a full robot pose given the gyro, so the minimal
+  // sample is a single target.
+  hypotheses.clear();
+  for (auto& obs : observations) {
+    // Photon reports yaw CW-positive; the estimator expects CCW-positive.
+    hypotheses.push_back(PhotonUtils::EstimateFieldToRobot(
+        cameraHeight, obs.targetHeight, cameraPitch,
+        units::degree_t(obs.target.GetPitch()),
+        frc::Rotation2d(units::degree_t(-obs.target.GetYaw())), gyroAngle,
+        obs.fieldToTarget, cameraToRobot));
+  }
+
+  size_t n = hypotheses.size();
+  size_t consensus = static_cast<size_t>(std::ceil(consensusFraction * n));
+  size_t bestCount = 0;
+
+  for (int iter = 0; iter < maxIterations; ++iter) {
+    if (iter > 0 && std::chrono::steady_clock::now() - start > budget) break;
+    estimate.iterations = iter + 1;
+
+    size_t sample = rng.Next() % n;
+    size_t count = CountInliers(hypotheses[sample], candidateInliers);
+    if (count > bestCount) {
+      bestCount = count;
+      estimate.inliers.assign(candidateInliers.begin(),
+                              candidateInliers.end());
+      if (bestCount >= consensus) break;
+    }
+  }
+
+  // Refine by averaging the consensus set. Rotations are averaged on the unit
+  // circle so that poses on either side of +/-180 degrees combine correctly.
+  double x = 0;
+  double y = 0;
+  double cos = 0;
+  double sin = 0;
+  for (auto i : estimate.inliers) {
+    x += hypotheses[i].X().to<double>();
+    y += hypotheses[i].Y().to<double>();
+    cos += hypotheses[i].Rotation().Cos();
+    sin += hypotheses[i].Rotation().Sin();
+  }
+  if (estimate.inliers.empty()) return estimate;
+  double count = static_cast<double>(estimate.inliers.size());
+  estimate.fieldToRobot =
+      frc::Pose2d(units::meter_t(x / count), units::meter_t(y / count),
+                  frc::Rotation2d(cos, sin));
+
+  // Standard RANSAC success probability for a sample size of one.
+  double inlierRatio = count / n;
+  estimate.confidence =
+      1.0 - std::pow(1.0 - inlierRatio, estimate.iterations);
+  estimate.valid = true;
+  return estimate;
+}
+
+}  // namespace photonlib
@@ -0,0 +1,145 @@
+/**
+ * Copyright (C) 2020-2021 Photon Vision.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "photonlib/SimFrameRenderer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace photonlib {
+
+namespace {
+// Fills a row buffer with a repeated pixel.
+void FillRow(std::vector<uint8_t>& row, const uint8_t* pixel,
+             size_t pixelSize) {
+  for (size_t i = 0; i < row.size(); i += pixelSize) {
+    std::memcpy(row.data() + i, pixel, pixelSize);
+  }
+}
+
+uint8_t Luma(const uint8_t (&bgr)[3]) {
+  return static_cast<uint8_t>(
+      std::lround(0.114 * bgr[0] + 0.587 * bgr[1] + 0.299 * bgr[2]));
+}
+}  // namespace
+
+SimFrameRenderer::SimFrameRenderer(int width, int height, Format format)
+    : width(width),
+      height(height),
+      format(format),
+      pixelSize(format == kBGR ? 3 : 1),
+      pixels(static_cast<size_t>(width) * height * pixelSize),
+      backgroundRow(width * pixelSize),
+      targetRow(width * pixelSize) {
+  // The most polygon edges a scanline can cross.
+  crossings.reserve(SimTargetOutline::kMaxPoints);
+  SetColors({0, 0, 0}, {0, 255, 0});
+}
+
+void SimFrameRenderer::SetColors(const uint8_t (&background)[3],
+                                 const uint8_t (&target)[3]) {
+  if (format == kBGR) {
+    FillRow(backgroundRow, background, pixelSize);
+    FillRow(targetRow, target, pixelSize);
+  } else {
+    std::fill(backgroundRow.begin(), backgroundRow.end(), Luma(background));
+    std::fill(targetRow.begin(), targetRow.end(), Luma(target));
+  }
+  Clear();
+}
+
+void SimFrameRenderer::Clear() {
+  // Row copies are vectorized by the C library, for any pixel size.
+  size_t rowSize = backgroundRow.size();
+  for (int y = 0; y < height; ++y) {
+    std::memcpy(pixels.data() + y * rowSize, backgroundRow.data(), rowSize);
+  }
+}
+
+void SimFrameRenderer::FillPolygon(const SimTargetOutline& outline) {
+  if (outline.count < 3) return;
+
+  double minV = outline.points[0].v;
+  double maxV = minV;
+  for (size_t i = 1; i < outline.count; ++i) {
+    minV = std::min(minV, outline.points[i].v);
+    maxV = std::max(maxV, outline.points[i].v);
+  }
+
+  // Rows whose centers (y + 0.5) are within the polygon's extent.
+  int firstRow = std::max(0, static_cast<int>(std::ceil(minV - 0.5)));
+  int lastRow = std::min(height - 1, static_cast<int>(std::floor(maxV - 0.5)));
+  size_t rowSize = backgroundRow.size();
+  for (int y = firstRow; y <= lastRow; ++y) {
+    double center = y + 0.5;
+
+    // Where the row's center line crosses the edges, left to right.
+    crossings.clear();
+    for (size_t i = 0; i < outline.count; ++i) {
+      const SimPixel& a = outline.points[i];
+      const SimPixel& b = outline.points[(i + 1) % outline.count];
+      if ((a.v <= center) != (b.v <= center)) {
+        crossings.push_back(a.u + (center - a.v) * (b.u - a.u) / (b.v - a.v));
+      }
+    }
+    std::sort(crossings.begin(), crossings.end());
+
+    // Fill between each pair of crossings (even-odd rule).
+    uint8_t* row = pixels.data() + y * rowSize;
+    for (size_t i = 0; i + 1 < crossings.size(); i += 2) {
+      double left = std::ceil(crossings[i] - 0.5);
+      double right = std::ceil(crossings[i + 1] - 0.5);
+      int x0 = static_cast<int>(std::max(left, 0.0));
+      int x1 = static_cast<int>(std::min(right, static_cast<double>(width)));
+      if (x1 <= x0) continue;
+      std::memcpy(row + x0 * pixelSize, targetRow.data(),
+                  (x1 - x0) * pixelSize);
+    }
+  }
+}
+
+void SimFrameRenderer::Render(const SimPinholeView& view,
+                              const SimTargetStore& targets,
+                              wpi::ArrayRef<size_t> indices) {
+  Clear();
+
+  size_t count = indices.size();
+  geometry.Resize(count);
+  for (size_t i = 0; i < count; ++i) {
+    geometry.Set(i, targets[indices[i]]);
+  }
+  ProjectTargets(view, geometry, count, projected);
+
+  for (size_t i = 0; i < count; ++i) {
+    if (projected.status[i] == SimProjectedTargets::kHidden) continue;
+    MeasureProjectedTarget(view, projected, i, &outline);
+    FillPolygon(outline);
+  }
+}
+
+cv::Mat SimFrameRenderer::GetMat() {
+  return cv::Mat(height, width, format == kBGR ? CV_8UC3 : CV_8UC1,
+                 pixels.data());
+}
+
+void SimFrameRenderer::PutFrame(cs::CvSource& source) {
+  cv::Mat frame = GetMat();
+  source.PutFrame(frame);
+}
+
+}  // namespace photonlib
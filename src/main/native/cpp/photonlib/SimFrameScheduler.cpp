@@ -0,0 +1,112 @@
+/**
+ * Copyright (C) 2020-2021 Photon Vision.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "photonlib/SimFrameScheduler.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <utility>
+
+namespace photonlib {
+
+namespace {
+constexpr double kPi = 3.14159265358979323846;
+
+// Frames held up behind a slow one complete together; those still come out
+// in capture order.
+bool CompletesLater(const SimPendingFrame& a, const SimPendingFrame& b) {
+  if (a.completionTime != b.completionTime) {
+    return a.completionTime > b.completionTime;
+  }
+  return a.captureTime > b.captureTime;
+}
+}  // namespace
+
+SimFrameScheduler::SimFrameScheduler(units::hertz_t frameRate,
+                                     units::second_t meanLatency,
+                                     units::second_t latencyStdDev,
+                                     double dropRate, uint64_t seed)
+    : frameRate(frameRate),
+      meanLatency(meanLatency),
+      latencyStdDev(latencyStdDev),
+      dropRate(dropRate),
+      rng(seed) {
+  Reset();
+}
+
+void SimFrameScheduler::Reseed(uint64_t seed) { rng.Seed(seed); }
+
+void SimFrameScheduler::Reset() {
+  started = false;
+  lastCompletion = units::second_t(-std::numeric_limits<double>::infinity());
+  queue.clear();
+}
+
+bool SimFrameScheduler::ShouldCapture(units::second_t now) {
+  double rate = frameRate.to<double>();
+  if (rate <= 0.0) return true;
+
+  double period = 1.0 / rate;
+  if (!started) {
+    started = true;
+    nextCapture = now;
+  }
+  if (now < nextCapture) return false;
+
+  // Skip any captures missed since the last call, keeping the phase.
+  double missed = std::floor((now - nextCapture).to<double>() / period);
+  nextCapture += units::second_t(period * (missed + 1.0));
+  return true;
+}
+
+void SimFrameScheduler::Submit(units::second_t captureTime,
+                               wpi::ArrayRef<PhotonTrackedTarget> targets) {
+  // Always draw both numbers so one setting doesn't shift the other's
+  // sequence.
+  bool dropped = rng.NextUniform() < dropRate;
+  units::second_t latency = meanLatency + latencyStdDev * NextGaussian();
+  if (dropped) return;
+
+  units::second_t completion =
+      captureTime + std::max(latency, units::second_t(0.0));
+  completion = std::max(completion, lastCompletion);
+  lastCompletion = completion;
+
+  queue.push_back(SimPendingFrame{captureTime, completion,
+                                  std::vector<PhotonTrackedTarget>(
+                                      targets.begin(), targets.end())});
+  std::push_heap(queue.begin(), queue.end(), CompletesLater);
+}
+
+bool SimFrameScheduler::PopCompleted(units::second_t now,
+                                     SimPendingFrame* frame) {
+  if (queue.empty() || queue.front().completionTime > now) return false;
+  std::pop_heap(queue.begin(), queue.end(), CompletesLater);
+  *frame = std::move(queue.back());
+  queue.pop_back();
+  return true;
+}
+
+double SimFrameScheduler::NextGaussian() {
+  // Box-Muller; 1 - u keeps the log argument in (0, 1].
+  double u = 1.0 - rng.NextUniform();
+  double v = rng.NextUniform();
+  return std::sqrt(-2.0 * std::log(u)) * std::cos(2.0 * kPi * v);
+}
+
+}  // namespace photonlib
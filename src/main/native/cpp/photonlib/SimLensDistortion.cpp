@@ -0,0 +1,163 @@
+/**
+ * Copyright (C) 2020-2021 Photon Vision.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "photonlib/SimLensDistortion.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace photonlib {
+
+namespace {
+// Enough for the fixed-point undistortion to converge well below a pixel for
+// any lens the polynomial describes sensibly.
+constexpr int kUndistortIterations = 20;
+
+// How far past the undistorted image the distortion table reaches, as a
+// fraction of its size, so that points just outside the view still map to
+// just outside the image.
+constexpr double kDistortMargin = 0.25;
+}  // namespace
+
+SimLensDistortion::SimLensDistortion(
+    const SimCameraIntrinsics& intrinsics,
+    const SimDistortionCoefficients& coefficients, double gridStep)
+    : intrinsics(intrinsics), coefficients(coefficients) {
+  // Samples a mapping on a grid with the given origin, spacing and number
+  // of cells.
+  auto fill = [](Table& table, Pixel origin, double stepU, double stepV,
+                 int cellsU, int cellsV, auto map) {
+    table.u0 = origin.u;
+    table.v0 = origin.v;
+    table.stepU = stepU;
+    table.stepV = stepV;
+    table.cols = cellsU + 1;
+    table.rows = cellsV + 1;
+    table.samples.resize(static_cast<size_t>(table.cols) * table.rows);
+    for (int row = 0; row < table.rows; ++row) {
+      for (int col = 0; col < table.cols; ++col) {
+        table.samples[row * table.cols + col] =
+            map(Pixel{origin.u + col * stepU, origin.v + row * stepV});
+      }
+    }
+  };
+
+  // Sample the undistortion over the image, one cell past each edge.
+  int cellsU = static_cast<int>(std::ceil(intrinsics.width / gridStep));
+  int cellsV = static_cast<int>(std::ceil(intrinsics.height / gridStep));
+  double stepU = static_cast<double>(intrinsics.width) / cellsU;
+  double stepV = static_cast<double>(intrinsics.height) / cellsV;
+  fill(undistortTable, Pixel{-stepU, -stepV}, stepU, stepV, cellsU + 2,
+       cellsV + 2, [this](Pixel p) { return UndistortExact(p); });
+
+  // The image's edges, undistorted, bound what the camera can see.
+  idealBounds = {std::numeric_limits<double>::infinity(),
+                 -std::numeric_limits<double>::infinity(),
+                 std::numeric_limits<double>::infinity(),
+                 -std::numeric_limits<double>::infinity()};
+  auto include = [this](Pixel p) {
+    Pixel ideal = UndistortExact(p);
+    idealBounds.minU = std::min(idealBounds.minU, ideal.u);
+    idealBounds.maxU = std::max(idealBounds.maxU, ideal.u);
+    idealBounds.minV = std::min(idealBounds.minV, ideal.v);
+    idealBounds.maxV = std::max(idealBounds.maxV, ideal.v);
+  };
+  double width = intrinsics.width;
+  double height = intrinsics.height;
+  for (double u = 0.0; u < width + gridStep; u += gridStep) {
+    include({std::min(u, width), 0.0});
+    include({std::min(u, width), height});
+  }
+  for (double v = 0.0; v < height + gridStep; v += gridStep) {
+    include({0.0, std::min(v, height)});
+    include({width, std::min(v, height)});
+  }
+
+  // Sample the distortion over those bounds plus a margin, with grid lines
+  // on the bounds' edges. Past the bounds the polynomial can fold back into
+  // the image, so there the mapping carries on outward from the bounds' edge
+  // instead; the kink this leaves lies on grid lines, not inside a cell.
+  int marginU = static_cast<int>(std::ceil(kDistortMargin * cellsU));
+  int marginV = static_cast<int>(std::ceil(kDistortMargin * cellsV));
+  stepU = (idealBounds.maxU - idealBounds.minU) / cellsU;
+  stepV = (idealBounds.maxV - idealBounds.minV) / cellsV;
+  fill(distortTable,
+       Pixel{idealBounds.minU - marginU * stepU,
+             idealBounds.minV - marginV * stepV},
+       stepU, stepV, cellsU + 2 * marginU, cellsV + 2 * marginV,
+       [this](Pixel p) {
+         Pixel edge{std::clamp(p.u, idealBounds.minU, idealBounds.maxU),
+                    std::clamp(p.v, idealBounds.minV, idealBounds.maxV)};
+         Pixel distorted = DistortExact(edge);
+         return Pixel{distorted.u + p.u - edge.u, distorted.v + p.v - edge.v};
+       });
+}
+
+SimLensDistortion::Pixel SimLensDistortion::DistortExact(Pixel ideal) const {
+  const auto& c = coefficients;
+  double x = (ideal.u - intrinsics.cx) / intrinsics.fx;
+  double y = (ideal.v - intrinsics.cy) / intrinsics.fy;
+  double r2 = x * x + y * y;
+  double radial = 1 + r2 * (c.k1 + r2 * (c.k2 + r2 * c.k3));
+  double xd = x * radial + 2 * c.p1 * x * y + c.p2 * (r2 + 2 * x * x);
+  double yd = y * radial + c.p1 * (r2 + 2 * y * y) + 2 * c.p2 * x * y;
+  return {intrinsics.cx + intrinsics.fx * xd,
+          intrinsics.cy + intrinsics.fy * yd};
+}
+
+SimLensDistortion::Pixel SimLensDistortion::UndistortExact(
+    Pixel distorted) const {
+  // Fixed-point iteration, as in OpenCV's undistortPoints.
+  const auto& c = coefficients;
+  double xd = (distorted.u - intrinsics.cx) / intrinsics.fx;
+  double yd = (distorted.v - intrinsics.cy) / intrinsics.fy;
+  double x = xd;
+  double y = yd;
+  for (int i = 0; i < kUndistortIterations; ++i) {
+    double r2 = x * x + y * y;
+    double radial = 1 + r2 * (c.k1 + r2 * (c.k2 + r2 * c.k3));
+    double dx = 2 * c.p1 * x * y + c.p2 * (r2 + 2 * x * x);
+    double dy = c.p1 * (r2 + 2 * y * y) + 2 * c.p2 * x * y;
+    x = (xd - dx) / radial;
+    y = (yd - dy) / radial;
+  }
+  return {intrinsics.cx + intrinsics.fx * x, intrinsics.cy + intrinsics.fy * y};
+}
+
+SimLensDistortion::Pixel SimLensDistortion::Table::Lookup(Pixel p) const {
+  // Interpolate within the nearest cell. Past the grid's edge that cell's
+  // weights go outside [0, 1], extending it linearly, so far-off corners
+  // keep their shape instead of collapsing onto the edge.
+  double gu = (p.u - u0) / stepU;
+  double gv = (p.v - v0) / stepV;
+  int col = static_cast<int>(std::clamp(gu, 0.0, cols - 2.0));
+  int row = static_cast<int>(std::clamp(gv, 0.0, rows - 2.0));
+  double tu = gu - col;
+  double tv = gv - row;
+
+  const Pixel& a = samples[row * cols + col];
+  const Pixel& b = samples[row * cols + col + 1];
+  const Pixel& c = samples[(row + 1) * cols + col];
+  const Pixel& d = samples[(row + 1) * cols + col + 1];
+  return {(1 - tv) * ((1 - tu) * a.u + tu * b.u) +
+              tv * ((1 - tu) * c.u + tu * d.u),
+          (1 - tv) * ((1 - tu) * a.v + tu * b.v) +
+              tv * ((1 - tu) * c.v + tu * d.v)};
+}
+
+}  // namespace photonlib
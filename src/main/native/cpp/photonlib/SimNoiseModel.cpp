@@ -0,0 +1,94 @@
+/**
+ * Copyright (C) 2020-2021 Photon Vision.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "photonlib/SimNoiseModel.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace photonlib {
+
+namespace {
+constexpr double kPi = 3.14159265358979323846;
+
+// Counter layout: frame (two words), target number, stream. Frame-wide
+// draws use a target number no real target has.
+constexpr uint32_t kFrameDraws = 0xFFFFFFFF;
+constexpr uint32_t kAngleStream = 0;
+constexpr uint32_t kAreaStream = 1;
+
+// Box-Muller: two independent standard normals from two uniform words.
+void Gaussians(uint32_t a, uint32_t b, double* first, double* second) {
+  double radius = std::sqrt(-2.0 * std::log(Philox4x32::ToUniform(a)));
+  double angle = 2.0 * kPi * Philox4x32::ToUniform(b);
+  *first = radius * std::cos(angle);
+  *second = radius * std::sin(angle);
+}
+}  // namespace
+
+void SimNoiseModel::Apply(uint64_t frame, units::degree_t horizFOV,
+                          units::degree_t vertFOV,
+                          std::vector<PhotonTrackedTarget>& targets,
+                          double areaScale) const {
+  if (!Enabled()) return;
+
+  uint32_t frameLo = static_cast<uint32_t>(frame);
+  uint32_t frameHi = static_cast<uint32_t>(frame >> 32);
+
+  size_t kept = 0;
+  for (size_t i = 0; i < targets.size(); ++i) {
+    uint32_t index = static_cast<uint32_t>(i);
+    auto angleWords = rng({frameLo, frameHi, index, kAngleStream});
+    if (Philox4x32::ToUniform(angleWords[2]) < falseNegativeRate) continue;
+
+    const PhotonTrackedTarget& target = targets[i];
+    double distance =
+        target.GetCameraRelativePose().Translation().Norm().to<double>();
+    double sigma = angleStdDev + angleStdDevPerMeter * distance;
+    double yawError;
+    double pitchError;
+    Gaussians(angleWords[0], angleWords[1], &yawError, &pitchError);
+
+    auto areaWords = rng({frameLo, frameHi, index, kAreaStream});
+    double areaError;
+    double unused;
+    Gaussians(areaWords[0], areaWords[1], &areaError, &unused);
+    double area =
+        std::max(target.GetArea() * (1.0 + areaStdDev * areaError), 0.0);
+
+    targets[kept++] = PhotonTrackedTarget(
+        target.GetYaw() + sigma * yawError,
+        target.GetPitch() + sigma * pitchError, area, target.GetSkew(),
+        target.GetCameraRelativePose());
+  }
+  targets.erase(targets.begin() + kept, targets.end());
+
+  if (falsePositiveRate > 0.0) {
+    auto words = rng({frameLo, frameHi, kFrameDraws, kAngleStream});
+    if (Philox4x32::ToUniform(words[0]) < falsePositiveRate) {
+      double yaw = (Philox4x32::ToUniform(words[1]) - 0.5) *
+                   horizFOV.to<double>();
+      double pitch =
+          (Philox4x32::ToUniform(words[2]) - 0.5) * vertFOV.to<double>();
+      double area =
+          Philox4x32::ToUniform(words[3]) * falsePositiveMaxArea * areaScale;
+      targets.emplace_back(yaw, pitch, area, 0.0, frc::Transform2d());
+    }
+  }
+}
+
+}  // namespace photonlib
@@ -0,0 +1,164 @@
+/**
+ * Copyright (C) 2020-2021 Photon Vision.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "photonlib/SimObstacleBvh.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace photonlib {
+
+namespace {
+constexpr size_t kLeafSize = 4;
+
+// Hits this close to the target end of the line of sight, as a fraction of
+// its length, are the target's own wall and don't count.
+constexpr double kEndTolerance = 1e-6;
+
+// Narrows [tMin, tMax] to where p + t * r is within [lo, hi] on one axis.
+bool ClipSlab(double p, double r, double lo, double hi, double* tMin,
+              double* tMax) {
+  if (r == 0.0) return lo <= p && p <= hi;
+  double t0 = (lo - p) / r;
+  double t1 = (hi - p) / r;
+  if (t0 > t1) std::swap(t0, t1);
+  *tMin = std::max(*tMin, t0);
+  *tMax = std::min(*tMax, t1);
+  return *tMin <= *tMax;
+}
+}  // namespace
+
+void SimObstacleBvh::Clear() {
+  obstacles.clear();
+  Rebuild();
+}
+
+void SimObstacleBvh::Add(wpi::ArrayRef<SimObstacle> newObstacles) {
+  obstacles.insert(obstacles.end(), newObstacles.begin(), newObstacles.end());
+  Rebuild();
+}
+
+void SimObstacleBvh::Rebuild() {
+  segments.clear();
+  nodes.clear();
+  if (obstacles.empty()) return;
+
+  segments.reserve(obstacles.size());
+  for (auto& obstacle : obstacles) {
+    segments.push_back({obstacle.start.X().to<double>(),
+                        obstacle.start.Y().to<double>(),
+                        obstacle.end.X().to<double>(),
+                        obstacle.end.Y().to<double>(),
+                        obstacle.height.to<double>()});
+  }
+  nodes.reserve(2 * segments.size() / kLeafSize + 1);
+  Build(0, segments.size());
+}
+
+void SimObstacleBvh::Build(size_t begin, size_t end) {
+  Node node;
+  node.minX = node.minY = std::numeric_limits<double>::infinity();
+  node.maxX = node.maxY = -std::numeric_limits<double>::infinity();
+  node.first = 0;
+  node.second = 0;
+  node.count = 0;
+  for (size_t i = begin; i < end; ++i) {
+    auto& s = segments[i];
+    node.minX = std::min({node.minX, s.x0, s.x1});
+    node.minY = std::min({node.minY, s.y0, s.y1});
+    node.maxX = std::max({node.maxX, s.x0, s.x1});
+    node.maxY = std::max({node.maxY, s.y0, s.y1});
+  }
+
+  size_t index = nodes.size();
+  if (end - begin <= kLeafSize) {
+    node.first = static_cast<uint32_t>(begin);
+    node.count = static_cast<uint32_t>(end - begin);
+    nodes.push_back(node);
+    return;
+  }
+  nodes.push_back(node);
+
+  // Split at the median centroid along the longer side of the box.
+  bool splitX = node.maxX - node.minX >= node.maxY - node.minY;
+  size_t mid = begin + (end - begin) / 2;
+  std::nth_element(segments.begin() + begin, segments.begin() + mid,
+                   segments.begin() + end,
+                   [splitX](const Segment& a, const Segment& b) {
+                     return splitX ? a.x0 + a.x1 < b.x0 + b.x1
+                                   : a.y0 + a.y1 < b.y0 + b.y1;
+                   });
+  Build(begin, mid);
+  nodes[index].second = static_cast<uint32_t>(nodes.size());
+  Build(mid, end);
+}
+
+bool SimObstacleBvh::Occludes(const frc::Translation2d& from,
+                              units::meter_t fromHeight,
+                              const frc::Translation2d& to,
+                              units::meter_t toHeight) const {
+  if (nodes.empty()) return false;
+
+  double px = from.X().to<double>();
+  double py = from.Y().to<double>();
+  double rx = to.X().to<double>() - px;
+  double ry = to.Y().to<double>() - py;
+  double h0 = fromHeight.to<double>();
+  double dh = toHeight.to<double>() - h0;
+
+  // The tree is balanced, so 64 levels is far more than can be reached.
+  uint32_t stack[64];
+  size_t depth = 0;
+  stack[depth++] = 0;
+  while (depth > 0) {
+    const Node& node = nodes[stack[--depth]];
+    double tMin = 0.0;
+    double tMax = 1.0;
+    if (!ClipSlab(px, rx, node.minX, node.maxX, &tMin, &tMax) ||
+        !ClipSlab(py, ry, node.minY, node.maxY, &tMin, &tMax)) {
+      continue;
+    }
+
+    if (node.count == 0) {
+      stack[depth++] = static_cast<uint32_t>(&node - nodes.data()) + 1;
+      stack[depth++] = node.second;
+      continue;
+    }
+
+    for (size_t i = node.first; i < node.first + node.count; ++i) {
+      auto& s = segments[i];
+      double sx = s.x1 - s.x0;
+      double sy = s.y1 - s.y0;
+      double denom = rx * sy - ry * sx;
+      // A wall seen exactly edge-on hides nothing.
+      if (denom == 0.0) continue;
+
+      double qx = s.x0 - px;
+      double qy = s.y0 - py;
+      double t = (qx * sy - qy * sx) / denom;
+      double u = (qx * ry - qy * rx) / denom;
+      if (u < 0.0 || u > 1.0 || t <= 0.0 || t >= 1.0 - kEndTolerance) {
+        continue;
+      }
+      // The line of sight may pass over the top of the wall.
+      if (h0 + t * dh < s.height) return true;
+    }
+  }
+  return false;
+}
+
+}  // namespace photonlib
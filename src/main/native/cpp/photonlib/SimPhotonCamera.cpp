@@ -17,6 +17,8 @@
 
 #include "photonlib/SimPhotonCamera.h"
 
+#include "photonlib/PhotonTrace.h"
+
 namespace photonlib {
 
 SimPhotonCamera::SimPhotonCamera(std::shared_ptr<nt::NetworkTable> rootTable)
@@ -27,7 +29,14 @@ SimPhotonCamera::SimPhotonCamera(const std::string& cameraName)
 
 void SimPhotonCamera::SubmitProcessedFrame(
     units::second_t latency, wpi::ArrayRef<PhotonTrackedTarget> tgtList) {
+  PHOTON_TRACE_SCOPE("SimPhotonCamera::SubmitProcessedFrame");
   if (!GetDriverMode()) {
+    if (deliveryMode == kInProcess) {
+      directChannel->Publish(PhotonPipelineResult(latency, tgtList),
+                             publisherToken);
+      return;
+    }
+
     // Clear the current packet.
     simPacket.Clear();
 
@@ -39,4 +48,14 @@ void SimPhotonCamera::SubmitProcessedFrame(
   }
 }
 
+void SimPhotonCamera::SetDeliveryMode(DeliveryMode mode) {
+  if (mode == deliveryMode) return;
+  deliveryMode = mode;
+  if (mode == kNetworkTables) {
+    // Stop readers from returning the last in-process result. This happens
+    // once here rather than on every frame submitted to NetworkTables.
+    directChannel->Clear();
+  }
+}
+
 }  // namespace photonlib
@@ -0,0 +1,343 @@
+/**
+ * Copyright (C) 2020-2021 Photon Vision.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "photonlib/SimPinholeCamera.h"
+
+#include <array>
+#include <cmath>
+
+#include "photonlib/SimLensDistortion.h"
+#include "photonlib/SimdBatch.h"
+
+namespace photonlib {
+
+namespace {
+// Corners closer to the camera plane than this are clipped away, so that
+// nothing is divided by a depth near zero.
+constexpr double kNearPlane = 1e-3;
+
+// The lateral and vertical sign of each corner, in SimProjectedTargets order.
+constexpr double kCornerSide[SimProjectedTargets::kCorners] = {-1, 1, 1, -1};
+constexpr double kCornerUp[SimProjectedTargets::kCorners] = {1, 1, -1, -1};
+
+// Projects one batch of targets starting at index i and sets their statuses.
+template <typename B>
+void ProjectBatch(const SimPinholeView& view, const SimTargetGeometry& g,
+                  size_t i, SimProjectedTargets& out) {
+  B camX = B::Broadcast(view.x);
+  B camY = B::Broadcast(view.y);
+  B camZ = B::Broadcast(view.height);
+  B cosYaw = B::Broadcast(view.cosYaw);
+  B sinYaw = B::Broadcast(view.sinYaw);
+  B cosPitch = B::Broadcast(view.cosPitch);
+  B sinPitch = B::Broadcast(view.sinPitch);
+  B fx = B::Broadcast(view.intrinsics.fx);
+  B fy = B::Broadcast(view.intrinsics.fy);
+  B cx = B::Broadcast(view.intrinsics.cx);
+  B cy = B::Broadcast(view.intrinsics.cy);
+  B zero = B::Broadcast(0.0);
+  B minU = B::Broadcast(view.bounds.minU);
+  B maxU = B::Broadcast(view.bounds.maxU);
+  B minV = B::Broadcast(view.bounds.minV);
+  B maxV = B::Broadcast(view.bounds.maxV);
+  B nearPlane = B::Broadcast(kNearPlane);
+
+  B x = B::Load(g.xs.data() + i);
+  B y = B::Load(g.ys.data() + i);
+  B z = B::Load(g.heights.data() + i);
+  // The target's face runs along (-sin, cos) of its heading.
+  B halfWidth = B::Load(g.halfWidths.data() + i);
+  B acrossX = zero - B::Load(g.sinHeadings.data() + i) * halfWidth;
+  B acrossY = B::Load(g.cosHeadings.data() + i) * halfWidth;
+  B halfHeight = B::Load(g.halfHeights.data() + i);
+
+  // Per-lane bit sets, combined across corners.
+  unsigned allFront = ~0u, anyFront = 0;
+  unsigned allLeft = ~0u, allRight = ~0u, allAbove = ~0u, allBelow = ~0u;
+  unsigned anyOutside = 0;
+  for (size_t k = 0; k < SimProjectedTargets::kCorners; ++k) {
+    B side = B::Broadcast(kCornerSide[k]);
+    B dx = x + acrossX * side - camX;
+    B dy = y + acrossY * side - camY;
+    B dz = z + halfHeight * B::Broadcast(kCornerUp[k]) - camZ;
+
+    B level = dx * cosYaw + dy * sinYaw;
+    B left = dy * cosYaw - dx * sinYaw;
+    B forward = level * cosPitch + dz * sinPitch;
+    B up = dz * cosPitch - level * sinPitch;
+    B u = cx - fx * left / forward;
+    B v = cy - fy * up / forward;
+
+    forward.Store(out.forward[k].data() + i);
+    left.Store(out.left[k].data() + i);
+    up.Store(out.up[k].data() + i);
+    u.Store(out.u[k].data() + i);
+    v.Store(out.v[k].data() + i);
+
+    unsigned front = B::Bits(Less(nearPlane, forward));
+    unsigned offLeft = B::Bits(Less(u, minU));
+    unsigned offRight = B::Bits(Less(maxU, u));
+    unsigned offTop = B::Bits(Less(v, minV));
+    unsigned offBottom = B::Bits(Less(maxV, v));
+    allFront &= front;
+    anyFront |= front;
+    allLeft &= offLeft;
+    allRight &= offRight;
+    allAbove &= offTop;
+    allBelow &= offBottom;
+    anyOutside |= offLeft | offRight | offTop | offBottom;
+  }
+
+  // A target wholly in front of the camera is hidden when all its corners
+  // are past the same edge of the bounds. One partly behind the camera can't be
+  // judged from its projection, and is left to be clipped.
+  unsigned outside = allFront & (allLeft | allRight | allAbove | allBelow);
+  unsigned inside = allFront & ~anyOutside;
+  for (size_t lane = 0; lane < B::kWidth; ++lane) {
+    unsigned bit = 1u << lane;
+    uint8_t status = SimProjectedTargets::kClipped;
+    if (!(anyFront & bit) || (outside & bit)) {
+      status = SimProjectedTargets::kHidden;
+    } else if (inside & bit) {
+      status = SimProjectedTargets::kInside;
+    }
+    out.status[i + lane] = status;
+  }
+}
+
+// Each edge of a distorted outline is split into this many segments, since
+// distortion bends straight edges.
+constexpr size_t kSubdivisions = 4;
+
+using Point = SimPixel;
+
+// Room for a quadrilateral clipped by the near plane, split for distortion
+// and then clipped by the four image edges.
+using Polygon = std::array<Point, SimTargetOutline::kMaxPoints>;
+
+// Clips a polygon to the half-plane where inside(p) >= 0, keeping vertex
+// order (Sutherland-Hodgman).
+template <typename Inside>
+size_t ClipPolygon(const Polygon& in, size_t count, Polygon& out,
+                   Inside inside) {
+  size_t n = 0;
+  for (size_t i = 0; i < count; ++i) {
+    const Point& a = in[i];
+    const Point& b = in[(i + 1) % count];
+    double da = inside(a);
+    double db = inside(b);
+    if (da >= 0) out[n++] = a;
+    if ((da >= 0) != (db >= 0)) {
+      double t = da / (da - db);
+      out[n++] = {a.u + t * (b.u - a.u), a.v + t * (b.v - a.v)};
+    }
+  }
+  return n;
+}
+}  // namespace
+
+SimCameraIntrinsics SimCameraIntrinsics::FromFOV(units::degree_t diagFOV,
+                                                 int width, int height) {
+  double focal = std::hypot(width, height) / 2 /
+                 std::tan(units::radian_t(diagFOV).to<double>() / 2);
+  return SimCameraIntrinsics(focal, focal, width / 2.0, height / 2.0, width,
+                             height);
+}
+
+units::radian_t SimCameraIntrinsics::HorizontalFOV() const {
+  return units::radian_t(std::atan2(cx, fx) + std::atan2(width - cx, fx));
+}
+
+units::radian_t SimCameraIntrinsics::VerticalFOV() const {
+  return units::radian_t(std::atan2(cy, fy) + std::atan2(height - cy, fy));
+}
+
+SimPinholeView::SimPinholeView(const frc::Pose2d& pose, units::meter_t height,
+                               units::radian_t pitch,
+                               const SimCameraIntrinsics& intrinsics,
+                               const SimLensDistortion* distortion)
+    : x(pose.X().to<double>()),
+      y(pose.Y().to<double>()),
+      height(height.to<double>()),
+      cosYaw(pose.Rotation().Cos()),
+      sinYaw(pose.Rotation().Sin()),
+      cosPitch(std::cos(pitch.to<double>())),
+      sinPitch(std::sin(pitch.to<double>())),
+      intrinsics(intrinsics),
+      distortion(distortion),
+      bounds(distortion ? distortion->GetIdealBounds()
+                        : SimImageBounds{0.0, 1.0 * intrinsics.width, 0.0,
+                                         1.0 * intrinsics.height}) {}
+
+void SimTargetGeometry::Resize(size_t count) {
+  xs.resize(count);
+  ys.resize(count);
+  heights.resize(count);
+  cosHeadings.resize(count);
+  sinHeadings.resize(count);
+  halfWidths.resize(count);
+  halfHeights.resize(count);
+}
+
+void SimTargetGeometry::Set(size_t index, const SimVisionTarget& tgt) {
+  xs[index] = tgt.targetPos.X().to<double>();
+  ys[index] = tgt.targetPos.Y().to<double>();
+  heights[index] = tgt.targetHeightAboveGround.to<double>();
+  cosHeadings[index] = tgt.targetPos.Rotation().Cos();
+  sinHeadings[index] = tgt.targetPos.Rotation().Sin();
+  halfWidths[index] = tgt.targetWidth.to<double>() / 2;
+  halfHeights[index] = tgt.targetHeight.to<double>() / 2;
+}
+
+void SimProjectedTargets::Resize(size_t count) {
+  for (size_t k = 0; k < kCorners; ++k) {
+    forward[k].resize(count);
+    left[k].resize(count);
+    up[k].resize(count);
+    u[k].resize(count);
+    v[k].resize(count);
+  }
+  status.resize(count);
+}
+
+void ProjectTargets(const SimPinholeView& view,
+                    const SimTargetGeometry& geometry, size_t count,
+                    SimProjectedTargets& projected) {
+  projected.Resize(count);
+  size_t i = 0;
+  for (; i + simd::Batch::kWidth <= count; i += simd::Batch::kWidth) {
+    ProjectBatch<simd::Batch>(view, geometry, i, projected);
+  }
+  for (; i < count; ++i) {
+    ProjectBatch<simd::Scalar>(view, geometry, i, projected);
+  }
+}
+
+SimProjectedShape MeasureProjectedTarget(const SimPinholeView& view,
+                                         const SimProjectedTargets& projected,
+                                         size_t index,
+                                         SimTargetOutline* outline) {
+  constexpr size_t kCorners = SimProjectedTargets::kCorners;
+  const SimCameraIntrinsics& in = view.intrinsics;
+  SimProjectedShape shape;
+
+  Polygon polygon;
+  Polygon clipped;
+  size_t count = 0;
+  if (projected.status[index] == SimProjectedTargets::kInside &&
+      !view.distortion) {
+    for (size_t k = 0; k < kCorners; ++k) {
+      polygon[count++] = {projected.u[k][index], projected.v[k][index]};
+    }
+  } else {
+    // Clip against the near plane in the camera frame, where the edges are
+    // still straight, then project. Corners are (forward, left, up).
+    std::array<std::array<double, 3>, 8> camera;
+    size_t n = 0;
+    for (size_t k = 0; k < kCorners; ++k) {
+      size_t next = (k + 1) % kCorners;
+      std::array<double, 3> a{projected.forward[k][index],
+                              projected.left[k][index],
+                              projected.up[k][index]};
+      std::array<double, 3> b{projected.forward[next][index],
+                              projected.left[next][index],
+                              projected.up[next][index]};
+      double da = a[0] - kNearPlane;
+      double db = b[0] - kNearPlane;
+      if (da >= 0) camera[n++] = a;
+      if ((da >= 0) != (db >= 0)) {
+        double t = da / (da - db);
+        camera[n++] = {a[0] + t * (b[0] - a[0]), a[1] + t * (b[1] - a[1]),
+                       a[2] + t * (b[2] - a[2])};
+      }
+    }
+    for (size_t k = 0; k < n; ++k) {
+      polygon[count++] = {in.cx - in.fx * camera[k][1] / camera[k][0],
+                          in.cy - in.fy * camera[k][2] / camera[k][0]};
+    }
+
+    if (view.distortion) {
+      size_t split = 0;
+      for (size_t k = 0; k < count; ++k) {
+        const Point& a = polygon[k];
+        const Point& b = polygon[(k + 1) % count];
+        for (size_t s = 0; s < kSubdivisions; ++s) {
+          double t = static_cast<double>(s) / kSubdivisions;
+          clipped[split++] = view.distortion->Distort(
+              {a.u + t * (b.u - a.u), a.v + t * (b.v - a.v)});
+        }
+      }
+      polygon = clipped;
+      count = split;
+    }
+
+    // Then against each image edge.
+    double width = in.width;
+    double height = in.height;
+    count = ClipPolygon(polygon, count, clipped,
+                        [](const Point& p) { return p.u; });
+    count = ClipPolygon(clipped, count, polygon,
+                        [=](const Point& p) { return width - p.u; });
+    count = ClipPolygon(polygon, count, clipped,
+                        [](const Point& p) { return p.v; });
+    count = ClipPolygon(clipped, count, polygon,
+                        [=](const Point& p) { return height - p.v; });
+  }
+
+  if (outline) {
+    outline->points = polygon;
+    outline->count = count;
+  }
+
+  // Shoelace formula for the area and centroid.
+  double twiceArea = 0.0;
+  double sumU = 0.0;
+  double sumV = 0.0;
+  for (size_t k = 0; k < count; ++k) {
+    const Point& a = polygon[k];
+    const Point& b = polygon[(k + 1) % count];
+    double cross = a.u * b.v - b.u * a.v;
+    twiceArea += cross;
+    sumU += (a.u + b.u) * cross;
+    sumV += (a.v + b.v) * cross;
+  }
+  if (twiceArea == 0.0) return shape;
+  shape.area = std::abs(twiceArea) / 2;
+  shape.centerU = sumU / (3 * twiceArea);
+  shape.centerV = sumV / (3 * twiceArea);
+
+  // The top edge's slope, read left to right. Image v grows downward.
+  if (projected.forward[0][index] > kNearPlane &&
+      projected.forward[1][index] > kNearPlane) {
+    Point left{projected.u[0][index], projected.v[0][index]};
+    Point right{projected.u[1][index], projected.v[1][index]};
+    if (view.distortion) {
+      left = view.distortion->Distort(left);
+      right = view.distortion->Distort(right);
+    }
+    double du = right.u - left.u;
+    double dv = right.v - left.v;
+    if (du < 0) {
+      du = -du;
+      dv = -dv;
+    }
+    shape.skew = units::radian_t(std::atan2(-dv, du));
+  }
+  return shape;
+}
+
+}  // namespace photonlib
@@ -0,0 +1,158 @@
+/**
+ * Copyright (C) 2020-2021 Photon Vision.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "photonlib/SimRobotVision.h"
+
+#include <algorithm>
+
+#include <frc/DriverStation.h>
+
+namespace photonlib {
+
+namespace {
+constexpr double kPi = 3.14159265358979323846;
+}  // namespace
+
+SimRobotVision::SimRobotVision(WorkStealingPool& pool) : pool(pool) {}
+
+size_t SimRobotVision::AddCamera(const std::string& name,
+                                 units::degree_t camDiagFOV,
+                                 units::degree_t camPitch,
+                                 frc::Transform2d cameraToRobot,
+                                 units::meter_t cameraHeightOffGround,
+                                 units::meter_t maxLEDRange, int cameraResWidth,
+                                 int cameraResHeight, double minTargetArea) {
+  cameras.push_back(std::make_unique<SimVisionSystem>(
+      name, camDiagFOV, camPitch, cameraToRobot, cameraHeightOffGround,
+      maxLEDRange, cameraResWidth, cameraResHeight, minTargetArea));
+  cameras.back()->mountedOnRobot = true;
+  scratch.emplace_back();
+  return cameras.size() - 1;
+}
+
+SimTargetHandle SimRobotVision::AddSimVisionTarget(const SimVisionTarget& tgt) {
+  return tgtStore.Add(tgt);
+}
+
+bool SimRobotVision::UpdateTarget(SimTargetHandle handle,
+                                  const SimVisionTarget& tgt) {
+  return tgtStore.Update(handle, tgt);
+}
+
+bool SimRobotVision::RemoveTarget(SimTargetHandle handle) {
+  return tgtStore.Remove(handle);
+}
+
+void SimRobotVision::AddFieldLayout(const FieldLayout& layout) {
+  tgtStore.AddBulk(SimTargetLayoutFile::Pack(layout.GetTargets()));
+}
+
+void SimRobotVision::AddTargetLayout(const SimTargetLayoutFile& layout) {
+  tgtStore.AddBulk(layout.GetTargets());
+}
+
+void SimRobotVision::AddObstacles(wpi::ArrayRef<SimObstacle> newObstacles) {
+  obstacles.Add(newObstacles);
+}
+
+void SimRobotVision::ProcessFrame(const frc::Pose2d& robotPose) {
+  CaptureAll();
+  ComputeFrame(robotPose);
+  for (size_t i = 0; i < cameras.size(); ++i) {
+    SimVisionSystem& camera = *cameras[i];
+    if (camera.renderer) {
+      camera.RenderFrame(robotPose, tgtStore, scratch[i].visibleIdxs);
+    }
+    camera.cam.SubmitProcessedFrame(units::second_t(0.0),
+                                    scratch[i].visibleTgtList);
+  }
+}
+
+void SimRobotVision::ProcessFrame(const frc::Pose2d& robotPose,
+                                  units::second_t now) {
+  capturing.clear();
+  for (size_t i = 0; i < cameras.size(); ++i) {
+    if (cameras[i]->scheduler.ShouldCapture(now)) capturing.push_back(i);
+  }
+  if (!capturing.empty()) ComputeFrame(robotPose);
+  for (auto i : capturing) {
+    SimVisionSystem& camera = *cameras[i];
+    if (camera.renderer) {
+      camera.RenderFrame(robotPose, tgtStore, scratch[i].visibleIdxs);
+    }
+    camera.scheduler.Submit(now, scratch[i].visibleTgtList);
+  }
+
+  // Publish in completion order, as SimVisionSystem::ProcessFrame does.
+  SimPendingFrame frame;
+  for (auto& camera : cameras) {
+    while (camera->scheduler.PopCompleted(now, &frame)) {
+      camera->cam.SubmitProcessedFrame(now - frame.captureTime, frame.targets);
+    }
+  }
+}
+
+void SimRobotVision::ProcessFrame(
+    const frc::Pose2d& robotPose,
+    wpi::MutableArrayRef<PhotonPipelineResult> results) {
+  if (results.size() != cameras.size()) {
+    frc::DriverStation::ReportError(
+        "SimRobotVision::ProcessFrame needs one result per camera");
+    return;
+  }
+
+  CaptureAll();
+  ComputeFrame(robotPose);
+  for (size_t i = 0; i < cameras.size(); ++i) {
+    results[i] =
+        PhotonPipelineResult(units::second_t(0.0), scratch[i].visibleTgtList);
+  }
+}
+
+void SimRobotVision::CaptureAll() {
+  capturing.clear();
+  for (size_t i = 0; i < cameras.size(); ++i) capturing.push_back(i);
+}
+
+void SimRobotVision::ComputeFrame(const frc::Pose2d& robotPose) {
+  // A target a camera can see is within its range of the camera, and so
+  // within range plus mounting offset of the robot. Cull to the widest such
+  // circle once, instead of querying the grid per camera.
+  units::meter_t reach(0.0);
+  for (auto i : capturing) {
+    const SimVisionSystem& camera = *cameras[i];
+    reach = std::max(reach, camera.maxLEDRange +
+                                camera.cameraToRobot.Translation().Norm());
+  }
+  tgtStore.GetGrid().Query(robotPose, reach, units::radian_t(kPi),
+                           robotCandidates);
+
+  uint64_t frameIndex = frameCount++;
+  pool.ParallelFor(capturing.size(), [&](size_t, size_t c) {
+    size_t i = capturing[c];
+    const SimVisionSystem& camera = *cameras[i];
+    SimVisionSystem::FrameScratch& frame = scratch[i];
+    frc::Pose2d cameraPos =
+        robotPose.TransformBy(camera.constants.robotToCamera);
+    tgtStore.FilterCandidates(camera.MakeView(cameraPos), robotCandidates,
+                              frame.store, frame.candidateIdxs);
+    camera.EvaluateCandidates(cameraPos, tgtStore, obstacles, frameIndex,
+                              frame);
+  });
+}
+
+}  // namespace photonlib
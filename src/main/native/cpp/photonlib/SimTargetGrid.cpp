@@ -0,0 +1,248 @@
+/**
+ * Copyright (C) 2020-2021 Photon Vision.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "photonlib/SimTargetGrid.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace photonlib {
+
+namespace {
+constexpr double kMaxCellsPerSide = 1024.0;
+constexpr double kPi = 3.14159265358979323846;
+
+// Slack added to the culling tests so that targets sitting exactly on the
+// edge of the range disc or field of view are left for the exact test.
+constexpr double kTolerance = 1e-9;
+}  // namespace
+
+void SimTargetGrid::Clear() {
+  xs.clear();
+  ys.clear();
+  cellOf.clear();
+  slotInCell.clear();
+  Rebuild();
+}
+
+void SimTargetGrid::Insert(const frc::Translation2d& position) {
+  xs.push_back(position.X().to<double>());
+  ys.push_back(position.Y().to<double>());
+  cellOf.push_back(kRemoved);
+  slotInCell.push_back(0);
+  Link(xs.size() - 1);
+}
+
+void SimTargetGrid::InsertBulk(wpi::ArrayRef<double> newXs,
+                               wpi::ArrayRef<double> newYs) {
+  xs.insert(xs.end(), newXs.begin(), newXs.end());
+  ys.insert(ys.end(), newYs.begin(), newYs.end());
+  // Rebuild lists everything that isn't removed.
+  cellOf.resize(xs.size(), kOverflow);
+  slotInCell.resize(xs.size(), 0);
+  Rebuild();
+}
+
+void SimTargetGrid::Move(size_t index, const frc::Translation2d& position) {
+  double x = position.X().to<double>();
+  double y = position.Y().to<double>();
+  xs[index] = x;
+  ys[index] = y;
+
+  // Most moves between frames stay within one cell.
+  int cell = CellOf(x, y);
+  if (cell >= 0 && cell == cellOf[index]) return;
+  Unlink(index);
+  Link(index);
+}
+
+void SimTargetGrid::Remove(size_t index) { Unlink(index); }
+
+void SimTargetGrid::Link(size_t index) {
+  int cell = CellOf(xs[index], ys[index]);
+  auto& list = cell >= 0 ? cells[cell] : overflow;
+  cellOf[index] = cell >= 0 ? cell : kOverflow;
+  slotInCell[index] = list.size();
+  list.push_back(index);
+  if (cell < 0 && overflow.size() > 8 + xs.size() / 8) Rebuild();
+}
+
+void SimTargetGrid::Unlink(size_t index) {
+  int cell = cellOf[index];
+  if (cell == kRemoved) return;
+
+  // Swap the last entry of the list into the removed one's place.
+  auto& list = cell >= 0 ? cells[cell] : overflow;
+  size_t last = list.back();
+  list[slotInCell[index]] = last;
+  slotInCell[last] = slotInCell[index];
+  list.pop_back();
+  cellOf[index] = kRemoved;
+}
+
+int SimTargetGrid::CellOf(double x, double y) const {
+  double cx = std::floor((x - minX) / cellSize);
+  double cy = std::floor((y - minY) / cellSize);
+  // Written so that NaN coordinates also land outside the grid.
+  if (!(cx >= 0 && cy >= 0 && cx < cols && cy < rows)) return -1;
+  return static_cast<int>(cy) * cols + static_cast<int>(cx);
+}
+
+void SimTargetGrid::Rebuild() {
+  cells.clear();
+  overflow.clear();
+  cols = 0;
+  rows = 0;
+
+  // Only the targets that haven't been removed count towards the bounds, and
+  // any with non-finite coordinates are left in the overflow list.
+  double maxX = -std::numeric_limits<double>::infinity();
+  double maxY = maxX;
+  minX = std::numeric_limits<double>::infinity();
+  minY = minX;
+  size_t live = 0;
+  for (size_t i = 0; i < xs.size(); ++i) {
+    if (cellOf[i] == kRemoved || !std::isfinite(xs[i]) ||
+        !std::isfinite(ys[i])) {
+      continue;
+    }
+    minX = std::min(minX, xs[i]);
+    maxX = std::max(maxX, xs[i]);
+    minY = std::min(minY, ys[i]);
+    maxY = std::max(maxY, ys[i]);
+    ++live;
+  }
+  if (live == 0) {
+    // An empty grid; anything not removed goes to the overflow list below.
+    minX = 0.0;
+    minY = 0.0;
+    cellSize = 1.0;
+  } else {
+    double extentX = maxX - minX;
+    double extentY = maxY - minY;
+
+    // Aim for about one target per cell, without letting a long thin field
+    // produce an enormous number of cells.
+    cellSize = std::max({std::sqrt(extentX * extentY / live),
+                         std::max(extentX, extentY) / kMaxCellsPerSide, 1e-3});
+    cols = static_cast<int>(extentX / cellSize) + 1;
+    rows = static_cast<int>(extentY / cellSize) + 1;
+  }
+
+  cells.resize(static_cast<size_t>(cols) * rows);
+  for (size_t i = 0; i < xs.size(); ++i) {
+    if (cellOf[i] == kRemoved) continue;
+    int cell = CellOf(xs[i], ys[i]);
+    auto& list = cell >= 0 ? cells[cell] : overflow;
+    cellOf[i] = cell >= 0 ? cell : kOverflow;
+    slotInCell[i] = list.size();
+    list.push_back(i);
+  }
+}
+
+void SimTargetGrid::Query(const frc::Pose2d& cameraPose, units::meter_t range,
+                          units::radian_t halfFOV,
+                          wpi::SmallVectorImpl<size_t>& candidates) const {
+  candidates.clear();
+
+  double camX = cameraPose.X().to<double>();
+  double camY = cameraPose.Y().to<double>();
+  double cos = cameraPose.Rotation().Cos();
+  double sin = cameraPose.Rotation().Sin();
+  double r = range.to<double>();
+  double r2 = r * r * (1.0 + kTolerance);
+  double h = halfFOV.to<double>();
+  double cosH = std::cos(h);
+  double sinH = std::sin(h);
+
+  // A target is inside the wedge when |atan2(y, x)| < h, which for h < 180
+  // degrees is equivalent to |y| cos(h) < x sin(h) in the camera frame.
+  auto inView = [&](double x, double y) {
+    double dx = x - camX;
+    double dy = y - camY;
+    if (dx * dx + dy * dy > r2) return false;
+    double camFrameX = dx * cos + dy * sin;
+    double camFrameY = dy * cos - dx * sin;
+    return std::abs(camFrameY) * cosH - camFrameX * sinH <
+           kTolerance * (std::abs(camFrameX) + std::abs(camFrameY) + 1.0);
+  };
+
+  for (auto i : overflow) {
+    if (inView(xs[i], ys[i])) candidates.push_back(i);
+  }
+
+  if (cols > 0) {
+    // Clamp in floating point first, since the range may be huge.
+    auto clampCell = [](double v, int n) {
+      return static_cast<int>(std::min(std::max(v, 0.0), n - 1.0));
+    };
+    double loX = std::floor((camX - r - minX) / cellSize);
+    double hiX = std::floor((camX + r - minX) / cellSize);
+    double loY = std::floor((camY - r - minY) / cellSize);
+    double hiY = std::floor((camY + r - minY) / cellSize);
+    if (hiX < 0 || hiY < 0 || loX >= cols || loY >= rows) {
+      std::sort(candidates.begin(), candidates.end());
+      return;
+    }
+
+    // The wedge is only convex, and so only usable to reject whole cells,
+    // when it is narrower than 180 degrees.
+    bool cullWedge = h < kPi / 2;
+    for (int cy = clampCell(loY, rows); cy <= clampCell(hiY, rows); ++cy) {
+      for (int cx = clampCell(loX, cols); cx <= clampCell(hiX, cols); ++cx) {
+        const auto& cell = cells[cy * cols + cx];
+        if (cell.empty()) continue;
+
+        double x0 = minX + cx * cellSize - camX;
+        double y0 = minY + cy * cellSize - camY;
+        double x1 = x0 + cellSize;
+        double y1 = y0 + cellSize;
+
+        // Reject cells entirely outside the range disc.
+        double nearX = std::max(std::max(x0, -x1), 0.0);
+        double nearY = std::max(std::max(y0, -y1), 0.0);
+        if (nearX * nearX + nearY * nearY > r2) continue;
+
+        // Reject cells whose corners all lie beyond the same wedge edge.
+        if (cullWedge) {
+          bool beyondLeft = true;
+          bool beyondRight = true;
+          for (double dx : {x0, x1}) {
+            for (double dy : {y0, y1}) {
+              double camFrameX = dx * cos + dy * sin;
+              double camFrameY = dy * cos - dx * sin;
+              double slack = kTolerance * (cellSize + 1.0);
+              beyondLeft &= camFrameY * cosH - camFrameX * sinH > slack;
+              beyondRight &= -camFrameY * cosH - camFrameX * sinH > slack;
+            }
+          }
+          if (beyondLeft || beyondRight) continue;
+        }
+
+        for (auto i : cell) {
+          if (inView(xs[i], ys[i])) candidates.push_back(i);
+        }
+      }
+    }
+  }
+
+  // Report targets in insertion order, as the unculled loop did.
+  std::sort(candidates.begin(), candidates.end());
+}
+
+}  // namespace photonlib
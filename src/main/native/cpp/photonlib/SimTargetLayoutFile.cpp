@@ -0,0 +1,207 @@
+/**
+ * Copyright (C) 2020-2021 Photon Vision.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "photonlib/SimTargetLayoutFile.h"
+
+#include <cstring>
+#include <fstream>
+#include <type_traits>
+#include <utility>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <frc/DriverStation.h>
+
+namespace photonlib {
+
+namespace {
+// "PVTL" when read in the writer's byte order.
+constexpr uint32_t kMagic = 0x5056544C;
+constexpr uint32_t kVersion = 1;
+
+struct Header {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t count;
+  uint32_t reserved;
+};
+
+static_assert(sizeof(Header) == 16, "Header must be packed");
+static_assert(sizeof(SimPackedTarget) == 6 * sizeof(double),
+              "SimPackedTarget must be packed");
+static_assert(std::is_trivially_copyable_v<SimPackedTarget>,
+              "SimPackedTarget must be readable in place");
+
+// Maps a whole file read-only, returning null on failure.
+void* MapFile(const std::string& path, size_t& size) {
+#ifdef _WIN32
+  HANDLE file =
+      CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                  OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+  if (file == INVALID_HANDLE_VALUE) return nullptr;
+  LARGE_INTEGER fileSize;
+  void* view = nullptr;
+  if (GetFileSizeEx(file, &fileSize) && fileSize.QuadPart > 0) {
+    HANDLE mapping =
+        CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mapping != nullptr) {
+      view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+      CloseHandle(mapping);
+    }
+    size = static_cast<size_t>(fileSize.QuadPart);
+  }
+  CloseHandle(file);
+  return view;
+#else
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0) return nullptr;
+  struct stat info;
+  void* view = nullptr;
+  if (fstat(fd, &info) == 0 && info.st_size > 0) {
+    view = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (view == MAP_FAILED) view = nullptr;
+    size = static_cast<size_t>(info.st_size);
+  }
+  close(fd);
+  return view;
+#endif
+}
+
+void UnmapFile(void* view, size_t size) {
+#ifdef _WIN32
+  UnmapViewOfFile(view);
+#else
+  munmap(view, size);
+#endif
+}
+}  // namespace
+
+SimTargetLayoutFile::SimTargetLayoutFile(const std::string& path) {
+  mapping = MapFile(path, mappingSize);
+  if (!mapping) {
+    frc::DriverStation::ReportError("Could not open target layout " + path);
+    return;
+  }
+
+  Header header;
+  bool valid = mappingSize >= sizeof(header);
+  if (valid) {
+    std::memcpy(&header, mapping, sizeof(header));
+    valid = header.magic == kMagic && header.version == kVersion &&
+            mappingSize == sizeof(header) + static_cast<uint64_t>(
+                                                 header.count) *
+                                                 sizeof(SimPackedTarget);
+  }
+  if (!valid) {
+    frc::DriverStation::ReportError("Could not parse target layout " + path);
+    Unmap();
+    return;
+  }
+
+  // Mappings are page aligned, and the header keeps the targets 8 byte
+  // aligned after it.
+  auto mapped = reinterpret_cast<const SimPackedTarget*>(
+      static_cast<const char*>(mapping) + sizeof(header));
+
+  // A NaN or infinite coordinate would break the spatial grid, so a file with
+  // any such target is rejected whole rather than half loaded.
+  for (uint32_t i = 0; i < header.count; ++i) {
+    if (!mapped[i].IsValid()) {
+      frc::DriverStation::ReportError("Invalid target " + std::to_string(i) +
+                                      " in target layout " + path);
+      Unmap();
+      return;
+    }
+  }
+
+  targets = mapped;
+  count = header.count;
+}
+
+SimTargetLayoutFile::~SimTargetLayoutFile() { Unmap(); }
+
+SimTargetLayoutFile::SimTargetLayoutFile(SimTargetLayoutFile&& other)
+    : mapping(std::exchange(other.mapping, nullptr)),
+      mappingSize(std::exchange(other.mappingSize, 0)),
+      targets(std::exchange(other.targets, nullptr)),
+      count(std::exchange(other.count, 0)) {}
+
+SimTargetLayoutFile& SimTargetLayoutFile::operator=(
+    SimTargetLayoutFile&& other) {
+  if (this != &other) {
+    Unmap();
+    mapping = std::exchange(other.mapping, nullptr);
+    mappingSize = std::exchange(other.mappingSize, 0);
+    targets = std::exchange(other.targets, nullptr);
+    count = std::exchange(other.count, 0);
+  }
+  return *this;
+}
+
+void SimTargetLayoutFile::Unmap() {
+  if (mapping) UnmapFile(mapping, mappingSize);
+  mapping = nullptr;
+  mappingSize = 0;
+  targets = nullptr;
+  count = 0;
+}
+
+bool SimTargetLayoutFile::Write(const std::string& path,
+                                wpi::ArrayRef<SimPackedTarget> targets) {
+  Header header{kMagic, kVersion, static_cast<uint32_t>(targets.size()), 0};
+  std::ofstream file(path, std::ios::binary);
+  file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  file.write(reinterpret_cast<const char*>(targets.data()),
+             targets.size() * sizeof(SimPackedTarget));
+  if (!file) {
+    frc::DriverStation::ReportError("Could not write target layout " + path);
+    return false;
+  }
+  return true;
+}
+
+bool SimTargetLayoutFile::ConvertJson(const std::string& jsonPath,
+                                      const std::string& path) {
+  auto layout = FieldLayout::LoadJson(jsonPath);
+  if (layout.Size() == 0) return false;
+  return Write(path, Pack(layout.GetTargets()));
+}
+
+std::vector<SimPackedTarget> SimTargetLayoutFile::Pack(
+    wpi::ArrayRef<FieldTarget> targets) {
+  std::vector<SimPackedTarget> packed;
+  packed.reserve(targets.size());
+  for (auto& tgt : targets) {
+    packed.push_back({tgt.pose.X().to<double>(), tgt.pose.Y().to<double>(),
+                      tgt.pose.Rotation().Radians().to<double>(),
+                      tgt.heightAboveGround.to<double>(),
+                      tgt.width.to<double>(), tgt.height.to<double>()});
+  }
+  return packed;
+}
+
+}  // namespace photonlib
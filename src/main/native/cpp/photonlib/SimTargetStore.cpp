@@ -0,0 +1,267 @@
+/**
+ * Copyright (C) 2020-2021 Photon Vision.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "photonlib/SimTargetStore.h"
+
+#include <algorithm>
+#include <cmath>
+#include <string>
+
+#include <frc/DriverStation.h>
+
+#include "photonlib/SimdBatch.h"
+
+namespace photonlib {
+
+namespace {
+constexpr double kPi = 3.14159265358979323846;
+
+// Relative slack on every test, so that rounding differences from the scalar
+// path can only let extra targets through, never drop visible ones.
+constexpr double kTolerance = 1e-9;
+
+// Tests one batch of targets, returning a bit per lane.
+template <typename B>
+unsigned TestTargets(const SimCameraView& view, const double* xs,
+                     const double* ys, const double* heights,
+                     const double* areas) {
+  B cos = B::Broadcast(view.cos);
+  B sin = B::Broadcast(view.sin);
+  B tolerance = B::Broadcast(kTolerance);
+  B one = B::Broadcast(1.0);
+
+  // Camera-relative position, as Transform2d(cameraPose, targetPose) has it.
+  B dx = B::Load(xs) - B::Broadcast(view.x);
+  B dy = B::Load(ys) - B::Broadcast(view.y);
+  B camX = dx * cos + dy * sin;
+  B camY = dy * cos - dx * sin;
+  B groundSq = camX * camX + camY * camY;
+  B ground = Sqrt(groundSq);
+  B vertical = B::Load(heights) - B::Broadcast(view.height);
+
+  auto inRange =
+      Less(groundSq + vertical * vertical,
+           B::Broadcast(view.rangeSq) + B::Broadcast(view.rangeSq) * tolerance);
+
+  // |atan2(y, x)| < h is |y| cos(h) < x sin(h) for 0 < h <= 180 degrees.
+  B absY = Abs(camY);
+  auto inHoriz = Less(absY * B::Broadcast(view.cosHalfHoriz) -
+                          camX * B::Broadcast(view.sinHalfHoriz),
+                      tolerance * (Abs(camX) + absY + one));
+
+  // Same again for the pitch, after rotating the elevation down by the
+  // camera pitch.
+  B cosPitch = B::Broadcast(view.cosPitch);
+  B sinPitch = B::Broadcast(view.sinPitch);
+  B along = ground * cosPitch + vertical * sinPitch;
+  B absUp = Abs(vertical * cosPitch - ground * sinPitch);
+  auto inVert = Less(absUp * B::Broadcast(view.cosHalfVert) -
+                         along * B::Broadcast(view.sinHalfVert),
+                     tolerance * (Abs(along) + absUp + one));
+
+  // area / (k * ground^2) > minimum, without the division.
+  B area = B::Load(areas);
+  auto bigEnough = Less(B::Broadcast(view.minAreaPerDistSq) * groundSq,
+                        area + area * tolerance);
+
+  return B::Bits(
+      B::And(B::And(inRange, inHoriz), B::And(inVert, bigEnough)));
+}
+}  // namespace
+
+SimCameraView::SimCameraView(const frc::Pose2d& pose, units::meter_t height,
+                             units::radian_t pitch, units::meter_t range,
+                             units::radian_t horizFOV, units::radian_t vertFOV,
+                             double m2PerPxAt1m, double minTargetArea)
+    : pose(pose),
+      range(range),
+      halfHorizFOV(horizFOV / 2),
+      x(pose.X().to<double>()),
+      y(pose.Y().to<double>()),
+      cos(pose.Rotation().Cos()),
+      sin(pose.Rotation().Sin()),
+      height(height.to<double>()),
+      rangeSq(range.to<double>() * range.to<double>()),
+      cosPitch(std::cos(pitch.to<double>())),
+      sinPitch(std::sin(pitch.to<double>())),
+      minAreaPerDistSq(minTargetArea * m2PerPxAt1m) {
+  // Past 180 degrees the half-plane test stops working, but by then
+  // every bearing is in view anyway.
+  double halfHoriz = std::min(halfHorizFOV.to<double>(), kPi);
+  double halfVert = std::min(vertFOV.to<double>() / 2, kPi);
+  cosHalfHoriz = std::cos(halfHoriz);
+  sinHalfHoriz = std::sin(halfHoriz);
+  cosHalfVert = std::cos(halfVert);
+  sinHalfVert = std::sin(halfVert);
+}
+
+size_t ComputeVisibilityMask(const SimCameraView& view, const double* xs,
+                             const double* ys, const double* heights,
+                             const double* areas, size_t count,
+                             uint8_t* visible) {
+  constexpr size_t kWidth = simd::Batch::kWidth;
+  size_t marked = 0;
+  size_t i = 0;
+  for (; i + kWidth <= count; i += kWidth) {
+    unsigned bits = TestTargets<simd::Batch>(view, xs + i, ys + i, heights + i,
+                                             areas + i);
+    for (size_t lane = 0; lane < kWidth; ++lane) {
+      visible[i + lane] = (bits >> lane) & 1;
+      marked += visible[i + lane];
+    }
+  }
+  for (; i < count; ++i) {
+    visible[i] = TestTargets<simd::Scalar>(view, xs + i, ys + i, heights + i,
+                                           areas + i);
+    marked += visible[i];
+  }
+  return marked;
+}
+
+void SimTargetStore::Clear() {
+  targets.clear();
+  xs.clear();
+  ys.clear();
+  heights.clear();
+  areas.clear();
+  generations.clear();
+  freeSlots.clear();
+  grid.Clear();
+}
+
+void SimTargetStore::Reserve(size_t count) {
+  targets.reserve(count);
+  xs.reserve(count);
+  ys.reserve(count);
+  heights.reserve(count);
+  areas.reserve(count);
+  generations.reserve(count);
+}
+
+SimTargetHandle SimTargetStore::Add(const SimVisionTarget& tgt) {
+  if (!freeSlots.empty()) {
+    uint32_t slot = freeSlots.back();
+    freeSlots.pop_back();
+    targets[slot] = tgt;
+    Store(slot, tgt);
+    grid.Move(slot, tgt.targetPos.Translation());
+    return SimTargetHandle{slot, generations[slot]};
+  }
+
+  auto slot = static_cast<uint32_t>(targets.size());
+  targets.push_back(tgt);
+  xs.push_back(0.0);
+  ys.push_back(0.0);
+  heights.push_back(0.0);
+  areas.push_back(0.0);
+  generations.push_back(0);
+  Store(slot, tgt);
+  grid.Insert(tgt.targetPos.Translation());
+  return SimTargetHandle{slot, 0};
+}
+
+bool SimTargetStore::AddBulk(wpi::ArrayRef<SimPackedTarget> packed) {
+  size_t first = targets.size();
+  size_t skipped = 0;
+  Reserve(first + packed.size());
+  for (auto& tgt : packed) {
+    if (!tgt.IsValid()) {
+      ++skipped;
+      continue;
+    }
+    frc::Pose2d targetPos(units::meter_t(tgt.x), units::meter_t(tgt.y),
+                          units::radian_t(tgt.rotation));
+    targets.emplace_back(targetPos, units::meter_t(tgt.heightAboveGround),
+                         units::meter_t(tgt.width),
+                         units::meter_t(tgt.height));
+    xs.push_back(tgt.x);
+    ys.push_back(tgt.y);
+    heights.push_back(tgt.heightAboveGround);
+    areas.push_back(targets.back().tgtArea.to<double>());
+  }
+  generations.resize(targets.size(), 0);
+  grid.InsertBulk(wpi::ArrayRef<double>(xs).drop_front(first),
+                  wpi::ArrayRef<double>(ys).drop_front(first));
+  if (skipped > 0) {
+    frc::DriverStation::ReportError(
+        "Skipped " + std::to_string(skipped) +
+        " simulated targets with non-finite values or non-positive sizes");
+    return false;
+  }
+  return true;
+}
+
+bool SimTargetStore::Update(SimTargetHandle handle,
+                            const SimVisionTarget& tgt) {
+  if (!Contains(handle)) return false;
+  targets[handle.slot] = tgt;
+  Store(handle.slot, tgt);
+  grid.Move(handle.slot, tgt.targetPos.Translation());
+  return true;
+}
+
+bool SimTargetStore::Remove(SimTargetHandle handle) {
+  if (!Contains(handle)) return false;
+  grid.Remove(handle.slot);
+  ++generations[handle.slot];
+  freeSlots.push_back(handle.slot);
+  return true;
+}
+
+void SimTargetStore::Store(size_t slot, const SimVisionTarget& tgt) {
+  xs[slot] = tgt.targetPos.X().to<double>();
+  ys[slot] = tgt.targetPos.Y().to<double>();
+  heights[slot] = tgt.targetHeightAboveGround.to<double>();
+  areas[slot] = tgt.tgtArea.to<double>();
+}
+
+void SimTargetStore::FindCandidates(
+    const SimCameraView& view, Scratch& scratch,
+    wpi::SmallVectorImpl<size_t>& candidates) const {
+  grid.Query(view.pose, view.range, view.halfHorizFOV, scratch.gridHits);
+  FilterCandidates(view, scratch.gridHits, scratch, candidates);
+}
+
+void SimTargetStore::FilterCandidates(
+    const SimCameraView& view, wpi::ArrayRef<size_t> indices,
+    Scratch& scratch, wpi::SmallVectorImpl<size_t>& candidates) const {
+  candidates.clear();
+
+  // Gather the targets into contiguous columns for the kernel.
+  size_t count = indices.size();
+  scratch.xs.resize(count);
+  scratch.ys.resize(count);
+  scratch.heights.resize(count);
+  scratch.areas.resize(count);
+  scratch.visible.resize(count);
+  for (size_t i = 0; i < count; ++i) {
+    size_t index = indices[i];
+    scratch.xs[i] = xs[index];
+    scratch.ys[i] = ys[index];
+    scratch.heights[i] = heights[index];
+    scratch.areas[i] = areas[index];
+  }
+
+  ComputeVisibilityMask(view, scratch.xs.data(), scratch.ys.data(),
+                        scratch.heights.data(), scratch.areas.data(), count,
+                        scratch.visible.data());
+  for (size_t i = 0; i < count; ++i) {
+    if (scratch.visible[i]) candidates.push_back(indices[i]);
+  }
+}
+
+}  // namespace photonlib
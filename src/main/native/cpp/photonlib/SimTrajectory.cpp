@@ -0,0 +1,156 @@
+/**
+ * Copyright (C) 2020-2021 Photon Vision.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "photonlib/SimTrajectory.h"
+
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <string>
+
+#include <frc/DriverStation.h>
+#include <units/angle.h>
+
+#include "photonlib/Packet.h"
+
+namespace photonlib {
+
+namespace {
+// "PVTJ", then the format version.
+constexpr int32_t kMagic = 0x5056544A;
+constexpr int32_t kVersion = 1;
+
+// Parses the next comma-separated number from text, advancing past it. The
+// whole field must be the number, apart from surrounding whitespace.
+bool ParseField(const char*& text, const char* end, double& value) {
+  std::string field;
+  while (text != end && *text != ',') field += *text++;
+  if (text != end) ++text;
+  size_t last = field.find_last_not_of(" \t");
+  if (last == std::string::npos) return false;
+  field.resize(last + 1);
+  // strtod skips the leading whitespace itself.
+  char* parsed;
+  value = std::strtod(field.c_str(), &parsed);
+  return parsed == field.c_str() + field.size();
+}
+
+// Whether any of a line's comma-separated fields is a number.
+bool HasNumericField(wpi::StringRef line) {
+  const char* text = line.data();
+  const char* end = text + line.size();
+  double value;
+  while (text != end) {
+    if (ParseField(text, end, value)) return true;
+  }
+  return false;
+}
+}  // namespace
+
+SimTrajectory SimTrajectory::FromCsv(wpi::StringRef csv) {
+  SimTrajectory trajectory;
+  int lineNumber = 0;
+  while (!csv.empty()) {
+    auto [line, rest] = csv.split('\n');
+    csv = rest;
+    ++lineNumber;
+    line = line.trim();
+    if (line.empty() || line.startswith("#")) continue;
+
+    const char* text = line.data();
+    const char* end = text + line.size();
+    double fields[4];
+    bool valid = true;
+    for (double& field : fields) valid = valid && ParseField(text, end, field);
+    if (!valid) {
+      // The first line may be a header, but not if any field is a number;
+      // then it is a malformed sample.
+      if (lineNumber == 1 && !HasNumericField(line)) continue;
+      frc::DriverStation::ReportError("Could not parse trajectory line " +
+                                      std::to_string(lineNumber));
+      return SimTrajectory();
+    }
+    trajectory.samples.push_back(
+        {units::second_t(fields[0]),
+         frc::Pose2d(units::meter_t(fields[1]), units::meter_t(fields[2]),
+                     units::degree_t(fields[3]))});
+  }
+  return trajectory;
+}
+
+SimTrajectory SimTrajectory::Load(const std::string& path) {
+  std::ifstream file(path, std::ios::binary);
+  if (!file) {
+    frc::DriverStation::ReportError("Could not open trajectory " + path);
+    return SimTrajectory();
+  }
+  std::vector<char> contents{std::istreambuf_iterator<char>(file),
+                             std::istreambuf_iterator<char>()};
+  if (wpi::StringRef(path).endswith(".csv")) {
+    return FromCsv(wpi::StringRef(contents.data(), contents.size()));
+  }
+  return FromBinary(std::move(contents));
+}
+
+SimTrajectory SimTrajectory::FromBinary(std::vector<char> data) {
+  size_t size = data.size();
+  Packet packet(std::move(data));
+  int32_t magic = 0;
+  int32_t version = 0;
+  int32_t count = 0;
+  constexpr size_t kHeaderSize = 3 * sizeof(int32_t);
+  constexpr size_t kSampleSize = 4 * sizeof(double);
+  if (size >= kHeaderSize) packet >> magic >> version >> count;
+  if (magic != kMagic || version != kVersion || count < 0 ||
+      size != kHeaderSize + count * kSampleSize) {
+    frc::DriverStation::ReportError("Could not parse binary trajectory");
+    return SimTrajectory();
+  }
+
+  SimTrajectory trajectory;
+  trajectory.samples.reserve(count);
+  for (int32_t i = 0; i < count; ++i) {
+    double time, x, y, rotation;
+    packet >> time >> x >> y >> rotation;
+    trajectory.samples.push_back(
+        {units::second_t(time),
+         frc::Pose2d(units::meter_t(x), units::meter_t(y),
+                     units::radian_t(rotation))});
+  }
+  return trajectory;
+}
+
+bool SimTrajectory::SaveBinary(const std::string& path) const {
+  Packet packet;
+  packet << kMagic << kVersion << static_cast<int32_t>(samples.size());
+  for (auto& sample : samples) {
+    packet << sample.time.to<double>() << sample.pose.X().to<double>()
+           << sample.pose.Y().to<double>()
+           << sample.pose.Rotation().Radians().to<double>();
+  }
+
+  std::ofstream file(path, std::ios::binary);
+  file.write(packet.GetData().data(), packet.GetDataSize());
+  if (!file) {
+    frc::DriverStation::ReportError("Could not write trajectory " + path);
+    return false;
+  }
+  return true;
+}
+
+}  // namespace photonlib
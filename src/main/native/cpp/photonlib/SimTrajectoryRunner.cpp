@@ -0,0 +1,173 @@
+/**
+ * Copyright (C) 2020-2021 Photon Vision.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "photonlib/SimTrajectoryRunner.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <iterator>
+#include <vector>
+
+#include <frc/DriverStation.h>
+#include <units/math.h>
+
+#include "photonlib/Packet.h"
+
+namespace photonlib {
+
+namespace {
+// "PVRS", then the format version.
+constexpr int32_t kMagic = 0x50565253;
+constexpr int32_t kVersion = 2;
+
+// Reads a big-endian int32, as Packet writes it, at a byte offset.
+int32_t ReadInt32(const std::vector<char>& data, size_t pos) {
+  uint32_t value = 0;
+  for (size_t i = 0; i < sizeof(int32_t); ++i) {
+    value = (value << 8) | static_cast<uint8_t>(data[pos + i]);
+  }
+  return static_cast<int32_t>(value);
+}
+}  // namespace
+
+const SimRunStats& SimTrajectoryRunner::Run(const SimTrajectory& trajectory) {
+  auto samples = trajectory.GetSamples();
+  poses.clear();
+  times.clear();
+  poses.reserve(samples.size());
+  times.reserve(samples.size());
+  for (auto& sample : samples) {
+    poses.push_back(sample.pose);
+    times.push_back(sample.time);
+  }
+  results.resize(samples.size());
+
+  auto start = std::chrono::steady_clock::now();
+  system.ProcessFrames(poses, results, pool);
+  std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - start;
+
+  stats = SimRunStats();
+  stats.frames = results.size();
+  stats.elapsed = units::second_t(elapsed.count());
+
+  // The time of the first frame of the current stretch without targets, if
+  // in one.
+  bool blind = false;
+  units::second_t blindSince{0};
+  for (size_t i = 0; i < results.size(); ++i) {
+    size_t count = results[i].GetTargets().size();
+    if (count > 0) {
+      ++stats.framesWithTargets;
+      stats.targetSightings += count;
+      stats.maxTargetsInFrame = std::max(stats.maxTargetsInFrame, count);
+      if (blind) {
+        stats.longestBlindStretch =
+            units::math::max(stats.longestBlindStretch, times[i] - blindSince);
+        blind = false;
+      }
+    } else if (!blind) {
+      blind = true;
+      blindSince = times[i];
+    }
+  }
+  if (blind) {
+    stats.longestBlindStretch =
+        units::math::max(stats.longestBlindStretch, times.back() - blindSince);
+  }
+  return stats;
+}
+
+bool SimTrajectoryRunner::WriteResults(const std::string& path) const {
+  Packet packet;
+  packet << kMagic << kVersion << static_cast<int32_t>(results.size());
+  // Not the PhotonPipelineResult wire encoding, whose int8 target count
+  // can't hold the crowded frames of a large field.
+  for (size_t i = 0; i < results.size(); ++i) {
+    auto targets = results[i].GetTargets();
+    packet << times[i].to<double>() << results[i].GetLatency().to<double>()
+           << static_cast<int32_t>(targets.size());
+    for (auto& target : targets) packet << target;
+  }
+
+  std::ofstream file(path, std::ios::binary);
+  file.write(packet.GetData().data(), packet.GetDataSize());
+  if (!file) {
+    frc::DriverStation::ReportError("Could not write results " + path);
+    return false;
+  }
+  return true;
+}
+
+bool SimTrajectoryRunner::ReadResults(
+    const std::string& path, std::vector<units::second_t>& times,
+    std::vector<PhotonPipelineResult>& results) {
+  times.clear();
+  results.clear();
+  std::ifstream file(path, std::ios::binary);
+  if (!file) {
+    frc::DriverStation::ReportError("Could not open results " + path);
+    return false;
+  }
+  std::vector<char> contents{std::istreambuf_iterator<char>(file),
+                             std::istreambuf_iterator<char>()};
+  constexpr size_t kHeaderSize = 3 * sizeof(int32_t);
+  Packet packet(contents);
+  int32_t magic = 0;
+  int32_t version = 0;
+  int32_t count = 0;
+  if (contents.size() >= kHeaderSize) packet >> magic >> version >> count;
+  bool valid = magic == kMagic && version == kVersion && count >= 0;
+
+  // Packet doesn't check reads against its size, so walk the frames first:
+  // each is its time, latency and target count, then the targets.
+  constexpr size_t kFrameSize = 2 * sizeof(double) + sizeof(int32_t);
+  constexpr size_t kTargetSize = 7 * sizeof(double);
+  size_t pos = kHeaderSize;
+  for (int32_t i = 0; valid && i < count; ++i) {
+    valid = pos + kFrameSize <= contents.size();
+    if (!valid) break;
+    int32_t targets = ReadInt32(contents, pos + 2 * sizeof(double));
+    pos += kFrameSize;
+    size_t room = (contents.size() - pos) / kTargetSize;
+    valid = targets >= 0 && static_cast<size_t>(targets) <= room;
+    if (valid) pos += targets * kTargetSize;
+  }
+  if (!valid) {
+    frc::DriverStation::ReportError("Could not parse results " + path);
+    return false;
+  }
+
+  times.reserve(count);
+  results.reserve(count);
+  std::vector<PhotonTrackedTarget> targets;
+  for (int32_t i = 0; i < count; ++i) {
+    double time;
+    double latency;
+    int32_t targetCount;
+    packet >> time >> latency >> targetCount;
+    targets.resize(targetCount);
+    for (auto& target : targets) packet >> target;
+    times.emplace_back(time);
+    results.emplace_back(units::second_t(latency), targets);
+  }
+  return true;
+}
+
+}  // namespace photonlib
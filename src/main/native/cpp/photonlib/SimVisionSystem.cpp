@@ -19,11 +19,19 @@
 
 #include <cmath>
 
+#include <frc/DriverStation.h>
 #include <units/angle.h>
 #include <units/length.h>
 
+#include "photonlib/PhotonTrace.h"
+#include "photonlib/SimFrameRenderer.h"
+
 namespace photonlib {
 
+namespace {
+constexpr double kDegreesPerRadian = 180.0 / 3.14159265358979323846;
+}  // namespace
+
 SimVisionSystem::SimVisionSystem(const std::string& name,
                                  units::degree_t camDiagFOV,
                                  units::degree_t camPitch,
@@ -42,13 +50,65 @@ SimVisionSystem::SimVisionSystem(const std::string& name,
   double hypotPixels = std::hypot(cameraResWidth, cameraResHeight);
   camHorizFOV = camDiagFOV * cameraResWidth / hypotPixels;
   camVertFOV = camDiagFOV * cameraResHeight / hypotPixels;
+  UpdateCameraConstants();
 
   cam = SimPhotonCamera(name);
-  tgtList.clear();
+  tgtStore.Clear();
+}
+
+// Defined here, where SimFrameRenderer and cs::CvSource are complete.
+SimVisionSystem::~SimVisionSystem() = default;
+SimVisionSystem::SimVisionSystem(SimVisionSystem&&) = default;
+SimVisionSystem& SimVisionSystem::operator=(SimVisionSystem&&) = default;
+
+SimTargetHandle SimVisionSystem::AddSimVisionTarget(SimVisionTarget tgt) {
+  if (RejectIfMounted("AddSimVisionTarget")) return SimTargetHandle{};
+  return tgtStore.Add(tgt);
+}
+
+bool SimVisionSystem::UpdateTarget(SimTargetHandle handle,
+                                   const SimVisionTarget& tgt) {
+  if (RejectIfMounted("UpdateTarget")) return false;
+  return tgtStore.Update(handle, tgt);
+}
+
+bool SimVisionSystem::RemoveTarget(SimTargetHandle handle) {
+  if (RejectIfMounted("RemoveTarget")) return false;
+  return tgtStore.Remove(handle);
+}
+
+void SimVisionSystem::AddFieldLayout(const FieldLayout& layout) {
+  if (RejectIfMounted("AddFieldLayout")) return;
+  tgtStore.AddBulk(SimTargetLayoutFile::Pack(layout.GetTargets()));
+}
+
+void SimVisionSystem::AddTargetLayout(const SimTargetLayoutFile& layout) {
+  if (RejectIfMounted("AddTargetLayout")) return;
+  tgtStore.AddBulk(layout.GetTargets());
+}
+
+bool SimVisionSystem::AddTargets(wpi::ArrayRef<SimPackedTarget> targets) {
+  if (RejectIfMounted("AddTargets")) return false;
+  return tgtStore.AddBulk(targets);
+}
+
+void SimVisionSystem::AddObstacles(wpi::ArrayRef<SimObstacle> newObstacles) {
+  if (RejectIfMounted("AddObstacles")) return;
+  obstacles.Add(newObstacles);
+}
+
+void SimVisionSystem::AddObstacle(const SimObstacle& obstacle) {
+  if (RejectIfMounted("AddObstacle")) return;
+  obstacles.Add(obstacle);
 }
 
-void SimVisionSystem::AddSimVisionTarget(SimVisionTarget tgt) {
-  tgtList.push_back(tgt);
+bool SimVisionSystem::RejectIfMounted(const char* method) const {
+  if (!mountedOnRobot) return false;
+  frc::DriverStation::ReportError(
+      std::string("SimVisionSystem::") + method +
+      " does nothing on a camera of a SimRobotVision; call the "
+      "SimRobotVision's instead");
+  return true;
 }
 
 void SimVisionSystem::MoveCamera(frc::Transform2d newCameraToRobot,
@@ -57,61 +117,297 @@ void SimVisionSystem::MoveCamera(frc::Transform2d newCameraToRobot,
   cameraToRobot = newCameraToRobot;
   cameraHeightOffGround = newCamHeight;
   camPitch = newCamPitch;
+  UpdateCameraConstants();
+}
+
+void SimVisionSystem::UpdateCameraConstants() {
+  constants.robotToCamera = cameraToRobot.Inverse();
+  constants.height = cameraHeightOffGround.to<double>();
+  constants.pitch = units::degree_t(camPitch).to<double>();
+  constants.halfHorizFOV = units::degree_t(camHorizFOV).to<double>() / 2;
+  constants.halfVertFOV = units::degree_t(camVertFOV).to<double>() / 2;
+  constants.range = maxLEDRange.to<double>();
+
+  double heightMPerPx = 2 * units::math::tan(camVertFOV / 2) / cameraResHeight;
+  double widthMPerPx = 2 * units::math::tan(camHorizFOV / 2) / cameraResWidth;
+  constants.m2PerPxAt1m = widthMPerPx * heightMPerPx;
+
+  if (intrinsics) {
+    // Part of a target can be in the image while its center is well outside
+    // it, so only cull on range and leave the rest to the projection.
+    constants.cullView = SimCameraView(
+        frc::Pose2d(), cameraHeightOffGround, camPitch, maxLEDRange,
+        units::degree_t(360.0), units::degree_t(360.0), 0.0, 0.0);
+  } else {
+    constants.cullView = SimCameraView(
+        frc::Pose2d(), cameraHeightOffGround, camPitch, maxLEDRange,
+        camHorizFOV, camVertFOV, constants.m2PerPxAt1m, minTargetArea);
+  }
 }
 
 void SimVisionSystem::ProcessFrame(frc::Pose2d robotPose) {
-  frc::Pose2d cameraPos = robotPose.TransformBy(cameraToRobot.Inverse());
-  std::vector<PhotonTrackedTarget> visibleTgtList = {};
+  PHOTON_TRACE_SCOPE("SimVisionSystem::ProcessFrame");
+  if (RejectIfMounted("ProcessFrame")) return;
+  ComputeFrame(robotPose, frameCount++, scratch);
+  if (renderer) RenderFrame(robotPose, tgtStore, scratch.visibleIdxs);
+  cam.SubmitProcessedFrame(units::second_t(0.0), scratch.visibleTgtList);
+}
+
+void SimVisionSystem::ProcessFrame(frc::Pose2d robotPose,
+                                   units::second_t now) {
+  PHOTON_TRACE_SCOPE("SimVisionSystem::ProcessFrame");
+  if (RejectIfMounted("ProcessFrame")) return;
+  if (scheduler.ShouldCapture(now)) {
+    ComputeFrame(robotPose, frameCount++, scratch);
+    if (renderer) RenderFrame(robotPose, tgtStore, scratch.visibleIdxs);
+    scheduler.Submit(now, scratch.visibleTgtList);
+  }
+
+  // Publish in completion order; a slow robot loop may find several done.
+  SimPendingFrame frame;
+  while (scheduler.PopCompleted(now, &frame)) {
+    cam.SubmitProcessedFrame(now - frame.captureTime, frame.targets);
+  }
+}
+
+void SimVisionSystem::SetCameraIntrinsics(
+    const SimCameraIntrinsics& newIntrinsics) {
+  intrinsics = newIntrinsics;
+  distortion.reset();
+  cameraResWidth = newIntrinsics.width;
+  cameraResHeight = newIntrinsics.height;
+  camHorizFOV = newIntrinsics.HorizontalFOV();
+  camVertFOV = newIntrinsics.VerticalFOV();
+  UpdateCameraConstants();
+}
+
+void SimVisionSystem::SetCameraIntrinsics(
+    const SimCameraIntrinsics& newIntrinsics,
+    const SimDistortionCoefficients& coefficients) {
+  SetCameraIntrinsics(newIntrinsics);
+  distortion.emplace(newIntrinsics, coefficients);
+
+  // Barrel distortion squeezes a wider view into the same image.
+  const SimImageBounds& bounds = distortion->GetIdealBounds();
+  camHorizFOV = units::radian_t(
+      std::atan2(newIntrinsics.cx - bounds.minU, newIntrinsics.fx) +
+      std::atan2(bounds.maxU - newIntrinsics.cx, newIntrinsics.fx));
+  camVertFOV = units::radian_t(
+      std::atan2(newIntrinsics.cy - bounds.minV, newIntrinsics.fy) +
+      std::atan2(bounds.maxV - newIntrinsics.cy, newIntrinsics.fy));
+  UpdateCameraConstants();
+}
+
+void SimVisionSystem::EnableFrameRendering(SimFrameFormat format) {
+  renderer = std::make_unique<SimFrameRenderer>(cameraResWidth,
+                                                cameraResHeight, format);
+}
+
+void SimVisionSystem::SetFrameSource(cs::CvSource source) {
+  frameSource = std::make_unique<cs::CvSource>(source);
+  if (!renderer) EnableFrameRendering();
+}
+
+void SimVisionSystem::RenderFrame(const frc::Pose2d& robotPose,
+                                  const SimTargetStore& targets,
+                                  wpi::ArrayRef<size_t> visibleIdxs) {
+  // The FOV model has no intrinsics of its own; draw it as the ideal camera
+  // with the same field of view.
+  SimCameraIntrinsics cameraIntrinsics =
+      intrinsics ? *intrinsics
+                 : SimCameraIntrinsics::FromFOV(camDiagFOV, cameraResWidth,
+                                                cameraResHeight);
+  if (renderer->GetWidth() != cameraIntrinsics.width ||
+      renderer->GetHeight() != cameraIntrinsics.height) {
+    renderer = std::make_unique<SimFrameRenderer>(
+        cameraIntrinsics.width, cameraIntrinsics.height, renderer->GetFormat());
+  }
+
+  frc::Pose2d cameraPos = robotPose.TransformBy(constants.robotToCamera);
+  SimPinholeView view(cameraPos, cameraHeightOffGround, camPitch,
+                      cameraIntrinsics, distortion ? &*distortion : nullptr);
+  renderer->Render(view, targets, visibleIdxs);
+  if (frameSource) renderer->PutFrame(*frameSource);
+}
+
+void SimVisionSystem::SetFrameRate(units::hertz_t frameRate) {
+  scheduler.SetFrameRate(frameRate);
+}
+
+void SimVisionSystem::SetLatency(units::second_t mean,
+                                 units::second_t stdDev) {
+  scheduler.SetLatency(mean, stdDev);
+}
+
+void SimVisionSystem::SetFrameDropRate(double dropRate) {
+  scheduler.SetDropRate(dropRate);
+}
+
+void SimVisionSystem::SetTimingSeed(uint64_t seed) { scheduler.Reseed(seed); }
+
+void SimVisionSystem::ResetTiming() { scheduler.Reset(); }
+
+void SimVisionSystem::SetNoiseModel(const SimNoiseModel& model) {
+  noise = model;
+}
+
+void SimVisionSystem::ProcessFrames(
+    wpi::ArrayRef<frc::Pose2d> robotPoses,
+    wpi::MutableArrayRef<PhotonPipelineResult> results,
+    WorkStealingPool& pool) {
+  PHOTON_TRACE_SCOPE("SimVisionSystem::ProcessFrames");
+  if (RejectIfMounted("ProcessFrames")) return;
+  if (robotPoses.size() != results.size()) {
+    frc::DriverStation::ReportError(
+        "SimVisionSystem::ProcessFrames needs one result per robot pose");
+    return;
+  }
+
+  // Grown to the largest pool seen and kept, so repeated batches reuse the
+  // candidate and target buffers instead of reallocating them.
+  if (workerScratch.size() < pool.Size()) workerScratch.resize(pool.Size());
+  pool.ParallelFor(robotPoses.size(), [&](size_t worker, size_t i) {
+    FrameScratch& frame = workerScratch[worker];
+    ComputeFrame(robotPoses[i], frameCount + i, frame);
+    results[i] = PhotonPipelineResult(units::second_t(0.0),
+                                      frame.visibleTgtList);
+  });
+  frameCount += robotPoses.size();
+}
+
+void SimVisionSystem::ComputeFrame(const frc::Pose2d& robotPose,
+                                   uint64_t frameIndex,
+                                   FrameScratch& frame) const {
+  frc::Pose2d cameraPos = robotPose.TransformBy(constants.robotToCamera);
+
+  // Skip targets the grid and visibility kernel rule out before doing any
+  // per-target trig. What's left is checked exactly below.
+  tgtStore.FindCandidates(MakeView(cameraPos), frame.store,
+                          frame.candidateIdxs);
+  EvaluateCandidates(cameraPos, tgtStore, obstacles, frameIndex, frame);
+}
+
+SimCameraView SimVisionSystem::MakeView(const frc::Pose2d& cameraPos) const {
+  SimCameraView view = constants.cullView;
+  view.SetPose(cameraPos);
+  return view;
+}
+
+void SimVisionSystem::EvaluateCandidates(const frc::Pose2d& cameraPos,
+                                         const SimTargetStore& targets,
+                                         const SimObstacleBvh& occluders,
+                                         uint64_t frameIndex,
+                                         FrameScratch& frame) const {
+  frame.visibleTgtList.clear();
+  frame.visibleIdxs.clear();
+  if (intrinsics) {
+    EvaluateProjected(cameraPos, targets, occluders, frame);
+    noise.Apply(frameIndex, camHorizFOV, camVertFOV, frame.visibleTgtList,
+                100.0 / (intrinsics->width * intrinsics->height));
+    return;
+  }
 
-  for (auto&& tgt : tgtList) {
-    frc::Transform2d camToTargetTrans =
-        frc::Transform2d(cameraPos, tgt.targetPos);
+  double camX = cameraPos.X().to<double>();
+  double camY = cameraPos.Y().to<double>();
+  double cos = cameraPos.Rotation().Cos();
+  double sin = cameraPos.Rotation().Sin();
+  // Rotating by this is subtracting the camera's heading, without the trig
+  // Rotation2d::operator- would redo for every target.
+  frc::Rotation2d fieldToCamera = -cameraPos.Rotation();
+  for (auto idx : frame.candidateIdxs) {
+    // Camera-relative position, as Transform2d(cameraPos, targetPos) has it.
+    double dx = targets.GetX(idx) - camX;
+    double dy = targets.GetY(idx) - camY;
+    double relX = dx * cos + dy * sin;
+    double relY = dy * cos - dx * sin;
 
-    units::meter_t distAlongGround = camToTargetTrans.Translation().Norm();
-    units::meter_t distVertical =
-        tgt.targetHeightAboveGround - cameraHeightOffGround;
-    units::meter_t distHypot =
-        units::math::hypot(distAlongGround, distVertical);
+    double distAlongGround = std::hypot(relX, relY);
+    double distVertical = targets.GetHeight(idx) - constants.height;
+    double distHypot = std::hypot(distAlongGround, distVertical);
 
-    double area = tgt.tgtArea.to<double>() / GetM2PerPx(distAlongGround);
+    double area = targets.GetArea(idx) / (constants.m2PerPxAt1m *
+                                          distAlongGround * distAlongGround);
 
     // 2D yaw mode considers the target as a point, and should ignore target
     // rotation.
     // Photon reports it in the correct robot reference frame.
     // IE: targets to the left of the image should report negative yaw.
-    units::degree_t yawAngle =
-        -1.0 * units::math::atan2(camToTargetTrans.Translation().Y(),
-                                  camToTargetTrans.Translation().X());
-    units::degree_t pitchAngle =
-        units::math::atan2(distVertical, distAlongGround) - camPitch;
-
-    if (CamCanSeeTarget(distHypot, yawAngle, pitchAngle, area)) {
-      PhotonTrackedTarget newTgt =
-          PhotonTrackedTarget(yawAngle.to<double>(), pitchAngle.to<double>(),
-                              area, 0.0, camToTargetTrans);
-      visibleTgtList.push_back(newTgt);
+    double yawAngle = -std::atan2(relY, relX) * kDegreesPerRadian;
+    double pitchAngle = std::atan2(distVertical, distAlongGround) *
+                            kDegreesPerRadian -
+                        constants.pitch;
+
+    if (!CamCanSeeTarget(distHypot, yawAngle, pitchAngle, area)) continue;
+    auto& tgt = targets[idx];
+    if (occluders.Occludes(cameraPos.Translation(), cameraHeightOffGround,
+                           tgt.targetPos.Translation(),
+                           tgt.targetHeightAboveGround)) {
+      continue;
     }
+    frame.visibleTgtList.emplace_back(
+        yawAngle, pitchAngle, area, 0.0,
+        frc::Transform2d(
+            frc::Translation2d(units::meter_t(relX), units::meter_t(relY)),
+            tgt.targetPos.Rotation().RotateBy(fieldToCamera)));
+    frame.visibleIdxs.push_back(idx);
   }
 
-  units::second_t procDelay(0.0);  // Future - tie this to something meaningful
-  cam.SubmitProcessedFrame(
-      procDelay, wpi::MutableArrayRef<PhotonTrackedTarget>(visibleTgtList));
+  noise.Apply(frameIndex, camHorizFOV, camVertFOV, frame.visibleTgtList);
 }
 
-double SimVisionSystem::GetM2PerPx(units::meter_t dist) {
-  double heightMPerPx = 2 * dist.to<double>() *
-                        units::math::tan(camVertFOV / 2) / cameraResHeight;
-  double widthMPerPx = 2 * dist.to<double>() *
-                       units::math::tan(camHorizFOV / 2) / cameraResWidth;
-  return widthMPerPx * heightMPerPx;
+void SimVisionSystem::EvaluateProjected(const frc::Pose2d& cameraPos,
+                                        const SimTargetStore& targets,
+                                        const SimObstacleBvh& occluders,
+                                        FrameScratch& frame) const {
+  size_t count = frame.candidateIdxs.size();
+  frame.geometry.Resize(count);
+  for (size_t i = 0; i < count; ++i) {
+    frame.geometry.Set(i, targets[frame.candidateIdxs[i]]);
+  }
+  SimPinholeView view(cameraPos, cameraHeightOffGround, camPitch, *intrinsics,
+                      distortion ? &*distortion : nullptr);
+  ProjectTargets(view, frame.geometry, count, frame.projected);
+
+  double imageArea = intrinsics->width * intrinsics->height;
+  for (size_t i = 0; i < count; ++i) {
+    if (frame.projected.status[i] == SimProjectedTargets::kHidden) continue;
+
+    size_t idx = frame.candidateIdxs[i];
+    double distHypot =
+        std::hypot(std::hypot(targets.GetX(idx) - cameraPos.X().to<double>(),
+                              targets.GetY(idx) - cameraPos.Y().to<double>()),
+                   targets.GetHeight(idx) - constants.height);
+    if (distHypot >= constants.range) continue;
+
+    SimProjectedShape shape = MeasureProjectedTarget(view, frame.projected, i);
+    double area = 100.0 * shape.area / imageArea;
+    auto& tgt = targets[idx];
+    // minTargetArea is in pixels, as in the FOV model.
+    if (shape.area <= minTargetArea ||
+        occluders.Occludes(cameraPos.Translation(), cameraHeightOffGround,
+                           tgt.targetPos.Translation(),
+                           tgt.targetHeightAboveGround)) {
+      continue;
+    }
+
+    // Targets left of and below the image center have negative yaw and
+    // pitch, as in EvaluateCandidates.
+    units::degree_t yawAngle = units::radian_t(
+        std::atan2(shape.centerU - intrinsics->cx, intrinsics->fx));
+    units::degree_t pitchAngle = units::radian_t(
+        std::atan2(intrinsics->cy - shape.centerV, intrinsics->fy));
+    frame.visibleTgtList.push_back(PhotonTrackedTarget(
+        yawAngle.to<double>(), pitchAngle.to<double>(), area,
+        shape.skew.to<double>(), frc::Transform2d(cameraPos, tgt.targetPos)));
+    frame.visibleIdxs.push_back(idx);
+  }
 }
 
-bool SimVisionSystem::CamCanSeeTarget(units::meter_t distHypot,
-                                      units::degree_t yaw,
-                                      units::degree_t pitch, double area) {
-  bool inRange = (distHypot < maxLEDRange);
-  bool inHorizAngle = units::math::abs(yaw) < (camHorizFOV / 2);
-  bool inVertAngle = units::math::abs(pitch) < (camVertFOV / 2);
+bool SimVisionSystem::CamCanSeeTarget(double distHypot, double yaw,
+                                      double pitch, double area) const {
+  bool inRange = distHypot < constants.range;
+  bool inHorizAngle = std::abs(yaw) < constants.halfHorizFOV;
+  bool inVertAngle = std::abs(pitch) < constants.halfVertFOV;
   bool targetBigEnough = area > minTargetArea;
   return (inRange && inHorizAngle && inVertAngle && targetBigEnough);
 }
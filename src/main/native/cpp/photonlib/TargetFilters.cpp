@@ -0,0 +1,155 @@
+/**
+ * Copyright (C) 2020-2021 Photon Vision.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "photonlib/TargetFilters.h"
+
+#include <algorithm>
+
+namespace photonlib {
+
+MovingAverageFilter::MovingAverageFilter(size_t window)
+    : values(std::max<size_t>(window, 1)) {}
+
+double MovingAverageFilter::Calculate(double value) {
+  if (count == values.size()) {
+    sum -= values[next];
+  } else {
+    ++count;
+  }
+  values[next] = value;
+  sum += value;
+  next = (next + 1) % values.size();
+  return sum / count;
+}
+
+MovingMedianFilter::MovingMedianFilter(size_t window)
+    : values(std::max<size_t>(window, 1)),
+      lower(values.size()),
+      upper(values.size()),
+      inUpper(values.size()),
+      heapPos(values.size()) {}
+
+bool MovingMedianFilter::Before(bool isUpper, size_t a, size_t b) const {
+  return isUpper ? values[a] < values[b] : values[a] > values[b];
+}
+
+void MovingMedianFilter::Place(bool isUpper, size_t pos, size_t slot) {
+  (isUpper ? upper : lower)[pos] = slot;
+  inUpper[slot] = isUpper;
+  heapPos[slot] = pos;
+}
+
+void MovingMedianFilter::SiftUp(bool isUpper, size_t pos) {
+  auto& heap = isUpper ? upper : lower;
+  size_t slot = heap[pos];
+  while (pos > 0) {
+    size_t parent = (pos - 1) / 2;
+    if (!Before(isUpper, slot, heap[parent])) break;
+    Place(isUpper, pos, heap[parent]);
+    pos = parent;
+  }
+  Place(isUpper, pos, slot);
+}
+
+void MovingMedianFilter::SiftDown(bool isUpper, size_t pos) {
+  auto& heap = isUpper ? upper : lower;
+  size_t size = isUpper ? upperSize : lowerSize;
+  size_t slot = heap[pos];
+  while (true) {
+    size_t child = 2 * pos + 1;
+    if (child >= size) break;
+    if (child + 1 < size && Before(isUpper, heap[child + 1], heap[child])) {
+      ++child;
+    }
+    if (!Before(isUpper, heap[child], slot)) break;
+    Place(isUpper, pos, heap[child]);
+    pos = child;
+  }
+  Place(isUpper, pos, slot);
+}
+
+void MovingMedianFilter::Push(bool isUpper, size_t slot) {
+  size_t& size = isUpper ? upperSize : lowerSize;
+  Place(isUpper, size, slot);
+  SiftUp(isUpper, size++);
+}
+
+size_t MovingMedianFilter::Pop(bool isUpper) {
+  size_t top = (isUpper ? upper : lower)[0];
+  Remove(top);
+  return top;
+}
+
+void MovingMedianFilter::Remove(size_t slot) {
+  bool isUpper = inUpper[slot];
+  auto& heap = isUpper ? upper : lower;
+  size_t& size = isUpper ? upperSize : lowerSize;
+  size_t pos = heapPos[slot];
+  --size;
+  if (pos == size) return;
+
+  // Fill the hole with the last element and restore the heap in whichever
+  // direction it moved.
+  size_t moved = heap[size];
+  Place(isUpper, pos, moved);
+  SiftUp(isUpper, pos);
+  SiftDown(isUpper, heapPos[moved]);
+}
+
+double MovingMedianFilter::Calculate(double value) {
+  size_t slot = next;
+  if (count == values.size()) {
+    Remove(slot);
+  } else {
+    ++count;
+  }
+  next = (next + 1) % values.size();
+
+  values[slot] = value;
+  bool toUpper = lowerSize > 0 && value > values[lower[0]];
+  Push(toUpper, slot);
+
+  // Keep the lower half equal in size to, or one larger than, the upper.
+  if (lowerSize > upperSize + 1) {
+    Push(true, Pop(false));
+  } else if (upperSize > lowerSize) {
+    Push(false, Pop(true));
+  }
+
+  if (lowerSize > upperSize) return values[lower[0]];
+  return (values[lower[0]] + values[upper[0]]) / 2.0;
+}
+
+double KalmanFilter1d::Calculate(double value) {
+  if (!initialized) {
+    estimate = value;
+    errorVariance = measurementVariance;
+    initialized = true;
+    return estimate;
+  }
+
+  // Predict: the value may have wandered since the last measurement.
+  errorVariance += processVariance;
+
+  // Update: blend in the measurement by the relative confidence.
+  double gain = errorVariance / (errorVariance + measurementVariance);
+  estimate += gain * (value - estimate);
+  errorVariance *= 1.0 - gain;
+  return estimate;
+}
+
+}  // namespace photonlib
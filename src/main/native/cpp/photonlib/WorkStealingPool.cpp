@@ -0,0 +1,168 @@
+/**
+ * Copyright (C) 2020-2021 Photon Vision.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "photonlib/WorkStealingPool.h"
+
+#include <algorithm>
+
+namespace photonlib {
+
+namespace {
+// Ranges are packed into 32-bit halves, so longer loops run in rounds.
+constexpr size_t kMaxRound = UINT32_MAX;
+
+// The most indices a worker takes from its own range at once. Small enough
+// that there is always something left to steal near the end of a loop.
+constexpr uint32_t kMaxChunk = 64;
+
+uint64_t Pack(uint64_t begin, uint64_t end) { return begin << 32 | end; }
+uint32_t Begin(uint64_t bounds) { return static_cast<uint32_t>(bounds >> 32); }
+uint32_t End(uint64_t bounds) { return static_cast<uint32_t>(bounds); }
+}  // namespace
+
+WorkStealingPool::WorkStealingPool(size_t numWorkers) {
+  if (numWorkers == 0) {
+    numWorkers = std::max(std::thread::hardware_concurrency(), 1u);
+  }
+  ranges = std::make_unique<Range[]>(numWorkers);
+  threads.reserve(numWorkers - 1);
+  for (size_t i = 1; i < numWorkers; ++i) {
+    threads.emplace_back([this, i] { WorkerLoop(i); });
+  }
+}
+
+WorkStealingPool::~WorkStealingPool() {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    stopping = true;
+  }
+  wake.notify_all();
+  for (auto& thread : threads) thread.join();
+}
+
+WorkStealingPool& WorkStealingPool::GetDefault() {
+  static WorkStealingPool pool;
+  return pool;
+}
+
+void WorkStealingPool::ParallelFor(size_t count, const Body& body) {
+  if (threads.empty()) {
+    for (size_t i = 0; i < count; ++i) body(0, i);
+    return;
+  }
+
+  std::lock_guard<std::mutex> call(callMutex);
+  size_t workers = Size();
+  for (size_t base = 0; base < count; base += kMaxRound) {
+    size_t roundCount = std::min(count - base, kMaxRound);
+    for (size_t w = 0; w < workers; ++w) {
+      ranges[w].bounds.store(Pack(roundCount * w / workers,
+                                  roundCount * (w + 1) / workers),
+                             std::memory_order_relaxed);
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      job = &body;
+      jobBase = base;
+      active = threads.size();
+      ++generation;
+    }
+    wake.notify_all();
+
+    Run(0, body, base);
+
+    std::unique_lock<std::mutex> lock(mutex);
+    done.wait(lock, [this] { return active == 0; });
+    job = nullptr;
+  }
+}
+
+void WorkStealingPool::WorkerLoop(size_t worker) {
+  uint64_t seen = 0;
+  while (true) {
+    const Body* body;
+    size_t base;
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      wake.wait(lock, [&] { return stopping || generation != seen; });
+      if (stopping) return;
+      seen = generation;
+      body = job;
+      base = jobBase;
+    }
+
+    Run(worker, *body, base);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if (--active == 0) done.notify_one();
+  }
+}
+
+void WorkStealingPool::Run(size_t worker, const Body& body, size_t base) {
+  uint32_t begin;
+  uint32_t end;
+  do {
+    while (Take(worker, &begin, &end)) {
+      for (uint32_t i = begin; i < end; ++i) body(worker, base + i);
+    }
+  } while (Steal(worker));
+}
+
+bool WorkStealingPool::Take(size_t worker, uint32_t* begin, uint32_t* end) {
+  auto& bounds = ranges[worker].bounds;
+  uint64_t current = bounds.load(std::memory_order_acquire);
+  while (true) {
+    uint32_t b = Begin(current);
+    uint32_t e = End(current);
+    if (b >= e) return false;
+    uint32_t chunk = std::min(std::max((e - b) / 8, 1u), kMaxChunk);
+    if (bounds.compare_exchange_weak(current, Pack(b + chunk, e),
+                                     std::memory_order_acq_rel,
+                                     std::memory_order_acquire)) {
+      *begin = b;
+      *end = b + chunk;
+      return true;
+    }
+  }
+}
+
+bool WorkStealingPool::Steal(size_t worker) {
+  size_t workers = Size();
+  for (size_t offset = 1; offset < workers; ++offset) {
+    auto& victim = ranges[(worker + offset) % workers].bounds;
+    uint64_t current = victim.load(std::memory_order_acquire);
+    while (true) {
+      uint32_t b = Begin(current);
+      uint32_t e = End(current);
+      if (b >= e) break;
+
+      // Take the back half, or the last index.
+      uint32_t mid = b + (e - b) / 2;
+      if (victim.compare_exchange_weak(current, Pack(b, mid),
+                                       std::memory_order_acq_rel,
+                                       std::memory_order_acquire)) {
+        // Only this worker refills its own range, and only once it's empty.
+        ranges[worker].bounds.store(Pack(mid, e), std::memory_order_release);
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+}  // namespace photonlib
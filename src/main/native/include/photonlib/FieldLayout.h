@@ -0,0 +1,172 @@
+/**
+ * Copyright (C) 2020-2021 Photon Vision.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include <frc/geometry/Pose2d.h>
+#include <frc/geometry/Transform2d.h>
+#include <frc/geometry/Translation2d.h>
+#include <units/length.h>
+#include <wpi/ArrayRef.h>
+#include <wpi/StringRef.h>
+
+#include "photonlib/PhotonTrackedTarget.h"
+
+namespace photonlib {
+
+/**
+ * A known vision target on the field.
+ */
+struct FieldTarget {
+  /** The position of the target in the field coordinate system. */
+  frc::Pose2d pose;
+  /** The height of the target's center off the floor. */
+  units::meter_t heightAboveGround;
+  /** The physical width of the target. */
+  units::meter_t width;
+  /** The physical height of the target. */
+  units::meter_t height;
+};
+
+/**
+ * A registry of the known targets on a field. Targets are held in a static
+ * 2D k-d tree so that a detection can be associated with the field target it
+ * most likely belongs to in O(log n).
+ *
+ * Layouts may be loaded from JSON of the form:
+ * <pre>
+ * {
+ *   "targets": [
+ *     {"x": 15.98, "y": 2.4, "rotation": 180.0,
+ *      "heightAboveGround": 2.5, "width": 1.0, "height": 0.43}
+ *   ]
+ * }
+ * </pre>
+ * where lengths are in meters and rotation is in degrees.
+ */
+class FieldLayout {
+ public:
+  /**
+   * Constructs an empty layout.
+   */
+  FieldLayout() = default;
+
+  /**
+   * Constructs a layout from a list of targets.
+   * @param targets The targets on the field.
+   */
+  explicit FieldLayout(wpi::ArrayRef<FieldTarget> targets);
+
+  /**
+   * Parses a layout from a JSON string. Malformed input is reported to the
+   * driver station and yields an empty layout.
+   * @param json The JSON text.
+   * @return The parsed layout.
+   */
+  static FieldLayout FromJson(wpi::StringRef json);
+
+  /**
+   * Loads a layout from a JSON file. A missing or malformed file is reported
+   * to the driver station and yields an empty layout.
+   * @param path The path of the JSON file.
+   * @return The loaded layout.
+   */
+  static FieldLayout LoadJson(const std::string& path);
+
+  /**
+   * Returns the targets in this layout, in the order they were added.
+   * @return The targets in this layout.
+   */
+  wpi::ArrayRef<FieldTarget> GetTargets() const { return targets; }
+
+  /**
+   * Returns the number of targets in this layout.
+   * @return The number of targets.
+   */
+  size_t Size() const { return targets.size(); }
+
+  /**
+   * Finds the target closest to a point on the field.
+   *
+   * @param point       The field-relative point to search around.
+   * @param maxDistance Targets further than this from the point are ignored.
+   * @return The index of the closest target, or -1 if none is close enough.
+   */
+  int FindNearest(const frc::Translation2d& point,
+                  units::meter_t maxDistance) const;
+
+  /**
+   * Finds the field target a detection most likely belongs to.
+   *
+   * @param robotPose      A rough estimate of the robot pose, likely from
+   *                       odometry.
+   * @param cameraToRobot  The position of the robot relative to the camera.
+   * @param cameraToTarget The translation of the target relative to the
+   *                       camera, e.g. from
+   *                       PhotonUtils::EstimateCameraToTargetTranslation.
+   * @param maxDistance    The largest allowed error between the predicted and
+   *                       the known target position.
+   * @return The index of the associated target, or -1 if none is close enough.
+   */
+  int Associate(const frc::Pose2d& robotPose,
+                const frc::Transform2d& cameraToRobot,
+                const frc::Translation2d& cameraToTarget,
+                units::meter_t maxDistance) const;
+
+  /**
+   * Finds the field target a detection most likely belongs to, using the
+   * camera-relative pose reported with the target.
+   *
+   * @param robotPose     A rough estimate of the robot pose, likely from
+   *                      odometry.
+   * @param cameraToRobot The position of the robot relative to the camera.
+   * @param target        The detected target.
+   * @param maxDistance   The largest allowed error between the predicted and
+   *                      the known target position.
+   * @return The index of the associated target, or -1 if none is close enough.
+   */
+  int Associate(const frc::Pose2d& robotPose,
+                const frc::Transform2d& cameraToRobot,
+                const PhotonTrackedTarget& target,
+                units::meter_t maxDistance) const {
+    return Associate(robotPose, cameraToRobot,
+                     target.GetCameraRelativePose().Translation(),
+                     maxDistance);
+  }
+
+ private:
+  struct KdNode {
+    double x;
+    double y;
+    int index;
+  };
+
+  std::vector<FieldTarget> targets;
+  // Implicit k-d tree: the median of each range [lo, hi) sits at its middle,
+  // split on x at even depths and y at odd depths.
+  std::vector<KdNode> tree;
+
+  void Build(size_t lo, size_t hi, int depth);
+  void Search(size_t lo, size_t hi, int depth, double x, double y, int& best,
+              double& bestDist2) const;
+};
+
+}  // namespace photonlib
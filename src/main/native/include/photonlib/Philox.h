@@ -0,0 +1,79 @@
+/**
+ * Copyright (C) 2020-2021 Photon Vision.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+namespace photonlib {
+
+/**
+ * The Philox4x32-10 counter-based random number generator (Salmon et al.,
+ * "Parallel Random Numbers: As Easy as 1, 2, 3").
+ *
+ * There is no state to advance: each 128-bit counter maps to four random
+ * words, so a value can be drawn for any (frame, target) pair directly.
+ * Results don't depend on the order values are drawn in or which thread
+ * draws them, and the branch-free rounds vectorize across counters.
+ */
+class Philox4x32 {
+ public:
+  using Block = std::array<uint32_t, 4>;
+
+  /**
+   * Constructs a generator.
+   * @param seed The key; different seeds give independent streams.
+   */
+  explicit constexpr Philox4x32(uint64_t seed)
+      : key{static_cast<uint32_t>(seed), static_cast<uint32_t>(seed >> 32)} {}
+
+  /**
+   * Returns the four random words for a counter.
+   * @param counter The counter.
+   * @return The random words.
+   */
+  Block operator()(Block counter) const {
+    uint32_t k0 = key[0];
+    uint32_t k1 = key[1];
+    for (int round = 0; round < 10; ++round) {
+      uint64_t p0 = uint64_t{0xD2511F53} * counter[0];
+      uint64_t p1 = uint64_t{0xCD9E8D57} * counter[2];
+      counter = {static_cast<uint32_t>(p1 >> 32) ^ counter[1] ^ k0,
+                 static_cast<uint32_t>(p1),
+                 static_cast<uint32_t>(p0 >> 32) ^ counter[3] ^ k1,
+                 static_cast<uint32_t>(p0)};
+      k0 += 0x9E3779B9;
+      k1 += 0xBB67AE85;
+    }
+    return counter;
+  }
+
+  /**
+   * Maps a random word to a uniform double in the open interval (0, 1).
+   * @param word The random word.
+   * @return The uniform value.
+   */
+  static constexpr double ToUniform(uint32_t word) {
+    return (word + 0.5) / 4294967296.0;
+  }
+
+ private:
+  std::array<uint32_t, 2> key;
+};
+
+}  // namespace photonlib
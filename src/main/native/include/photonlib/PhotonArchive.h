@@ -0,0 +1,251 @@
+/**
+ * Copyright (C) 2020-2021 Photon Vision.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <units/time.h>
+
+#include "photonlib/PhotonPipelineResult.h"
+#include "photonlib/PhotonResultColumns.h"
+
+namespace photonlib {
+
+/**
+ * The columns of a PhotonArchive file. Each block of frames stores every
+ * column separately, so a reader can decode only the ones it needs.
+ *
+ * Times are stored in microseconds as zig-zag varints of the change in the
+ * time between frames, which is a single byte at a steady frame rate.
+ * Latencies are stored in microseconds as zig-zag varints of the change
+ * from the previous frame, and target counts as plain varints. Each target
+ * field is a Gorilla-style stream of doubles, each XORed with the value
+ * before it, so repeated values take a single bit and values close to the
+ * one before keep only the bits that changed.
+ *
+ * The file is a header followed by blocks, with all integers little endian:
+ * <pre>
+ * uint32 magic ("PVAR")
+ * uint32 version
+ * blocks, each:
+ *   uint32 frame count
+ *   uint32 target count
+ *   uint32 column sizes[kColumnCount]
+ *   the columns, in Column order
+ * </pre>
+ */
+struct PhotonArchive {
+  enum Column {
+    kTime,
+    kLatency,
+    kTargetCount,
+    // The target fields, in PhotonResultColumns::Column order.
+    kYaw,
+    kPitch,
+    kArea,
+    kSkew,
+    kX,
+    kY,
+    kRotation,
+    kColumnCount
+  };
+
+  /**
+   * Returns the bit of a column in a column mask.
+   * @param column The column.
+   * @return The bit.
+   */
+  static constexpr uint32_t Mask(Column column) { return 1u << column; }
+
+  static constexpr uint32_t kAllColumns = (1u << kColumnCount) - 1;
+};
+
+/**
+ * Writes a stream of pipeline results to a PhotonArchive file, e.g. to log a
+ * whole event far more compactly than the raw packets. Frames are buffered
+ * and written a block at a time.
+ *
+ * Times and latencies are rounded to the microsecond; target fields are
+ * stored exactly.
+ */
+class PhotonArchiveWriter {
+ public:
+  /**
+   * Creates a file, replacing any existing one. Failure is reported to the
+   * driver station.
+   * @param path           The path of the file.
+   * @param framesPerBlock The number of frames in each block.
+   */
+  explicit PhotonArchiveWriter(const std::string& path,
+                               size_t framesPerBlock = 4096);
+
+  /**
+   * Writes any buffered frames and closes the file.
+   */
+  ~PhotonArchiveWriter();
+
+  PhotonArchiveWriter(const PhotonArchiveWriter&) = delete;
+  PhotonArchiveWriter& operator=(const PhotonArchiveWriter&) = delete;
+
+  /**
+   * Returns whether the file is open and every write so far succeeded.
+   * @return Whether the file is usable.
+   */
+  bool IsOpen() const { return file.is_open() && file.good(); }
+
+  /**
+   * Adds a frame.
+   * @param time   The time of the frame, e.g. its capture timestamp.
+   * @param result The result.
+   * @return Whether the frame was buffered or written successfully.
+   */
+  bool Append(units::second_t time, const PhotonPipelineResult& result);
+
+  /**
+   * Writes any buffered frames and closes the file.
+   * @return Whether every write succeeded.
+   */
+  bool Close();
+
+ private:
+  std::ofstream file;
+  size_t framesPerBlock;
+  std::vector<int64_t> times;
+  std::vector<int64_t> latencies;
+  std::vector<uint32_t> targetCounts;
+  std::array<std::vector<double>, PhotonResultColumns::kColumnCount> targets;
+  std::vector<uint8_t> encoded;
+
+  bool WriteBlock();
+};
+
+/**
+ * Some columns of one block of a PhotonArchive file. Columns that weren't
+ * read are left empty.
+ */
+struct PhotonArchiveBlock {
+  std::vector<units::second_t> times;
+  std::vector<double> latencyMillis;
+  std::vector<uint32_t> targetCounts;
+  // The index in each target column of each frame's first target, plus the
+  // total at the end. Filled in whenever a target column is read.
+  std::vector<size_t> firstTargets;
+  std::array<std::vector<double>, PhotonResultColumns::kColumnCount> targets;
+
+  /**
+   * Returns the number of frames in the block.
+   * @return The number of frames.
+   */
+  size_t Size() const { return frameCount; }
+
+  /**
+   * Rebuilds a frame's result. Needs the latency, target count and every
+   * target column to have been read.
+   * @param frame The index of the frame in the block.
+   * @return The result.
+   */
+  PhotonPipelineResult GetResult(size_t frame) const;
+
+ private:
+  friend class PhotonArchiveReader;
+  size_t frameCount = 0;
+};
+
+/**
+ * Reads a PhotonArchive file a block at a time. Opening the file only reads
+ * the block headers, and reading a block only reads and decodes the columns
+ * asked for.
+ *
+ * <pre>
+ * PhotonArchiveReader reader("match.pvar");
+ * PhotonArchiveBlock block;
+ * for (size_t i = 0; i < reader.GetBlockCount(); ++i) {
+ *   reader.ReadBlock(i, PhotonArchive::Mask(PhotonArchive::kTime) |
+ *                           PhotonArchive::Mask(PhotonArchive::kYaw),
+ *                    block);
+ *   ...
+ * }
+ * </pre>
+ */
+class PhotonArchiveReader {
+ public:
+  /**
+   * Opens a file. A missing or malformed file is reported to the driver
+   * station and reads as empty.
+   * @param path The path of the file.
+   */
+  explicit PhotonArchiveReader(const std::string& path);
+
+  /**
+   * Returns whether the file was opened and its block headers are valid.
+   * @return Whether the file is usable.
+   */
+  bool IsOpen() const { return file.is_open(); }
+
+  /**
+   * Returns the number of blocks.
+   * @return The number of blocks.
+   */
+  size_t GetBlockCount() const { return blocks.size(); }
+
+  /**
+   * Returns the total number of frames.
+   * @return The number of frames.
+   */
+  size_t GetFrameCount() const { return frameCount; }
+
+  /**
+   * Reads some columns of a block.
+   * @param index   The index of the block.
+   * @param columns The columns to read, as a mask of PhotonArchive::Mask
+   *                bits. Reading any target column also reads the target
+   *                counts.
+   * @param block   Filled with the columns.
+   * @return Whether the block exists and its columns are valid.
+   */
+  bool ReadBlock(size_t index, uint32_t columns, PhotonArchiveBlock& block);
+
+  /**
+   * Reads every frame of the file.
+   * @param times   Filled with the time of each frame.
+   * @param results Filled with the result of each frame.
+   * @return Whether every block is valid.
+   */
+  bool ReadAll(std::vector<units::second_t>& times,
+               std::vector<PhotonPipelineResult>& results);
+
+ private:
+  struct BlockInfo {
+    uint64_t offset;
+    uint32_t frameCount;
+    uint32_t targetCount;
+    std::array<uint32_t, PhotonArchive::kColumnCount> columnSizes;
+  };
+
+  std::ifstream file;
+  std::vector<BlockInfo> blocks;
+  size_t frameCount = 0;
+  std::vector<uint8_t> columnData;
+};
+
+}  // namespace photonlib
@@ -25,6 +25,7 @@
 #include <string>
 
 #include "photonlib/PhotonPipelineResult.h"
+#include "photonlib/PhotonResultChannel.h"
 
 namespace photonlib {
 
@@ -50,11 +51,21 @@ class PhotonCamera {
   explicit PhotonCamera(const std::string& cameraName);
 
   /**
-   * Returns the latest pipeline result.
+   * Returns the latest pipeline result. A result a SimPhotonCamera in this
+   * process delivered in-process is returned directly; otherwise the result
+   * is decoded from NetworkTables.
    * @return The latest pipeline result.
    */
   PhotonPipelineResult GetLatestResult() const;
 
+  /**
+   * Returns the latest pipeline result without copying it. A result
+   * delivered in-process is shared with the publisher and every other
+   * reader; otherwise a newly decoded result is returned.
+   * @return The latest pipeline result, never null.
+   */
+  std::shared_ptr<const PhotonPipelineResult> GetLatestResultPtr() const;
+
   /**
    * Toggles driver mode.
    * @param driverMode Whether to set driver mode.
@@ -117,9 +128,12 @@ class PhotonCamera {
    * Returns whether the latest target result has targets.
    * @return Whether the latest target result has targets.
    */
-  bool HasTargets() const { return GetLatestResult().HasTargets(); }
+  bool HasTargets() const { return GetLatestResultPtr()->HasTargets(); }
 
  private:
+  // Decodes the latest result published to NetworkTables.
+  void DecodeLatest(PhotonPipelineResult& result) const;
+
   std::shared_ptr<nt::NetworkTable> mainTable =
       nt::NetworkTableInstance::GetDefault().GetTable("photonvision");
 
@@ -132,6 +146,7 @@ class PhotonCamera {
   nt::NetworkTableEntry ledModeEntry;
 
   mutable Packet packet;
+  std::shared_ptr<PhotonResultChannel> directChannel;
 
   bool driverMode;
   double pipelineIndex;
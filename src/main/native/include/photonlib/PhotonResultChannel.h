@@ -0,0 +1,90 @@
+/**
+ * Copyright (C) 2020-2021 Photon Vision.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <string>
+
+#include <wpi/StringRef.h>
+
+#include "photonlib/PhotonPipelineResult.h"
+
+namespace photonlib {
+
+/**
+ * Hands pipeline results from a SimPhotonCamera to the PhotonCameras reading
+ * the same table in this process, without encoding them into a Packet and
+ * going through NetworkTables.
+ *
+ * There is one channel per camera table path, shared by every camera object
+ * using that table. Results are passed by shared pointer, so publishing and
+ * reading never copy the target list. Readers check a flag before touching
+ * the pointer, so cameras using NetworkTables pay only an atomic load. The
+ * pointer itself is read and replaced with std::atomic_load and
+ * std::atomic_exchange, which common standard libraries implement with a
+ * short lock from an internal pool.
+ *
+ * Each result is tagged with its publisher, and is only returned while the
+ * publisher is alive, so a destroyed simulated camera's last result never
+ * hides later NetworkTables results.
+ */
+class PhotonResultChannel {
+ public:
+  /**
+   * Returns the channel for a camera table, creating it on first use.
+   * @param tablePath The path of the camera's NetworkTable.
+   * @return The channel.
+   */
+  static std::shared_ptr<PhotonResultChannel> Get(wpi::StringRef tablePath);
+
+  /**
+   * Publishes a result, replacing the previous one.
+   * @param result    The result.
+   * @param publisher Anything owned by the publisher. Readers ignore the
+   *                  result once it has expired.
+   */
+  void Publish(PhotonPipelineResult result,
+               std::weak_ptr<const void> publisher);
+
+  /**
+   * Removes the published result, making readers fall back to
+   * NetworkTables.
+   */
+  void Clear();
+
+  /**
+   * Returns the latest result, or null if none is published or its
+   * publisher is gone.
+   * @return The latest result.
+   */
+  std::shared_ptr<const PhotonPipelineResult> Latest() const;
+
+ private:
+  struct Publication {
+    PhotonPipelineResult result;
+    std::weak_ptr<const void> publisher;
+  };
+
+  // Whether latest is non-null, readable without the shared_ptr's atomics.
+  std::atomic<bool> published{false};
+  // Only accessed through std::atomic_load and std::atomic_exchange.
+  std::shared_ptr<const Publication> latest;
+};
+
+}  // namespace photonlib
@@ -0,0 +1,100 @@
+/**
+ * Copyright (C) 2020-2021 Photon Vision.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include <wpi/ArrayRef.h>
+
+#include "photonlib/PhotonPipelineResult.h"
+
+namespace photonlib {
+
+/**
+ * Decodes PhotonPipelineResult packets straight into columns of doubles, one
+ * column per target field, without building any PhotonTrackedTarget objects.
+ * This is the decoder behind the Java PhotonResultBuffer.
+ *
+ * A decoded result of capacity n takes Size(n) doubles: the latency in
+ * milliseconds, then n yaws, then n pitches, and so on in Column order, so
+ * field f of target i is at Index(f, i, n). Rotations are in degrees, as in
+ * the packet.
+ */
+struct PhotonResultColumns {
+  enum Column { kYaw, kPitch, kArea, kSkew, kX, kY, kRotation, kColumnCount };
+
+  /**
+   * Returns the number of doubles a result of the given capacity takes.
+   * @param capacity The largest number of targets.
+   * @return The number of doubles.
+   */
+  static constexpr size_t Size(size_t capacity) {
+    return 1 + kColumnCount * capacity;
+  }
+
+  /**
+   * Returns where a target's field is stored.
+   * @param column   The field.
+   * @param target   The index of the target.
+   * @param capacity The largest number of targets.
+   * @return The index of the field.
+   */
+  static constexpr size_t Index(Column column, size_t target,
+                                size_t capacity) {
+    return 1 + column * capacity + target;
+  }
+
+  /**
+   * Decodes a packet written by operator<<(Packet&, PhotonPipelineResult).
+   * If the packet holds more targets than fit, only the first capacity are
+   * written.
+   * @param data     The packet data.
+   * @param out      Filled with the result; must hold Size(capacity) doubles.
+   * @param capacity The largest number of targets to write.
+   * @return The number of targets in the packet, or -1 if it is malformed.
+   */
+  static int Decode(wpi::ArrayRef<uint8_t> data, double* out,
+                    size_t capacity);
+
+  /**
+   * Like Decode, but writes each target's fields next to each other in
+   * Column order, as C callers lay out an array of structs.
+   * @param data     The packet data.
+   * @param latency  Set to the latency in milliseconds.
+   * @param rows     Filled with the targets; must hold kColumnCount *
+   *                 capacity doubles.
+   * @param capacity The largest number of targets to write.
+   * @return The number of targets in the packet, or -1 if it is malformed.
+   */
+  static int DecodeRows(wpi::ArrayRef<uint8_t> data, double* latency,
+                        double* rows, size_t capacity);
+
+  /**
+   * Writes a result in the same layout as Decode, without going through a
+   * packet.
+   * @param result   The result.
+   * @param out      Filled with the result; must hold Size(capacity) doubles.
+   * @param capacity The largest number of targets to write.
+   * @return The number of targets in the result.
+   */
+  static int Write(const PhotonPipelineResult& result, double* out,
+                   size_t capacity);
+};
+
+}  // namespace photonlib
@@ -0,0 +1,150 @@
+/**
+ * Copyright (C) 2020-2021 Photon Vision.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+/**
+ * Records the time spent in the enclosing scope as a trace span named by a
+ * string literal. Spans are only recorded when photonlib is built with
+ * PHOTONLIB_TRACING defined (pass -PphotonTracing to Gradle); otherwise this
+ * expands to nothing.
+ */
+#ifdef PHOTONLIB_TRACING
+#define PHOTON_TRACE_SCOPE(name) \
+  ::photonlib::PhotonTraceScope PHOTON_TRACE_CONCAT(photonTraceScope, \
+                                                    __LINE__)(name)
+#define PHOTON_TRACE_CONCAT(a, b) PHOTON_TRACE_CONCAT_IMPL(a, b)
+#define PHOTON_TRACE_CONCAT_IMPL(a, b) a##b
+#else
+#define PHOTON_TRACE_SCOPE(name)
+#endif
+
+namespace photonlib {
+
+/**
+ * Collects trace spans from every thread, for finding where loop time goes.
+ * Each thread records into its own fixed-size buffer without taking locks,
+ * and the spans can be written out as Chrome trace_event JSON, which
+ * Perfetto (ui.perfetto.dev) and chrome://tracing open.
+ *
+ * <pre>
+ * // Built with -PphotonTracing:
+ * camera.GetLatestResult();
+ * ...
+ * PhotonTrace::WriteChromeJson("trace.json");
+ * </pre>
+ */
+class PhotonTrace {
+ public:
+  /**
+   * Pauses or resumes recording. Recording is on by default.
+   * @param enabled Whether to record spans.
+   */
+  static void SetEnabled(bool enabled) {
+    enabledFlag.store(enabled, std::memory_order_relaxed);
+  }
+
+  /**
+   * Returns whether spans are being recorded.
+   * @return Whether spans are being recorded.
+   */
+  static bool IsEnabled() {
+    return enabledFlag.load(std::memory_order_relaxed);
+  }
+
+  /**
+   * Records a span on the calling thread. Once a thread's buffer is full,
+   * further spans from it are counted and dropped.
+   * @param name  The name of the span; must outlive the trace, e.g. a
+   *              string literal.
+   * @param start When the span started.
+   * @param end   When the span ended.
+   */
+  static void Record(const char* name,
+                     std::chrono::steady_clock::time_point start,
+                     std::chrono::steady_clock::time_point end);
+
+  /**
+   * Returns the number of spans recorded so far on all threads.
+   * @return The number of spans.
+   */
+  static size_t GetSpanCount();
+
+  /**
+   * Returns the number of spans dropped because a buffer was full.
+   * @return The number of spans.
+   */
+  static size_t GetDroppedCount();
+
+  /**
+   * Writes every span recorded so far as Chrome trace_event JSON. This may
+   * run while other threads keep recording.
+   * @param path The path of the file.
+   * @return Whether the file was written.
+   */
+  static bool WriteChromeJson(const std::string& path);
+
+  /**
+   * Discards every recorded span. Must not run while traced code is running
+   * on other threads.
+   */
+  static void Clear();
+
+  /**
+   * The number of spans each thread's buffer holds. A thread that exits
+   * hands its buffer, and the spans in it, to the next thread that starts
+   * recording, so short-lived threads share buffers and appear as one
+   * thread in the trace.
+   */
+  static constexpr size_t kSpansPerThread = 1 << 16;
+
+ private:
+  static std::atomic<bool> enabledFlag;
+};
+
+/**
+ * Records a span from its construction to its destruction. Use
+ * PHOTON_TRACE_SCOPE rather than this directly, so that tracing compiles
+ * out when disabled.
+ */
+class PhotonTraceScope {
+ public:
+  explicit PhotonTraceScope(const char* name)
+      : name(PhotonTrace::IsEnabled() ? name : nullptr) {
+    if (this->name) start = std::chrono::steady_clock::now();
+  }
+
+  ~PhotonTraceScope() {
+    if (name) {
+      PhotonTrace::Record(name, start, std::chrono::steady_clock::now());
+    }
+  }
+
+  PhotonTraceScope(const PhotonTraceScope&) = delete;
+  PhotonTraceScope& operator=(const PhotonTraceScope&) = delete;
+
+ private:
+  const char* name;
+  std::chrono::steady_clock::time_point start;
+};
+
+}  // namespace photonlib
@@ -17,6 +17,8 @@
 
 #pragma once
 
+#include <optional>
+
 #include <frc/geometry/Pose2d.h>
 #include <frc/geometry/Rotation2d.h>
 #include <frc/geometry/Transform2d.h>
@@ -24,6 +26,9 @@
 #include <units/angle.h>
 #include <units/length.h>
 #include <units/math.h>
+#include <units/time.h>
+
+#include "photonlib/PoseHistory.h"
 
 namespace photonlib {
 class PhotonUtils {
@@ -106,6 +111,42 @@ class PhotonUtils {
         fieldToTarget, cameraToRobot);
   }
 
+  /**
+   * Estimate the position of the robot in the field at the time a frame was
+   * captured, using the gyro angle recorded in a pose history at that time
+   * rather than the current one.
+   *
+   * @param cameraHeight     The physical height of the camera off the floor.
+   * @param targetHeight     The physical height of the target off the floor.
+   * @param cameraPitch      The pitch of the camera from the horizontal plane.
+   *                         Positive values up.
+   * @param targetPitch      The pitch of the target in the camera's lens.
+   *                         Positive values up.
+   * @param targetYaw        The observed yaw of the target. Note that this
+   *                         *must* be CCW-positive, and Photon returns
+   *                         CW-positive.
+   * @param history          The recorded robot poses, likely from odometry.
+   * @param captureTimestamp The time the frame was captured, i.e. the time
+   *                         the result was received minus its latency.
+   * @param fieldToTarget    A frc::Pose2d representing the target position in
+   *                         the field coordinate system.
+   * @param cameraToRobot    The position of the robot relative to the camera.
+   * @return The position of the robot in the field at the capture time, or
+   *         nothing if the history does not reach back that far.
+   */
+  static std::optional<frc::Pose2d> EstimateFieldToRobot(
+      units::meter_t cameraHeight, units::meter_t targetHeight,
+      units::radian_t cameraPitch, units::radian_t targetPitch,
+      const frc::Rotation2d& targetYaw, const PoseHistory& history,
+      units::second_t captureTimestamp, const frc::Pose2d& fieldToTarget,
+      const frc::Transform2d& cameraToRobot) {
+    auto robotPose = history.Sample(captureTimestamp);
+    if (!robotPose) return std::nullopt;
+    return EstimateFieldToRobot(cameraHeight, targetHeight, cameraPitch,
+                                targetPitch, targetYaw, robotPose->Rotation(),
+                                fieldToTarget, cameraToRobot);
+  }
+
   /**
    * Estimates a {@link frc::Transform2d} that maps the camera position to the
    * target position, using the robot's gyro. Note that the gyro angle provided
@@ -133,6 +174,31 @@ class PhotonUtils {
                             -gyroAngle - fieldToTarget.Rotation());
   }
 
+  /**
+   * Like EstimateCameraToTarget(Translation2d, Pose2d, Rotation2d), but with
+   * the gyro angle recorded in a pose history when the frame was captured.
+   *
+   * @param cameraToTargetTranslation A Translation2d that encodes the x/y
+   *                                  position of the target relative to the
+   *                                  camera.
+   * @param fieldToTarget             A frc::Pose2d representing the target
+   *                                  position in the field coordinate system.
+   * @param history                   The recorded robot poses, likely from
+   *                                  odometry.
+   * @param captureTimestamp          The time the frame was captured.
+   * @return A frc::Transform2d that takes us from the camera to the target,
+   *         or nothing if the history does not reach back that far.
+   */
+  static std::optional<frc::Transform2d> EstimateCameraToTarget(
+      const frc::Translation2d& cameraToTargetTranslation,
+      const frc::Pose2d& fieldToTarget, const PoseHistory& history,
+      units::second_t captureTimestamp) {
+    auto robotPose = history.Sample(captureTimestamp);
+    if (!robotPose) return std::nullopt;
+    return EstimateCameraToTarget(cameraToTargetTranslation, fieldToTarget,
+                                  robotPose->Rotation());
+  }
+
   /**
    * Estimates the pose of the robot in the field coordinate system, given the
    * position of the target relative to the camera, the target relative to the
@@ -0,0 +1,134 @@
+/**
+ * Copyright (C) 2020-2021 Photon Vision.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include <frc/geometry/Pose2d.h>
+#include <units/time.h>
+
+#include "photonlib/PhotonPipelineResult.h"
+
+namespace photonlib {
+
+/**
+ * Fuses drivetrain odometry with latency-delayed vision pose measurements.
+ *
+ * Odometry samples are kept in a fixed-size ring buffer allocated at
+ * construction. When a vision measurement arrives, the fused pose at the
+ * frame's capture time is interpolated from history and blended toward the
+ * measurement. Only the k samples recorded after the capture time are then
+ * re-expressed relative to the corrected pose, so each correction costs O(k)
+ * and never touches older history.
+ */
+class PoseFusionEstimator {
+ public:
+  /**
+   * Constructs a PoseFusionEstimator.
+   *
+   * @param historySize       Number of odometry samples to retain. At 50 Hz,
+   *                          50 samples cover one second of vision latency.
+   * @param translationWeight How far (0-1) to move the translation toward
+   *                          each vision measurement.
+   * @param rotationWeight    How far (0-1) to move the heading toward each
+   *                          vision measurement. Gyros are usually far better
+   *                          than vision at heading, so this is often small.
+   */
+  explicit PoseFusionEstimator(size_t historySize = 50,
+                               double translationWeight = 0.1,
+                               double rotationWeight = 0.0);
+
+  /**
+   * Clears history and sets the fused pose.
+   *
+   * @param pose         The new fused pose.
+   * @param odometryPose The current raw odometry pose.
+   * @param timestamp    The current time.
+   */
+  void ResetPose(const frc::Pose2d& pose, const frc::Pose2d& odometryPose,
+                 units::second_t timestamp);
+
+  /**
+   * Records a new odometry sample and advances the fused pose by the motion
+   * odometry measured since the previous sample. Samples older than the
+   * latest one are ignored.
+   *
+   * @param odometryPose The raw odometry pose.
+   * @param timestamp    The time the odometry pose was measured.
+   * @return The updated fused pose.
+   */
+  frc::Pose2d UpdateOdometry(const frc::Pose2d& odometryPose,
+                             units::second_t timestamp);
+
+  /**
+   * Corrects the fused pose with a vision measurement.
+   *
+   * @param visionPose The robot pose measured by vision.
+   * @param timestamp  The time the frame was captured.
+   * @return Whether the measurement fell inside the retained history and was
+   *         applied.
+   */
+  bool AddVisionMeasurement(const frc::Pose2d& visionPose,
+                            units::second_t timestamp);
+
+  /**
+   * Corrects the fused pose with a vision measurement taken from a pipeline
+   * result, using the result's latency to find its capture time.
+   *
+   * @param visionPose The robot pose measured from the result.
+   * @param result     The pipeline result the pose was computed from.
+   * @param now        The time the result was received.
+   * @return Whether the measurement was applied.
+   */
+  bool AddVisionMeasurement(const frc::Pose2d& visionPose,
+                            const PhotonPipelineResult& result,
+                            units::second_t now) {
+    return AddVisionMeasurement(visionPose, now - result.GetLatency());
+  }
+
+  /**
+   * Returns the current fused pose.
+   * @return The current fused pose.
+   */
+  frc::Pose2d GetEstimatedPosition() const { return estimate; }
+
+ private:
+  struct Sample {
+    units::second_t timestamp;
+    frc::Pose2d odometry;
+    frc::Pose2d fused;
+  };
+
+  double translationWeight;
+  double rotationWeight;
+  frc::Pose2d estimate;
+
+  // Ring buffer of samples, oldest at head.
+  std::vector<Sample> samples;
+  size_t head = 0;
+  size_t count = 0;
+
+  Sample& At(size_t i) { return samples[(head + i) % samples.size()]; }
+  const Sample& At(size_t i) const {
+    return samples[(head + i) % samples.size()];
+  }
+  size_t UpperBound(units::second_t timestamp) const;
+};
+
+}  // namespace photonlib
@@ -0,0 +1,102 @@
+/**
+ * Copyright (C) 2020-2021 Photon Vision.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <optional>
+#include <vector>
+
+#include <frc/geometry/Pose2d.h>
+#include <units/time.h>
+
+namespace photonlib {
+
+/**
+ * A fixed-capacity, time-indexed history of robot poses. Storage is allocated
+ * once at construction; once full, each new sample overwrites the oldest.
+ * Lookups binary search the history and interpolate between the two
+ * neighbouring samples along the SE(2) arc joining them.
+ */
+class PoseHistory {
+ public:
+  /**
+   * Constructs a PoseHistory.
+   * @param capacity The number of samples to retain.
+   */
+  explicit PoseHistory(size_t capacity = 50);
+
+  /**
+   * Records a pose. Samples must be added in time order; a sample no newer
+   * than the latest one is ignored.
+   *
+   * @param timestamp The time the pose was measured.
+   * @param pose      The robot pose at that time.
+   */
+  void AddSample(units::second_t timestamp, const frc::Pose2d& pose);
+
+  /**
+   * Returns the robot pose at the given time. Times newer than the latest
+   * sample return the latest sample.
+   *
+   * @param timestamp The time to look up.
+   * @return The interpolated pose, or nothing if the history is empty or the
+   *         time predates the oldest retained sample.
+   */
+  std::optional<frc::Pose2d> Sample(units::second_t timestamp) const;
+
+  /**
+   * Removes every sample.
+   */
+  void Clear() {
+    head = 0;
+    count = 0;
+  }
+
+  /**
+   * Returns the number of samples currently retained.
+   * @return The number of samples.
+   */
+  size_t Size() const { return count; }
+
+  /**
+   * Interpolates along the constant-curvature arc joining two poses.
+   *
+   * @param start The pose at t = 0.
+   * @param end   The pose at t = 1.
+   * @param t     The fraction of the way from start to end.
+   * @return The interpolated pose.
+   */
+  static frc::Pose2d Interpolate(const frc::Pose2d& start,
+                                 const frc::Pose2d& end, double t);
+
+ private:
+  struct Entry {
+    units::second_t timestamp;
+    frc::Pose2d pose;
+  };
+
+  std::vector<Entry> entries;
+  size_t head = 0;
+  size_t count = 0;
+
+  const Entry& At(size_t i) const {
+    return entries[(head + i) % entries.size()];
+  }
+};
+
+}  // namespace photonlib
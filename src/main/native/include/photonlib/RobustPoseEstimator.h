@@ -0,0 +1,148 @@
+/**
+ * Copyright (C) 2020-2021 Photon Vision.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+#include <frc/geometry/Pose2d.h>
+#include <frc/geometry/Rotation2d.h>
+#include <frc/geometry/Transform2d.h>
+#include <units/angle.h>
+#include <units/length.h>
+#include <units/time.h>
+#include <wpi/ArrayRef.h>
+#include <wpi/SmallVector.h>
+
+#include "photonlib/PhotonTrackedTarget.h"
+#include "photonlib/XorShiftRandom.h"
+
+namespace photonlib {
+
+/**
+ * A single target observation paired with the known field pose of the target
+ * it was matched to.
+ */
+struct PoseObservation {
+  /** The target as reported by the camera. */
+  PhotonTrackedTarget target;
+  /** The position of the target in the field coordinate system. */
+  frc::Pose2d fieldToTarget;
+  /** The physical height of the target off the floor. */
+  units::meter_t targetHeight;
+};
+
+/**
+ * The result of a robust multi-target pose solve.
+ */
+struct RobustPoseEstimate {
+  /** The estimated robot pose, refined over the inlier set. */
+  frc::Pose2d fieldToRobot;
+  /** Indices into the observation list which agreed with the estimate. */
+  wpi::SmallVector<size_t, 10> inliers;
+  /**
+   * Probability that at least one sampled hypothesis was drawn from the
+   * inlier set, given the observed inlier ratio and iterations spent (0-1).
+   */
+  double confidence = 0.0;
+  /** Number of RANSAC iterations actually run. */
+  int iterations = 0;
+  /** Whether any observation was available to produce an estimate. */
+  bool valid = false;
+};
+
+/**
+ * Rejects reflections and misidentified targets when estimating the robot pose
+ * from several targets at once. Each observation produces a robot pose
+ * hypothesis through PhotonUtils::EstimateFieldToRobot; RANSAC then picks the
+ * hypothesis with the largest consensus and averages its inliers.
+ *
+ * The random sequence is seeded explicitly, so a given set of observations
+ * always produces the same estimate.
+ */
+class RobustPoseEstimator {
+ public:
+  /**
+   * Constructs a RobustPoseEstimator.
+   *
+   * @param cameraHeight      The physical height of the camera off the floor.
+   * @param cameraPitch       The pitch of the camera from the horizontal
+   *                          plane. Positive values up.
+   * @param cameraToRobot     The position of the robot relative to the camera.
+   * @param inlierThreshold   Maximum distance between two robot pose
+   *                          hypotheses for them to be considered in
+   *                          agreement.
+   * @param maxIterations     The fixed iteration budget per estimate. At
+   *                          least one iteration always runs.
+   * @param timeBudget        Wall-clock budget per estimate. Sampling stops
+   *                          once it is exceeded, even if iterations remain.
+   * @param consensusFraction Fraction of observations (0-1) which, once found
+   *                          agreeing, terminates sampling early.
+   * @param seed              Seed of the deterministic random sequence.
+   */
+  RobustPoseEstimator(units::meter_t cameraHeight, units::radian_t cameraPitch,
+                      const frc::Transform2d& cameraToRobot,
+                      units::meter_t inlierThreshold = 0.3_m,
+                      int maxIterations = 32,
+                      units::second_t timeBudget = 0.002_s,
+                      double consensusFraction = 0.8, uint64_t seed = 0);
+
+  /**
+   * Estimates the robot pose from a set of target observations.
+   *
+   * @param observations The observed targets and their field poses.
+   * @param gyroAngle    The current robot gyro angle, likely from odometry.
+   * @return The estimated pose along with its inlier set and confidence.
+   */
+  RobustPoseEstimate Estimate(wpi::ArrayRef<PoseObservation> observations,
+                              const frc::Rotation2d& gyroAngle);
+
+  /**
+   * Resets the random sequence to the given seed.
+   * @param seed The new seed.
+   */
+  void Reseed(uint64_t seed);
+
+  void SetInlierThreshold(units::meter_t threshold) {
+    inlierThreshold = threshold;
+  }
+  void SetMaxIterations(int iterations) {
+    maxIterations = std::max(iterations, 1);
+  }
+  void SetTimeBudget(units::second_t budget) { timeBudget = budget; }
+
+ private:
+  units::meter_t cameraHeight;
+  units::radian_t cameraPitch;
+  frc::Transform2d cameraToRobot;
+  units::meter_t inlierThreshold;
+  int maxIterations;
+  units::second_t timeBudget;
+  double consensusFraction;
+  XorShiftRandom rng;
+
+  // Scratch storage reused between calls to avoid per-frame allocation.
+  wpi::SmallVector<frc::Pose2d, 10> hypotheses;
+  wpi::SmallVector<size_t, 10> candidateInliers;
+
+  size_t CountInliers(const frc::Pose2d& hypothesis,
+                      wpi::SmallVectorImpl<size_t>& inliers) const;
+};
+
+}  // namespace photonlib
@@ -0,0 +1,33 @@
+/**
+ * Copyright (C) 2020-2021 Photon Vision.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+namespace photonlib {
+
+/**
+ * The pixel format of a synthetic camera image. Kept apart from
+ * SimFrameRenderer so that naming it doesn't pull in OpenCV and cscore.
+ */
+enum class SimFrameFormat {
+  /** One byte per pixel. */
+  kGray,
+  /** Three bytes per pixel, blue, green and red, as OpenCV stores them. */
+  kBGR
+};
+
+}  // namespace photonlib
@@ -0,0 +1,129 @@
+/**
+ * Copyright (C) 2020-2021 Photon Vision.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <cscore_oo.h>
+#include <opencv2/core/core.hpp>
+#include <wpi/ArrayRef.h>
+
+#include "photonlib/SimFrameFormat.h"
+#include "photonlib/SimPinholeCamera.h"
+#include "photonlib/SimTargetStore.h"
+
+namespace photonlib {
+
+/**
+ * Draws synthetic camera frames of simulated targets, so that code which
+ * handles images (cscore streams, snapshots) can run in simulation.
+ *
+ * Targets are projected with the pinhole model and filled in with a
+ * scanline rasterizer over a plain background. The frame buffer is owned by
+ * the renderer and reused, so rendering doesn't allocate once the renderer
+ * is constructed.
+ */
+class SimFrameRenderer {
+ public:
+  using Format = SimFrameFormat;
+  static constexpr Format kGray = SimFrameFormat::kGray;
+  static constexpr Format kBGR = SimFrameFormat::kBGR;
+
+  /**
+   * Constructs a SimFrameRenderer with a black background and bright green
+   * targets, like retroreflective tape under an LED ring.
+   * @param width  The image width, in pixels.
+   * @param height The image height, in pixels.
+   * @param format The pixel format.
+   */
+  SimFrameRenderer(int width, int height, Format format = kGray);
+
+  /**
+   * Sets the colors of the background and the targets. Gray frames use the
+   * colors' luma.
+   * @param background The background color, as blue, green, red.
+   * @param target     The target color, as blue, green, red.
+   */
+  void SetColors(const uint8_t (&background)[3], const uint8_t (&target)[3]);
+
+  /**
+   * Fills the frame with the background color.
+   */
+  void Clear();
+
+  /**
+   * Fills a polygon with the target color. Pixels whose centers are inside
+   * the polygon are filled; the polygon may be concave.
+   * @param outline The polygon.
+   */
+  void FillPolygon(const SimTargetOutline& outline);
+
+  /**
+   * Clears the frame and draws targets as a camera sees them.
+   * @param view    The camera. Its image must be the size of the frame.
+   * @param targets The targets.
+   * @param indices The indices of the targets to draw.
+   */
+  void Render(const SimPinholeView& view, const SimTargetStore& targets,
+              wpi::ArrayRef<size_t> indices);
+
+  /**
+   * Returns the frame as an OpenCV Mat. The Mat shares the renderer's
+   * buffer, so the next render overwrites it.
+   * @return The frame.
+   */
+  cv::Mat GetMat();
+
+  /**
+   * Puts the frame to a cscore source, e.g. one from
+   * frc::CameraServer::PutVideo.
+   * @param source The source.
+   */
+  void PutFrame(cs::CvSource& source);
+
+  int GetWidth() const { return width; }
+  int GetHeight() const { return height; }
+  Format GetFormat() const { return format; }
+
+  /**
+   * Returns the pixels, row by row with no padding.
+   * @return The pixels.
+   */
+  const uint8_t* GetData() const { return pixels.data(); }
+
+ private:
+  int width;
+  int height;
+  Format format;
+  size_t pixelSize;
+  std::vector<uint8_t> pixels;
+
+  // A full row of each color, copied from to fill spans.
+  std::vector<uint8_t> backgroundRow;
+  std::vector<uint8_t> targetRow;
+
+  // Working storage for Render.
+  SimTargetGeometry geometry;
+  SimProjectedTargets projected;
+  SimTargetOutline outline;
+  std::vector<double> crossings;
+};
+
+}  // namespace photonlib
@@ -0,0 +1,137 @@
+/**
+ * Copyright (C) 2020-2021 Photon Vision.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <units/frequency.h>
+#include <units/time.h>
+#include <wpi/ArrayRef.h>
+
+#include "photonlib/PhotonTrackedTarget.h"
+#include "photonlib/XorShiftRandom.h"
+
+namespace photonlib {
+
+/**
+ * A simulated frame that has been captured and is being processed.
+ */
+struct SimPendingFrame {
+  units::second_t captureTime;
+  units::second_t completionTime;
+  std::vector<PhotonTrackedTarget> targets;
+};
+
+/**
+ * Decides when a simulated camera captures frames and when each frame's
+ * result comes out of the pipeline.
+ *
+ * Frames are captured at a fixed rate. Each one is either dropped, or given
+ * a processing time drawn from a normal distribution (clamped at zero) and
+ * queued, ordered by completion time, until that time arrives. Frames are
+ * processed one after another, so a frame never completes before the one
+ * captured ahead of it.
+ *
+ * With the default settings every call captures a frame and it completes
+ * immediately.
+ */
+class SimFrameScheduler {
+ public:
+  /**
+   * Constructs a SimFrameScheduler.
+   * @param frameRate     The rate frames are captured at. Zero captures a
+   *                      frame on every call to ShouldCapture.
+   * @param meanLatency   The mean processing time of a frame.
+   * @param latencyStdDev The standard deviation of the processing time.
+   * @param dropRate      The probability (0-1) that a frame is dropped.
+   * @param seed          The seed for the random draws.
+   */
+  explicit SimFrameScheduler(units::hertz_t frameRate = units::hertz_t(0.0),
+                             units::second_t meanLatency = units::second_t(0.0),
+                             units::second_t latencyStdDev =
+                                 units::second_t(0.0),
+                             double dropRate = 0.0, uint64_t seed = 0);
+
+  void SetFrameRate(units::hertz_t rate) { frameRate = rate; }
+  void SetLatency(units::second_t mean, units::second_t stdDev) {
+    meanLatency = mean;
+    latencyStdDev = stdDev;
+  }
+  void SetDropRate(double rate) { dropRate = rate; }
+
+  /**
+   * Restarts the random draws from a seed.
+   * @param seed The seed.
+   */
+  void Reseed(uint64_t seed);
+
+  /**
+   * Returns whether the camera captures a frame at this time. Should be
+   * called with non-decreasing times.
+   * @param now The current time.
+   * @return Whether a frame is captured.
+   */
+  bool ShouldCapture(units::second_t now);
+
+  /**
+   * Queues a captured frame, unless it is dropped.
+   * @param captureTime The time the frame was captured.
+   * @param targets     The targets seen in the frame.
+   */
+  void Submit(units::second_t captureTime,
+              wpi::ArrayRef<PhotonTrackedTarget> targets);
+
+  /**
+   * Removes the earliest queued frame, if it has completed.
+   * @param now   The current time.
+   * @param frame Set to the completed frame.
+   * @return Whether a frame had completed.
+   */
+  bool PopCompleted(units::second_t now, SimPendingFrame* frame);
+
+  /**
+   * Returns the number of frames still being processed.
+   * @return The number of queued frames.
+   */
+  size_t Pending() const { return queue.size(); }
+
+  /**
+   * Forgets all queued frames and the capture schedule.
+   */
+  void Reset();
+
+ private:
+  units::hertz_t frameRate;
+  units::second_t meanLatency;
+  units::second_t latencyStdDev;
+  double dropRate;
+
+  bool started = false;
+  units::second_t nextCapture{0.0};
+  units::second_t lastCompletion{0.0};
+
+  // A min-heap on completion time.
+  std::vector<SimPendingFrame> queue;
+
+  XorShiftRandom rng;
+  double NextGaussian();
+};
+
+}  // namespace photonlib
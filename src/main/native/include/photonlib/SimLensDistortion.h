@@ -0,0 +1,120 @@
+/**
+ * Copyright (C) 2020-2021 Photon Vision.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <vector>
+
+#include "photonlib/SimPinholeCamera.h"
+
+namespace photonlib {
+
+/**
+ * Brown-Conrady lens distortion coefficients, in OpenCV's order.
+ */
+struct SimDistortionCoefficients {
+  /**
+   * Constructs SimDistortionCoefficients.
+   * @param k1 The first radial coefficient. Negative for barrel distortion.
+   * @param k2 The second radial coefficient.
+   * @param p1 The first tangential coefficient.
+   * @param p2 The second tangential coefficient.
+   * @param k3 The third radial coefficient.
+   */
+  SimDistortionCoefficients(double k1, double k2, double p1, double p2,
+                            double k3 = 0.0)
+      : k1(k1), k2(k2), p1(p1), p2(p2), k3(k3) {}
+
+  double k1;
+  double k2;
+  double p1;
+  double p2;
+  double k3;
+};
+
+/**
+ * Maps pixels between an ideal pinhole image and the image a lens with
+ * Brown-Conrady distortion produces.
+ *
+ * Distorting a point is a polynomial, but undistorting one needs an
+ * iterative solve, and both are too slow to do for every corner of every
+ * target each frame. Instead both directions are sampled once on a grid, and
+ * looked up with bilinear interpolation.
+ */
+class SimLensDistortion {
+ public:
+  using Pixel = SimPixel;
+
+  /**
+   * Builds the lookup tables for a camera.
+   * @param intrinsics   The camera intrinsics.
+   * @param coefficients The distortion coefficients.
+   * @param gridStep     The spacing of the lookup grid, in pixels.
+   */
+  SimLensDistortion(const SimCameraIntrinsics& intrinsics,
+                    const SimDistortionCoefficients& coefficients,
+                    double gridStep = 4.0);
+
+  /**
+   * Maps a point in the ideal image to where the lens puts it.
+   * @param ideal The point in the ideal image.
+   * @return The point in the distorted image.
+   */
+  Pixel Distort(Pixel ideal) const { return distortTable.Lookup(ideal); }
+
+  /**
+   * Maps a point in the distorted image back to the ideal image.
+   * @param distorted The point in the distorted image.
+   * @return The point in the ideal image.
+   */
+  Pixel Undistort(Pixel distorted) const {
+    return undistortTable.Lookup(distorted);
+  }
+
+  /**
+   * Returns the bounding box, in the ideal image, of the points that land
+   * in the distorted image. Points outside it can't be seen.
+   * @return The bounding box.
+   */
+  const SimImageBounds& GetIdealBounds() const { return idealBounds; }
+
+ private:
+  // A grid of samples of a mapping, with the edge cells extended linearly
+  // for points past its edge.
+  struct Table {
+    double u0 = 0.0;
+    double v0 = 0.0;
+    double stepU = 1.0;
+    double stepV = 1.0;
+    int cols = 0;
+    int rows = 0;
+    std::vector<Pixel> samples;
+
+    Pixel Lookup(Pixel p) const;
+  };
+
+  SimCameraIntrinsics intrinsics;
+  SimDistortionCoefficients coefficients;
+  Table distortTable;
+  Table undistortTable;
+  SimImageBounds idealBounds;
+
+  Pixel DistortExact(Pixel ideal) const;
+  Pixel UndistortExact(Pixel distorted) const;
+};
+
+}  // namespace photonlib
@@ -0,0 +1,120 @@
+/**
+ * Copyright (C) 2020-2021 Photon Vision.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <units/angle.h>
+
+#include "photonlib/Philox.h"
+#include "photonlib/PhotonTrackedTarget.h"
+
+namespace photonlib {
+
+/**
+ * Measurement noise for simulated targets: Gaussian yaw and pitch errors
+ * that grow with distance, relative area error, missed targets (false
+ * negatives) and spurious ones (false positives).
+ *
+ * Every random value is drawn from a Philox4x32 generator keyed by the seed
+ * and indexed by the frame and target number, so the noise on a frame
+ * depends only on the seed and the frame number. Batch simulations give the
+ * same results however their frames are split across threads. With the
+ * default settings no noise is added.
+ */
+class SimNoiseModel {
+ public:
+  /**
+   * Constructs a SimNoiseModel that adds no noise.
+   * @param seed The seed for the random draws.
+   */
+  explicit SimNoiseModel(uint64_t seed = 0) : rng(seed) {}
+
+  /**
+   * Sets the standard deviation of the yaw and pitch errors, which is
+   * base + perMeter * (distance along the ground).
+   * @param base     The standard deviation at the camera.
+   * @param perMeter The increase in standard deviation per meter.
+   */
+  void SetAngleNoise(units::degree_t base, units::degree_t perMeter) {
+    angleStdDev = base.to<double>();
+    angleStdDevPerMeter = perMeter.to<double>();
+  }
+
+  /**
+   * Sets the standard deviation of the area error, as a fraction of the
+   * area.
+   * @param relativeStdDev The relative standard deviation.
+   */
+  void SetAreaNoise(double relativeStdDev) { areaStdDev = relativeStdDev; }
+
+  /**
+   * Sets the probability that a visible target is missed.
+   * @param rate The probability (0-1).
+   */
+  void SetFalseNegativeRate(double rate) { falseNegativeRate = rate; }
+
+  /**
+   * Sets the probability that a frame contains a spurious target. Spurious
+   * targets are placed uniformly in the field of view with an area up to
+   * maxArea. SimVisionSystem converts it to percent of the image, as it
+   * reports area, once SimVisionSystem::SetCameraIntrinsics has been called.
+   * @param rate    The probability (0-1) per frame.
+   * @param maxArea The largest area of a spurious target, in pixels.
+   */
+  void SetFalsePositiveRate(double rate, double maxArea = 1.0) {
+    falsePositiveRate = rate;
+    falsePositiveMaxArea = maxArea;
+  }
+
+  /**
+   * Returns whether any noise is configured.
+   * @return Whether Apply changes anything.
+   */
+  bool Enabled() const {
+    return angleStdDev != 0.0 || angleStdDevPerMeter != 0.0 ||
+           areaStdDev != 0.0 || falseNegativeRate > 0.0 ||
+           falsePositiveRate > 0.0;
+  }
+
+  /**
+   * Adds noise to the targets seen in a frame.
+   * @param frame     The frame number.
+   * @param horizFOV  The horizontal field of view, for spurious targets.
+   * @param vertFOV   The vertical field of view, for spurious targets.
+   * @param targets   The targets, modified in place.
+   * @param areaScale Converts the area of spurious targets from pixels to
+   *                  the units of the targets' area, e.g. percent of the
+   *                  image.
+   */
+  void Apply(uint64_t frame, units::degree_t horizFOV,
+             units::degree_t vertFOV, std::vector<PhotonTrackedTarget>& targets,
+             double areaScale = 1.0) const;
+
+ private:
+  Philox4x32 rng;
+  double angleStdDev = 0.0;
+  double angleStdDevPerMeter = 0.0;
+  double areaStdDev = 0.0;
+  double falseNegativeRate = 0.0;
+  double falsePositiveRate = 0.0;
+  double falsePositiveMaxArea = 1.0;
+};
+
+}  // namespace photonlib
@@ -0,0 +1,107 @@
+/**
+ * Copyright (C) 2020-2021 Photon Vision.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include <frc/geometry/Translation2d.h>
+#include <units/length.h>
+#include <wpi/ArrayRef.h>
+
+namespace photonlib {
+
+/**
+ * A vertical wall on the field that blocks the camera's view, such as a
+ * field element or another robot. Seen from above it is a line segment.
+ */
+struct SimObstacle {
+  frc::Translation2d start;
+  frc::Translation2d end;
+  /** The height of the top of the wall; by default it blocks everything. */
+  units::meter_t height =
+      units::meter_t(std::numeric_limits<double>::infinity());
+};
+
+/**
+ * A bounding volume hierarchy over obstacle segments, for testing whether
+ * the line of sight from a camera to a target is blocked. A query only
+ * visits the parts of the tree whose bounding boxes the line of sight
+ * crosses, so its cost grows with the logarithm of the number of obstacles
+ * rather than linearly.
+ */
+class SimObstacleBvh {
+ public:
+  /**
+   * Removes every obstacle.
+   */
+  void Clear();
+
+  /**
+   * Adds obstacles and rebuilds the tree. Add obstacles in bulk where
+   * possible, since each call rebuilds the whole tree.
+   * @param obstacles The obstacles to add.
+   */
+  void Add(wpi::ArrayRef<SimObstacle> obstacles);
+
+  /**
+   * Returns the number of obstacles.
+   * @return The number of obstacles.
+   */
+  size_t Size() const { return obstacles.size(); }
+
+  /**
+   * Returns whether any obstacle blocks the line of sight between two
+   * points. Obstacles touching the target end of the line, such as the wall
+   * a target is mounted on, don't block it.
+   *
+   * @param from       The ground-plane position of the camera.
+   * @param fromHeight The height of the camera.
+   * @param to         The ground-plane position of the target.
+   * @param toHeight   The height of the target.
+   * @return Whether the line of sight is blocked.
+   */
+  bool Occludes(const frc::Translation2d& from, units::meter_t fromHeight,
+                const frc::Translation2d& to, units::meter_t toHeight) const;
+
+ private:
+  struct Segment {
+    double x0, y0, x1, y1;
+    double height;
+  };
+
+  // Leaves hold count segments from first; inner nodes have count 0 and
+  // their children at index + 1 and at second.
+  struct Node {
+    double minX, minY, maxX, maxY;
+    uint32_t first;
+    uint32_t second;
+    uint32_t count;
+  };
+
+  std::vector<SimObstacle> obstacles;
+  std::vector<Segment> segments;
+  std::vector<Node> nodes;
+
+  void Rebuild();
+  void Build(size_t begin, size_t end);
+};
+
+}  // namespace photonlib
@@ -34,6 +34,20 @@ namespace photonlib {
  */
 class SimPhotonCamera : public PhotonCamera {
  public:
+  /**
+   * How submitted frames reach readers of the camera.
+   */
+  enum DeliveryMode {
+    /** Encode each result into a Packet and publish it to NetworkTables. */
+    kNetworkTables,
+    /**
+     * Hand each result to the PhotonCameras in this process directly,
+     * skipping the Packet encoding and NetworkTables. Readers in other
+     * processes, such as dashboards, see nothing.
+     */
+    kInProcess
+  };
+
   /**
    * Constructs a Simulated PhotonCamera from a root table.
    *
@@ -58,8 +72,24 @@ class SimPhotonCamera : public PhotonCamera {
   void SubmitProcessedFrame(units::second_t latency,
                             wpi::ArrayRef<PhotonTrackedTarget> tgtList);
 
+  /**
+   * Sets how submitted frames reach readers. Defaults to kNetworkTables.
+   * @param mode The delivery mode.
+   */
+  void SetDeliveryMode(DeliveryMode mode);
+
+  /**
+   * Returns how submitted frames reach readers.
+   * @return The delivery mode.
+   */
+  DeliveryMode GetDeliveryMode() const { return deliveryMode; }
+
  private:
   mutable Packet simPacket;
+  DeliveryMode deliveryMode = kNetworkTables;
+  // Tags in-process results, which readers ignore once this camera (and any
+  // copy of it) is destroyed.
+  std::shared_ptr<const void> publisherToken = std::make_shared<char>();
 };
 
 }  // namespace photonlib
@@ -0,0 +1,235 @@
+/**
+ * Copyright (C) 2020-2021 Photon Vision.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <frc/geometry/Pose2d.h>
+#include <units/angle.h>
+#include <units/length.h>
+
+#include "photonlib/SimVisionTarget.h"
+
+namespace photonlib {
+
+/**
+ * The intrinsics of a pinhole camera: focal lengths and principal point in
+ * pixels, and the image size.
+ */
+struct SimCameraIntrinsics {
+  /**
+   * Constructs SimCameraIntrinsics.
+   * @param fx     The horizontal focal length, in pixels.
+   * @param fy     The vertical focal length, in pixels.
+   * @param cx     The horizontal principal point, in pixels from the left.
+   * @param cy     The vertical principal point, in pixels from the top.
+   * @param width  The image width, in pixels.
+   * @param height The image height, in pixels.
+   */
+  SimCameraIntrinsics(double fx, double fy, double cx, double cy, int width,
+                      int height)
+      : fx(fx), fy(fy), cx(cx), cy(cy), width(width), height(height) {}
+
+  /**
+   * Returns the intrinsics of an ideal camera with square pixels and a
+   * centered principal point, from its diagonal field of view.
+   * @param diagFOV The diagonal field of view.
+   * @param width   The image width, in pixels.
+   * @param height  The image height, in pixels.
+   * @return The intrinsics.
+   */
+  static SimCameraIntrinsics FromFOV(units::degree_t diagFOV, int width,
+                                     int height);
+
+  /**
+   * Returns the horizontal field of view.
+   * @return The horizontal field of view.
+   */
+  units::radian_t HorizontalFOV() const;
+
+  /**
+   * Returns the vertical field of view.
+   * @return The vertical field of view.
+   */
+  units::radian_t VerticalFOV() const;
+
+  double fx;
+  double fy;
+  double cx;
+  double cy;
+  int width;
+  int height;
+};
+
+/**
+ * A point in image coordinates, in pixels.
+ */
+struct SimPixel {
+  double u;
+  double v;
+};
+
+/**
+ * A rectangle in image coordinates, in pixels.
+ */
+struct SimImageBounds {
+  double minU;
+  double maxU;
+  double minV;
+  double maxV;
+};
+
+class SimLensDistortion;
+
+/**
+ * The per-frame constants of a pinhole camera, in the plain doubles used by
+ * the projection kernel.
+ */
+struct SimPinholeView {
+  /**
+   * Constructs a SimPinholeView.
+   * @param pose       The field-relative pose of the camera.
+   * @param height     The height of the camera off the ground.
+   * @param pitch      The pitch of the camera above the horizon.
+   * @param intrinsics The camera intrinsics.
+   * @param distortion The lens distortion, or null for an ideal lens. Must
+   *                   outlive the view.
+   */
+  SimPinholeView(const frc::Pose2d& pose, units::meter_t height,
+                 units::radian_t pitch, const SimCameraIntrinsics& intrinsics,
+                 const SimLensDistortion* distortion = nullptr);
+
+  double x, y, height;
+  double cosYaw, sinYaw;
+  double cosPitch, sinPitch;
+  SimCameraIntrinsics intrinsics;
+  const SimLensDistortion* distortion;
+  // The part of the ideal image that can end up in the real one.
+  SimImageBounds bounds;
+};
+
+/**
+ * The shape of a set of targets, as a struct of arrays for the projection
+ * kernel. Each target is a rectangle standing upright at its pose, facing
+ * along the pose's heading.
+ */
+struct SimTargetGeometry {
+  std::vector<double> xs;
+  std::vector<double> ys;
+  std::vector<double> heights;
+  std::vector<double> cosHeadings;
+  std::vector<double> sinHeadings;
+  std::vector<double> halfWidths;
+  std::vector<double> halfHeights;
+
+  void Resize(size_t count);
+  void Set(size_t index, const SimVisionTarget& tgt);
+};
+
+/**
+ * The corners of a set of targets in a camera's frame and image, as filled
+ * in by ProjectTargets. Corners run top left, top right, bottom right,
+ * bottom left as seen from in front of the target.
+ */
+struct SimProjectedTargets {
+  static constexpr size_t kCorners = 4;
+
+  enum Status : uint8_t {
+    /** No part of the target is within the view's bounds. */
+    kHidden,
+    /** The whole target is within the view's bounds. */
+    kInside,
+    /** Part of the target may be in the image. */
+    kClipped
+  };
+
+  // Camera frame: forward along the optical axis, left, and up, in meters.
+  std::vector<double> forward[kCorners];
+  std::vector<double> left[kCorners];
+  std::vector<double> up[kCorners];
+  // Ideal image coordinates, in pixels. Only meaningful for corners in front
+  // of the camera.
+  std::vector<double> u[kCorners];
+  std::vector<double> v[kCorners];
+  std::vector<uint8_t> status;
+
+  void Resize(size_t count);
+};
+
+/**
+ * The visible part of a projected target.
+ */
+struct SimProjectedShape {
+  /** The visible area, in pixels. */
+  double area = 0.0;
+  /** The centroid of the visible area, in pixels. */
+  double centerU = 0.0;
+  double centerV = 0.0;
+  /** The angle of the target's top edge, counter-clockwise positive. */
+  units::degree_t skew{0.0};
+};
+
+/**
+ * The outline of the visible part of a projected target, in image
+ * coordinates.
+ */
+struct SimTargetOutline {
+  static constexpr size_t kMaxPoints = 32;
+
+  std::array<SimPixel, kMaxPoints> points;
+  size_t count = 0;
+};
+
+/**
+ * Projects the corners of a set of targets into a camera's ideal image,
+ * several targets at a time with the instructions in SimdBatch.h, and sorts
+ * the targets into those that are wholly outside the view's bounds, wholly
+ * inside them, and those that need clipping.
+ *
+ * @param view      The camera.
+ * @param geometry  The targets.
+ * @param count     The number of targets.
+ * @param projected Filled with the projected corners of each target.
+ */
+void ProjectTargets(const SimPinholeView& view,
+                    const SimTargetGeometry& geometry, size_t count,
+                    SimProjectedTargets& projected);
+
+/**
+ * Works out the visible part of a target ProjectTargets didn't mark hidden,
+ * clipping it against the camera's near plane and the image edges. With lens
+ * distortion, the outline's edges are split into short segments and each
+ * point is distorted before clipping, so the result is in the distorted
+ * image.
+ *
+ * @param view      The camera.
+ * @param projected The projected targets.
+ * @param index     The index of the target.
+ * @param outline   If not null, filled with the outline of the visible part.
+ * @return The visible part of the target; its area is 0 if none of it is
+ *         visible.
+ */
+SimProjectedShape MeasureProjectedTarget(const SimPinholeView& view,
+                                         const SimProjectedTargets& projected,
+                                         size_t index,
+                                         SimTargetOutline* outline = nullptr);
+
+}  // namespace photonlib
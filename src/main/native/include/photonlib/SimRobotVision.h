@@ -0,0 +1,173 @@
+/**
+ * Copyright (C) 2020-2021 Photon Vision.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <frc/geometry/Pose2d.h>
+#include <units/angle.h>
+#include <units/length.h>
+#include <units/time.h>
+#include <wpi/ArrayRef.h>
+#include <wpi/SmallVector.h>
+
+#include "photonlib/FieldLayout.h"
+#include "photonlib/PhotonPipelineResult.h"
+#include "photonlib/SimObstacleBvh.h"
+#include "photonlib/SimPhotonCamera.h"
+#include "photonlib/SimTargetLayoutFile.h"
+#include "photonlib/SimTargetStore.h"
+#include "photonlib/SimVisionSystem.h"
+#include "photonlib/SimVisionTarget.h"
+#include "photonlib/WorkStealingPool.h"
+
+namespace photonlib {
+
+/**
+ * Simulates several cameras mounted on one robot, all looking at the same
+ * targets and obstacles.
+ *
+ * The targets are stored once. Each frame, the targets within reach of any
+ * camera are culled once for the whole robot, and each camera then only
+ * tests those, with the cameras handled in parallel.
+ *
+ * <pre>
+ * SimRobotVision vision;
+ * vision.AddCamera("front", 70_deg, 15_deg, frontToRobot, 0.5_m, 20_m, 640,
+ *                  480, 0.1);
+ * vision.AddCamera("back", 70_deg, 15_deg, backToRobot, 0.5_m, 20_m, 640,
+ *                  480, 0.1);
+ * vision.AddFieldLayout(layout);
+ * vision.ProcessFrame(drivetrainSim.GetPose());
+ * </pre>
+ */
+class SimRobotVision {
+ public:
+  /**
+   * Constructs a SimRobotVision.
+   * @param pool The threads to run the cameras on.
+   */
+  explicit SimRobotVision(
+      WorkStealingPool& pool = WorkStealingPool::GetDefault());
+
+  /**
+   * Adds a camera. The parameters are those of the SimVisionSystem
+   * constructor.
+   * @return The index of the camera.
+   */
+  size_t AddCamera(const std::string& name, units::degree_t camDiagFOV,
+                   units::degree_t camPitch, frc::Transform2d cameraToRobot,
+                   units::meter_t cameraHeightOffGround,
+                   units::meter_t maxLEDRange, int cameraResWidth,
+                   int cameraResHeight, double minTargetArea);
+
+  /**
+   * Returns the number of cameras.
+   * @return The number of cameras.
+   */
+  size_t GetCameraCount() const { return cameras.size(); }
+
+  /**
+   * Returns a camera, e.g. to move it, to configure its intrinsics, noise,
+   * timing or rendering, or to read its results from its cam member. Its
+   * timing settings apply to ProcessFrame(Pose2d, second_t).
+   *
+   * The targets, obstacles and frames belong to this SimRobotVision, not to
+   * the camera. Calling the camera's own target, obstacle or ProcessFrame
+   * methods does nothing and is reported to the driver station.
+   * @param index The index of the camera.
+   * @return The camera.
+   */
+  SimVisionSystem& GetCamera(size_t index) { return *cameras[index]; }
+
+  SimTargetHandle AddSimVisionTarget(const SimVisionTarget& tgt);
+
+  /**
+   * Replaces a target added with AddSimVisionTarget, e.g. to move a game
+   * piece or another robot. Only the target's own entries are updated, so
+   * this is cheap enough to call for every moving target every frame.
+   * @param handle The handle AddSimVisionTarget returned.
+   * @param tgt    The new target.
+   * @return Whether the handle refers to a target that hasn't been removed.
+   */
+  bool UpdateTarget(SimTargetHandle handle, const SimVisionTarget& tgt);
+
+  /**
+   * Removes a target added with AddSimVisionTarget.
+   * @param handle The handle AddSimVisionTarget returned.
+   * @return Whether the handle refers to a target that hasn't been removed.
+   */
+  bool RemoveTarget(SimTargetHandle handle);
+
+  void AddFieldLayout(const FieldLayout& layout);
+
+  /**
+   * Adds every target in a layout file in one pass, which is much faster
+   * than adding them one at a time for large layouts.
+   * @param layout The layout file.
+   */
+  void AddTargetLayout(const SimTargetLayoutFile& layout);
+  void AddObstacles(wpi::ArrayRef<SimObstacle> obstacles);
+
+  /**
+   * Simulates every camera at a robot pose and publishes their results.
+   * @param robotPose The robot pose.
+   */
+  void ProcessFrame(const frc::Pose2d& robotPose);
+
+  /**
+   * Simulates every camera at the given time, each with its own frame rate,
+   * processing latency and drops, as SimVisionSystem::ProcessFrame(Pose2d,
+   * second_t) does. Only the cameras capturing a frame at this time are
+   * simulated.
+   * @param robotPose The robot pose at this time.
+   * @param now       The current time, e.g. from frc::Timer::GetFPGATimestamp.
+   */
+  void ProcessFrame(const frc::Pose2d& robotPose, units::second_t now);
+
+  /**
+   * Simulates every camera at a robot pose without publishing anything.
+   * @param robotPose The robot pose.
+   * @param results   Filled with the result for each camera. Must have one
+   *                  entry per camera.
+   */
+  void ProcessFrame(const frc::Pose2d& robotPose,
+                    wpi::MutableArrayRef<PhotonPipelineResult> results);
+
+ private:
+  WorkStealingPool& pool;
+  std::vector<std::unique_ptr<SimVisionSystem>> cameras;
+  std::vector<SimVisionSystem::FrameScratch> scratch;
+  SimTargetStore tgtStore;
+  SimObstacleBvh obstacles;
+  wpi::SmallVector<size_t, 32> robotCandidates;
+  // The cameras capturing the frame being simulated.
+  wpi::SmallVector<size_t, 8> capturing;
+  uint64_t frameCount = 0;
+
+  // Marks every camera as capturing.
+  void CaptureAll();
+  // Simulates the cameras in capturing.
+  void ComputeFrame(const frc::Pose2d& robotPose);
+};
+
+}  // namespace photonlib
@@ -0,0 +1,135 @@
+/**
+ * Copyright (C) 2020-2021 Photon Vision.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include <frc/geometry/Pose2d.h>
+#include <units/angle.h>
+#include <units/length.h>
+#include <wpi/ArrayRef.h>
+#include <wpi/SmallVector.h>
+
+namespace photonlib {
+
+/**
+ * A uniform grid over the ground-plane positions of simulated targets, used
+ * to cull targets that are out of a camera's range or horizontal field of
+ * view before any per-target trigonometry is done.
+ *
+ * The grid covers the bounding box of the targets it was last rebuilt with.
+ * Targets inserted or moved outside that box are kept in an overflow list,
+ * and the grid is rebuilt once the overflow grows too large. Moving or
+ * removing a target otherwise only touches the cells it leaves and enters.
+ */
+class SimTargetGrid {
+ public:
+  /**
+   * Removes every target.
+   */
+  void Clear();
+
+  /**
+   * Adds a target. Its index is the number of targets added before it.
+   * @param position The ground-plane position of the target.
+   */
+  void Insert(const frc::Translation2d& position);
+
+  /**
+   * Adds many targets at once, rebuilding the grid a single time rather than
+   * as the overflow list fills up.
+   * @param newXs The field-relative x of each target, in meters.
+   * @param newYs The field-relative y of each target, in meters.
+   */
+  void InsertBulk(wpi::ArrayRef<double> newXs, wpi::ArrayRef<double> newYs);
+
+  /**
+   * Moves a target, or puts back a removed one at a new position.
+   * @param index    The index of the target.
+   * @param position The new ground-plane position of the target.
+   */
+  void Move(size_t index, const frc::Translation2d& position);
+
+  /**
+   * Removes a target. Its index is kept, and is not returned by Query until
+   * the target is put back with Move.
+   * @param index The index of the target.
+   */
+  void Remove(size_t index);
+
+  /**
+   * Returns whether a target is in the grid, i.e. was added and not removed.
+   * @param index The index of the target.
+   * @return Whether the target is in the grid.
+   */
+  bool Contains(size_t index) const {
+    return index < cellOf.size() && cellOf[index] != kRemoved;
+  }
+
+  /**
+   * Returns the number of target indices in the grid, including removed
+   * ones.
+   * @return The number of target indices.
+   */
+  size_t Size() const { return xs.size(); }
+
+  /**
+   * Collects the targets which may be inside a camera's range disc and
+   * horizontal field of view wedge. The test is conservative: every target
+   * that is visible is returned, but some returned targets may not be.
+   *
+   * @param cameraPose  The field-relative pose of the camera.
+   * @param range       The largest distance the camera can see.
+   * @param halfFOV     Half of the camera's horizontal field of view.
+   * @param candidates  Filled with the indices of the candidate targets, in
+   *                    ascending order.
+   */
+  void Query(const frc::Pose2d& cameraPose, units::meter_t range,
+             units::radian_t halfFOV,
+             wpi::SmallVectorImpl<size_t>& candidates) const;
+
+ private:
+  static constexpr int kOverflow = -1;
+  static constexpr int kRemoved = -2;
+
+  // Target positions, by index.
+  std::vector<double> xs;
+  std::vector<double> ys;
+
+  // The cell each target is listed in, or kOverflow or kRemoved, and its
+  // position in that list, by index.
+  std::vector<int> cellOf;
+  std::vector<size_t> slotInCell;
+
+  // Grid bounds and dimensions.
+  double minX = 0.0;
+  double minY = 0.0;
+  double cellSize = 1.0;
+  int cols = 0;
+  int rows = 0;
+  std::vector<std::vector<size_t>> cells;
+  std::vector<size_t> overflow;
+
+  void Rebuild();
+  int CellOf(double x, double y) const;
+  void Link(size_t index);
+  void Unlink(size_t index);
+};
+
+}  // namespace photonlib
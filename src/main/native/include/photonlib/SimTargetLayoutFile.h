@@ -0,0 +1,119 @@
+/**
+ * Copyright (C) 2020-2021 Photon Vision.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <wpi/ArrayRef.h>
+
+#include "photonlib/FieldLayout.h"
+#include "photonlib/SimTargetStore.h"
+
+namespace photonlib {
+
+/**
+ * A target layout file mapped into memory, so that even a field of tens of
+ * thousands of targets opens without parsing or copying.
+ *
+ * The file is a 16 byte header followed by the targets as an array of
+ * SimPackedTarget, in the byte order of the machine that wrote it:
+ * <pre>
+ * uint32 magic ("PVTL")
+ * uint32 version
+ * uint32 target count
+ * uint32 reserved
+ * SimPackedTarget targets[count]
+ * </pre>
+ * Files written on a machine of the other byte order are rejected. JSON
+ * layouts are converted once with ConvertJson.
+ *
+ * <pre>
+ * SimTargetLayoutFile::ConvertJson("field.json", "field.bin");
+ * SimTargetLayoutFile layout("field.bin");
+ * system.AddTargetLayout(layout);
+ * </pre>
+ */
+class SimTargetLayoutFile {
+ public:
+  /**
+   * Maps a layout file. A missing or malformed file is reported to the
+   * driver station and yields an empty layout.
+   * @param path The path of the file.
+   */
+  explicit SimTargetLayoutFile(const std::string& path);
+  ~SimTargetLayoutFile();
+
+  SimTargetLayoutFile(SimTargetLayoutFile&& other);
+  SimTargetLayoutFile& operator=(SimTargetLayoutFile&& other);
+  SimTargetLayoutFile(const SimTargetLayoutFile&) = delete;
+  SimTargetLayoutFile& operator=(const SimTargetLayoutFile&) = delete;
+
+  /**
+   * Returns whether the file was mapped.
+   * @return Whether the file was mapped.
+   */
+  bool IsOpen() const { return mapping != nullptr; }
+
+  /**
+   * Returns the targets, which point into the mapped file and are valid as
+   * long as this object is.
+   * @return The targets.
+   */
+  wpi::ArrayRef<SimPackedTarget> GetTargets() const {
+    return wpi::ArrayRef<SimPackedTarget>(targets, count);
+  }
+
+  /**
+   * Writes a layout file.
+   * @param path    The path of the file.
+   * @param targets The targets.
+   * @return Whether the file was written.
+   */
+  static bool Write(const std::string& path,
+                    wpi::ArrayRef<SimPackedTarget> targets);
+
+  /**
+   * Converts a JSON layout, as read by FieldLayout::LoadJson, to a layout
+   * file.
+   * @param jsonPath The path of the JSON layout.
+   * @param path     The path of the layout file to write.
+   * @return Whether the JSON held any targets and the file was written.
+   */
+  static bool ConvertJson(const std::string& jsonPath,
+                          const std::string& path);
+
+  /**
+   * Converts field targets to the packed form.
+   * @param targets The field targets.
+   * @return The packed targets.
+   */
+  static std::vector<SimPackedTarget> Pack(wpi::ArrayRef<FieldTarget> targets);
+
+ private:
+  void* mapping = nullptr;
+  size_t mappingSize = 0;
+  const SimPackedTarget* targets = nullptr;
+  size_t count = 0;
+
+  void Unmap();
+};
+
+}  // namespace photonlib
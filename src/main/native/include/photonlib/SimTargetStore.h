@@ -0,0 +1,330 @@
+/**
+ * Copyright (C) 2020-2021 Photon Vision.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <frc/geometry/Pose2d.h>
+#include <units/angle.h>
+#include <units/length.h>
+#include <wpi/ArrayRef.h>
+#include <wpi/SmallVector.h>
+
+#include "photonlib/SimTargetGrid.h"
+#include "photonlib/SimVisionTarget.h"
+
+namespace photonlib {
+
+/**
+ * The per-frame constants of a simulated camera, in the plain doubles used by
+ * the visibility kernel.
+ */
+struct SimCameraView {
+  /**
+   * Constructs a SimCameraView.
+   * @param pose          The field-relative pose of the camera.
+   * @param height        The height of the camera off the ground.
+   * @param pitch         The pitch of the camera above the horizon.
+   * @param range         The largest distance the camera can see.
+   * @param horizFOV      The horizontal field of view.
+   * @param vertFOV       The vertical field of view.
+   * @param m2PerPxAt1m   The area in square meters covered by one pixel at a
+   *                      distance of 1 m.
+   * @param minTargetArea The smallest target area the camera reports, in
+   *                      pixels as the FOV model of SimVisionSystem measures
+   *                      it, i.e. the target's area over m2PerPxAt1m and the
+   *                      squared distance along the ground.
+   */
+  SimCameraView(const frc::Pose2d& pose, units::meter_t height,
+                units::radian_t pitch, units::meter_t range,
+                units::radian_t horizFOV, units::radian_t vertFOV,
+                double m2PerPxAt1m, double minTargetArea);
+
+  /**
+   * Moves the camera, keeping its other constants.
+   * @param newPose The field-relative pose of the camera.
+   */
+  void SetPose(const frc::Pose2d& newPose) {
+    pose = newPose;
+    x = newPose.X().to<double>();
+    y = newPose.Y().to<double>();
+    cos = newPose.Rotation().Cos();
+    sin = newPose.Rotation().Sin();
+  }
+
+  frc::Pose2d pose;
+  units::meter_t range;
+  units::radian_t halfHorizFOV;
+
+  double x, y, cos, sin;
+  double height;
+  double rangeSq;
+  double cosHalfHoriz, sinHalfHoriz;
+  double cosHalfVert, sinHalfVert;
+  double cosPitch, sinPitch;
+  // Targets smaller than this times their squared ground distance are
+  // below the minimum area.
+  double minAreaPerDistSq;
+};
+
+/**
+ * Marks which of a set of targets a camera can see, several targets at a time
+ * with the instructions in SimdBatch.h.
+ *
+ * The kernel works out each target's camera-relative position, distance,
+ * bearing, elevation and area, but compares them against the camera's limits
+ * without any trigonometry: the yaw and pitch limits become half-plane tests
+ * against the field of view edges, and the area limit a test against the
+ * squared distance. The tests are given a relative slack of 1e-9, so every
+ * target CamCanSeeTarget accepts is marked, but a target within that slack of
+ * an edge may be marked without being visible. Callers that need an exact
+ * answer rerun the scalar check on the marked targets.
+ *
+ * @param view    The camera.
+ * @param xs      The field-relative x of each target, in meters.
+ * @param ys      The field-relative y of each target, in meters.
+ * @param heights The height of each target off the ground, in meters.
+ * @param areas   The area of each target, in square meters.
+ * @param count   The number of targets.
+ * @param visible Set to 1 for each target that may be visible and 0 for the
+ *                rest.
+ * @return The number of targets marked.
+ */
+size_t ComputeVisibilityMask(const SimCameraView& view, const double* xs,
+                             const double* ys, const double* heights,
+                             const double* areas, size_t count,
+                             uint8_t* visible);
+
+/**
+ * Identifies a target added to a SimTargetStore. A handle goes stale when its
+ * target is removed, even if the store later reuses the target's slot.
+ */
+struct SimTargetHandle {
+  uint32_t slot = UINT32_MAX;
+  uint32_t generation = 0;
+
+  bool operator==(const SimTargetHandle& other) const {
+    return slot == other.slot && generation == other.generation;
+  }
+  bool operator!=(const SimTargetHandle& other) const {
+    return !operator==(other);
+  }
+};
+
+/**
+ * A target in the packed form of a SimTargetLayoutFile, and of
+ * SimTargetStore::AddBulk. Lengths are in meters and the rotation is in
+ * radians.
+ */
+struct SimPackedTarget {
+  double x;
+  double y;
+  double rotation;
+  double heightAboveGround;
+  double width;
+  double height;
+
+  /**
+   * Returns whether the target can be simulated: every value is finite and
+   * the width and height are positive.
+   */
+  bool IsValid() const {
+    return std::isfinite(x) && std::isfinite(y) && std::isfinite(rotation) &&
+           std::isfinite(heightAboveGround) && std::isfinite(width) &&
+           std::isfinite(height) && width > 0 && height > 0;
+  }
+};
+
+/**
+ * The simulated targets, kept as a struct of arrays so the visibility kernel
+ * can load several targets at once. The original SimVisionTarget objects are
+ * kept alongside for the exact per-target math.
+ *
+ * Each target lives in a slot, which is its index. Removing a target frees
+ * its slot for the next one added, so indices stay stable and no arrays are
+ * compacted. Updating or removing a target only touches its slot and the grid
+ * cells it leaves and enters.
+ */
+class SimTargetStore {
+ public:
+  /**
+   * Working storage for FindCandidates, reused between frames so that
+   * processing a frame doesn't allocate once it has warmed up.
+   */
+  struct Scratch {
+    wpi::SmallVector<size_t, 16> gridHits;
+    std::vector<double> xs;
+    std::vector<double> ys;
+    std::vector<double> heights;
+    std::vector<double> areas;
+    std::vector<uint8_t> visible;
+  };
+
+  /**
+   * Removes every target.
+   */
+  void Clear();
+
+  /**
+   * Reserves space for targets that are about to be added.
+   * @param count The number of targets to reserve space for.
+   */
+  void Reserve(size_t count);
+
+  /**
+   * Adds a target, in a freed slot if there is one, else in a new slot at the
+   * end.
+   * @param tgt The target to add.
+   * @return The handle of the target.
+   */
+  SimTargetHandle Add(const SimVisionTarget& tgt);
+
+  /**
+   * Adds many targets in one pass: the arrays are reserved once and the grid
+   * is rebuilt once. The targets are put in new slots at the end, in order,
+   * and don't reuse freed slots. Targets that aren't valid are skipped and
+   * reported to the driver station.
+   * @param packed The targets to add.
+   * @return Whether every target was valid and added.
+   */
+  bool AddBulk(wpi::ArrayRef<SimPackedTarget> packed);
+
+  /**
+   * Replaces a target, e.g. to move it.
+   * @param handle The handle of the target.
+   * @param tgt    The new target.
+   * @return Whether the handle was valid.
+   */
+  bool Update(SimTargetHandle handle, const SimVisionTarget& tgt);
+
+  /**
+   * Removes a target.
+   * @param handle The handle of the target.
+   * @return Whether the handle was valid.
+   */
+  bool Remove(SimTargetHandle handle);
+
+  /**
+   * Returns whether a handle refers to a target in the store.
+   * @param handle The handle.
+   * @return Whether the target is in the store.
+   */
+  bool Contains(SimTargetHandle handle) const {
+    return handle.slot < generations.size() &&
+           generations[handle.slot] == handle.generation &&
+           grid.Contains(handle.slot);
+  }
+
+  /**
+   * Returns the number of targets.
+   * @return The number of targets.
+   */
+  size_t Size() const { return targets.size() - freeSlots.size(); }
+
+  /**
+   * Returns a target by index.
+   * @param index The index of the target.
+   * @return The target.
+   */
+  const SimVisionTarget& operator[](size_t index) const {
+    return targets[index];
+  }
+
+  /**
+   * Returns the field-relative x of a target, in meters.
+   * @param index The index of the target.
+   * @return The x coordinate.
+   */
+  double GetX(size_t index) const { return xs[index]; }
+
+  /**
+   * Returns the field-relative y of a target, in meters.
+   * @param index The index of the target.
+   * @return The y coordinate.
+   */
+  double GetY(size_t index) const { return ys[index]; }
+
+  /**
+   * Returns the height of a target off the ground, in meters.
+   * @param index The index of the target.
+   * @return The height.
+   */
+  double GetHeight(size_t index) const { return heights[index]; }
+
+  /**
+   * Returns the area of a target, in square meters.
+   * @param index The index of the target.
+   * @return The area.
+   */
+  double GetArea(size_t index) const { return areas[index]; }
+
+  /**
+   * Collects the targets which may be visible to a camera: those the grid
+   * places in the camera's range and horizontal field of view, and which the
+   * visibility kernel then marks. Every visible target is returned, in
+   * ascending order of index.
+   *
+   * @param view       The camera.
+   * @param scratch    Working storage.
+   * @param candidates Filled with the indices of the candidate targets.
+   */
+  void FindCandidates(const SimCameraView& view, Scratch& scratch,
+                      wpi::SmallVectorImpl<size_t>& candidates) const;
+
+  /**
+   * Like FindCandidates, but runs the visibility kernel over a given set of
+   * targets instead of the grid's hits, e.g. targets already culled for a
+   * whole robot.
+   *
+   * @param view       The camera.
+   * @param indices    The targets to test, in ascending order.
+   * @param scratch    Working storage.
+   * @param candidates Filled with the indices of the candidate targets.
+   */
+  void FilterCandidates(const SimCameraView& view,
+                        wpi::ArrayRef<size_t> indices, Scratch& scratch,
+                        wpi::SmallVectorImpl<size_t>& candidates) const;
+
+  /**
+   * Returns the grid over the targets' positions.
+   * @return The grid.
+   */
+  const SimTargetGrid& GetGrid() const { return grid; }
+
+ private:
+  std::vector<SimVisionTarget> targets;
+
+  // The fields the visibility kernel reads, by index.
+  std::vector<double> xs;
+  std::vector<double> ys;
+  std::vector<double> heights;
+  std::vector<double> areas;
+
+  // Bumped each time a slot's target is removed, to spot stale handles.
+  std::vector<uint32_t> generations;
+  std::vector<uint32_t> freeSlots;
+
+  SimTargetGrid grid;
+
+  void Store(size_t slot, const SimVisionTarget& tgt);
+};
+
+}  // namespace photonlib
@@ -0,0 +1,106 @@
+/**
+ * Copyright (C) 2020-2021 Photon Vision.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include <frc/geometry/Pose2d.h>
+#include <units/time.h>
+#include <wpi/ArrayRef.h>
+#include <wpi/StringRef.h>
+
+namespace photonlib {
+
+/**
+ * A time-stamped sequence of robot poses, e.g. a recorded or planned
+ * autonomous routine, for running the vision simulation over.
+ *
+ * Trajectories may be loaded from CSV with one sample per line:
+ * <pre>
+ * time,x,y,rotation
+ * 0.000,1.0,2.0,0.0
+ * 0.001,1.001,2.0,0.05
+ * </pre>
+ * where time is in seconds, lengths are in meters and rotation is in
+ * degrees. A header line and lines starting with '#' are skipped. They may
+ * also be saved and loaded in a binary form, encoded as a Packet.
+ */
+class SimTrajectory {
+ public:
+  struct Sample {
+    units::second_t time;
+    frc::Pose2d pose;
+  };
+
+  /**
+   * Constructs an empty trajectory.
+   */
+  SimTrajectory() = default;
+
+  /**
+   * Constructs a trajectory from samples.
+   * @param samples The samples, in time order.
+   */
+  explicit SimTrajectory(wpi::ArrayRef<Sample> samples)
+      : samples(samples.begin(), samples.end()) {}
+
+  /**
+   * Parses a trajectory from CSV text. Malformed input is reported to the
+   * driver station and yields an empty trajectory.
+   * @param csv The CSV text.
+   * @return The parsed trajectory.
+   */
+  static SimTrajectory FromCsv(wpi::StringRef csv);
+
+  /**
+   * Loads a trajectory from a file: CSV if the name ends in .csv, binary
+   * otherwise. A missing or malformed file is reported to the driver
+   * station and yields an empty trajectory.
+   * @param path The path of the file.
+   * @return The loaded trajectory.
+   */
+  static SimTrajectory Load(const std::string& path);
+
+  /**
+   * Saves the trajectory in binary form.
+   * @param path The path of the file.
+   * @return Whether the file was written.
+   */
+  bool SaveBinary(const std::string& path) const;
+
+  /**
+   * Returns the samples, in time order.
+   * @return The samples.
+   */
+  wpi::ArrayRef<Sample> GetSamples() const { return samples; }
+
+  /**
+   * Returns the number of samples.
+   * @return The number of samples.
+   */
+  size_t Size() const { return samples.size(); }
+
+ private:
+  std::vector<Sample> samples;
+
+  static SimTrajectory FromBinary(std::vector<char> data);
+};
+
+}  // namespace photonlib
@@ -0,0 +1,151 @@
+/**
+ * Copyright (C) 2020-2021 Photon Vision.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include <frc/geometry/Pose2d.h>
+#include <units/time.h>
+#include <wpi/ArrayRef.h>
+
+#include "photonlib/PhotonPipelineResult.h"
+#include "photonlib/SimTrajectory.h"
+#include "photonlib/SimVisionSystem.h"
+#include "photonlib/WorkStealingPool.h"
+
+namespace photonlib {
+
+/**
+ * Summary statistics of a SimTrajectoryRunner run.
+ */
+struct SimRunStats {
+  size_t frames = 0;
+  size_t framesWithTargets = 0;
+  // The number of targets seen, summed over every frame.
+  size_t targetSightings = 0;
+  size_t maxTargetsInFrame = 0;
+  // The longest stretch of trajectory time in which no target was seen.
+  units::second_t longestBlindStretch{0};
+  // The wall clock time spent simulating the frames.
+  units::second_t elapsed{0};
+
+  /**
+   * Returns the number of frames simulated per second of wall clock time.
+   * @return The frame rate.
+   */
+  double FramesPerSecond() const {
+    return elapsed.to<double>() > 0 ? frames / elapsed.to<double>() : 0.0;
+  }
+
+  /**
+   * Returns the fraction of frames in which at least one target was seen.
+   * @return The fraction (0-1).
+   */
+  double VisibleFraction() const {
+    return frames > 0 ? static_cast<double>(framesWithTargets) / frames : 0.0;
+  }
+};
+
+/**
+ * Runs a SimVisionSystem over a whole trajectory as fast as possible, without
+ * NetworkTables, e.g. to check what the camera sees during an autonomous
+ * routine or to produce results for offline analysis.
+ *
+ * <pre>
+ * SimVisionSystem system("cam", 70_deg, 15_deg, cameraToRobot, 0.5_m, 20_m,
+ *                        640, 480, 0.1);
+ * system.AddFieldLayout(FieldLayout::LoadJson("layout.json"));
+ * SimTrajectoryRunner runner(system);
+ * const SimRunStats& stats = runner.Run(SimTrajectory::Load("auto.csv"));
+ * runner.WriteResults("auto-results.bin");
+ * </pre>
+ *
+ * The results file is a Packet holding a magic number, a format version and
+ * the frame count, then for each frame its time and latency in seconds as
+ * doubles, its target count as an int32 and its targets in the usual Packet
+ * encoding.
+ */
+class SimTrajectoryRunner {
+ public:
+  /**
+   * Constructs a SimTrajectoryRunner.
+   * @param system The camera to simulate. Its targets and placement must not
+   *               change while Run is running.
+   * @param pool   The threads to spread the frames across.
+   */
+  explicit SimTrajectoryRunner(
+      SimVisionSystem& system,
+      WorkStealingPool& pool = WorkStealingPool::GetDefault())
+      : system(system), pool(pool) {}
+
+  /**
+   * Simulates a frame at every sample of a trajectory.
+   * @param trajectory The trajectory.
+   * @return The statistics of the run.
+   */
+  const SimRunStats& Run(const SimTrajectory& trajectory);
+
+  /**
+   * Returns the statistics of the last run.
+   * @return The statistics.
+   */
+  const SimRunStats& GetStats() const { return stats; }
+
+  /**
+   * Returns the time of each frame of the last run.
+   * @return The times.
+   */
+  wpi::ArrayRef<units::second_t> GetTimes() const { return times; }
+
+  /**
+   * Returns the result of each frame of the last run.
+   * @return The results.
+   */
+  wpi::ArrayRef<PhotonPipelineResult> GetResults() const { return results; }
+
+  /**
+   * Writes the results of the last run to a file.
+   * @param path The path of the file.
+   * @return Whether the file was written.
+   */
+  bool WriteResults(const std::string& path) const;
+
+  /**
+   * Reads a file written by WriteResults. A missing or malformed file is
+   * reported to the driver station and leaves both vectors empty.
+   * @param path    The path of the file.
+   * @param times   Filled with the time of each frame.
+   * @param results Filled with the result of each frame.
+   * @return Whether the file was read.
+   */
+  static bool ReadResults(const std::string& path,
+                          std::vector<units::second_t>& times,
+                          std::vector<PhotonPipelineResult>& results);
+
+ private:
+  SimVisionSystem& system;
+  WorkStealingPool& pool;
+  std::vector<frc::Pose2d> poses;
+  std::vector<units::second_t> times;
+  std::vector<PhotonPipelineResult> results;
+  SimRunStats stats;
+};
+
+}  // namespace photonlib
@@ -17,26 +17,48 @@
 
 #pragma once
 
+#include <memory>
+#include <optional>
 #include <string>
 #include <vector>
 
 #include <frc/geometry/Translation2d.h>
 #include <units/angle.h>
 #include <units/area.h>
+#include <units/frequency.h>
 #include <units/length.h>
 #include <units/time.h>
 #include <wpi/ArrayRef.h>
 #include <wpi/SmallVector.h>
 
+#include "photonlib/FieldLayout.h"
+#include "photonlib/PhotonPipelineResult.h"
+#include "photonlib/SimFrameFormat.h"
+#include "photonlib/SimFrameScheduler.h"
+#include "photonlib/SimLensDistortion.h"
+#include "photonlib/SimNoiseModel.h"
+#include "photonlib/SimObstacleBvh.h"
 #include "photonlib/SimPhotonCamera.h"
+#include "photonlib/SimPinholeCamera.h"
+#include "photonlib/SimTargetLayoutFile.h"
+#include "photonlib/SimTargetStore.h"
 #include "photonlib/SimVisionTarget.h"
+#include "photonlib/WorkStealingPool.h"
+
+namespace cs {
+class CvSource;
+}  // namespace cs
 
 namespace photonlib {
 
+class SimFrameRenderer;
+
 /**
  * Represents a camera that is connected to PhotonVision.
  */
 class SimVisionSystem {
+  friend class SimRobotVision;
+
  public:
   explicit SimVisionSystem(const std::string& name, units::degree_t camDiagFOV,
                            units::degree_t camPitch,
@@ -44,12 +66,178 @@ class SimVisionSystem {
                            units::meter_t cameraHeightOffGround,
                            units::meter_t maxLEDRange, int cameraResWidth,
                            int cameraResHeight, double minTargetArea);
+  ~SimVisionSystem();
+  SimVisionSystem(SimVisionSystem&&);
+  SimVisionSystem& operator=(SimVisionSystem&&);
+
+  SimTargetHandle AddSimVisionTarget(SimVisionTarget tgt);
+
+  /**
+   * Replaces a target added with AddSimVisionTarget, e.g. to move a game
+   * piece or another robot. Only the target's own entries are updated, so
+   * this is cheap enough to call for every moving target every frame.
+   * @param handle The handle AddSimVisionTarget returned.
+   * @param tgt    The new target.
+   * @return Whether the handle refers to a target that hasn't been removed.
+   */
+  bool UpdateTarget(SimTargetHandle handle, const SimVisionTarget& tgt);
+
+  /**
+   * Removes a target added with AddSimVisionTarget.
+   * @param handle The handle AddSimVisionTarget returned.
+   * @return Whether the handle refers to a target that hasn't been removed.
+   */
+  bool RemoveTarget(SimTargetHandle handle);
+
+  void AddFieldLayout(const FieldLayout& layout);
 
-  void AddSimVisionTarget(SimVisionTarget tgt);
+  /**
+   * Adds every target in a layout file in one pass, which is much faster
+   * than adding them one at a time for large layouts.
+   * @param layout The layout file.
+   */
+  void AddTargetLayout(const SimTargetLayoutFile& layout);
+
+  /**
+   * Adds targets in the packed form of a layout file in one pass, e.g. ones
+   * generated by a tool rather than read from a file.
+   * @param targets The targets.
+   * @return Whether every target was valid and added. Invalid ones are
+   *     skipped, see SimPackedTarget::IsValid.
+   */
+  bool AddTargets(wpi::ArrayRef<SimPackedTarget> targets);
+
+  /**
+   * Adds obstacles which hide any target behind them from the camera.
+   * @param obstacles The obstacles to add.
+   */
+  void AddObstacles(wpi::ArrayRef<SimObstacle> obstacles);
+  void AddObstacle(const SimObstacle& obstacle);
   void MoveCamera(frc::Transform2d newcameraToRobot,
                   units::meter_t newCamHeight, units::degree_t newCamPitch);
+
+  /**
+   * Simulates a frame and publishes its result at once, with zero latency.
+   * The frame rate, latency and drop settings only apply to
+   * ProcessFrame(Pose2d, second_t), which takes the time to simulate at.
+   * @param robotPose The robot pose.
+   */
   void ProcessFrame(frc::Pose2d robotPose);
 
+  /**
+   * Simulates the camera at the given time. Frames are captured at the
+   * configured frame rate, and each result is published once its simulated
+   * processing time has passed, with the time since capture as its latency.
+   * With the default timing settings this behaves like ProcessFrame(Pose2d).
+   *
+   * @param robotPose The robot pose at this time.
+   * @param now       The current time, e.g. from frc::Timer::GetFPGATimestamp.
+   */
+  void ProcessFrame(frc::Pose2d robotPose, units::second_t now);
+
+  /**
+   * Switches the camera to a pinhole model with the given intrinsics, which
+   * also set its resolution and fields of view. Each target's corners are
+   * then projected into the image, so the target's rotation matters and any
+   * part of it outside the image is clipped off. The reported area, yaw,
+   * pitch and skew come from the visible outline rather than from the
+   * target's center. Reported area is then in percent of the image rather
+   * than in pixels, but minTargetArea and the noise model's spurious target
+   * area are still given in pixels.
+   * @param intrinsics The camera intrinsics.
+   */
+  void SetCameraIntrinsics(const SimCameraIntrinsics& intrinsics);
+
+  /**
+   * Like SetCameraIntrinsics(SimCameraIntrinsics), but with a lens that
+   * bends the image. Target outlines and the reported yaw, pitch, area and
+   * skew are taken from the distorted image, as a real camera sees it. The
+   * distortion lookup tables are built here, once.
+   * @param intrinsics   The camera intrinsics.
+   * @param coefficients The lens distortion coefficients.
+   */
+  void SetCameraIntrinsics(const SimCameraIntrinsics& intrinsics,
+                           const SimDistortionCoefficients& coefficients);
+
+  /**
+   * Turns on drawing a synthetic image of each frame simulated by
+   * ProcessFrame, with the visible targets filled in over a plain
+   * background. Frames simulated by ProcessFrames are not drawn.
+   * @param format The pixel format.
+   */
+  void EnableFrameRendering(SimFrameFormat format = SimFrameFormat::kGray);
+
+  /**
+   * Returns the renderer holding the latest synthetic image, or null if
+   * rendering is off. Use it to set colors or get the image as a cv::Mat.
+   * @return The renderer.
+   */
+  SimFrameRenderer* GetFrameRenderer() { return renderer.get(); }
+
+  /**
+   * Puts each synthetic image to a cscore source as it is drawn, e.g. one
+   * from frc::CameraServer::PutVideo. Turns on rendering if it is off.
+   * @param source The source.
+   */
+  void SetFrameSource(cs::CvSource source);
+
+  /**
+   * Sets the rate the camera captures frames at, for ProcessFrame(Pose2d,
+   * second_t). Zero captures a frame on every call.
+   * @param frameRate The frame rate.
+   */
+  void SetFrameRate(units::hertz_t frameRate);
+
+  /**
+   * Sets the distribution of the simulated processing time of each frame.
+   * @param mean   The mean processing time.
+   * @param stdDev The standard deviation of the processing time.
+   */
+  void SetLatency(units::second_t mean, units::second_t stdDev);
+
+  /**
+   * Sets the probability that a captured frame is dropped.
+   * @param dropRate The probability (0-1).
+   */
+  void SetFrameDropRate(double dropRate);
+
+  /**
+   * Restarts the random latency and drop draws from a seed, so that a run
+   * can be repeated exactly.
+   * @param seed The seed.
+   */
+  void SetTimingSeed(uint64_t seed);
+
+  /**
+   * Forgets the frames still being processed and the capture schedule, e.g.
+   * before simulating from an earlier time again. The random draws carry on;
+   * see SetTimingSeed.
+   */
+  void ResetTiming();
+
+  /**
+   * Sets the measurement noise added to every frame. Frames are numbered in
+   * the order they are simulated, including those from ProcessFrames, and
+   * the noise on a frame depends only on the model's seed and its number.
+   * @param model The noise model.
+   */
+  void SetNoiseModel(const SimNoiseModel& model);
+
+  /**
+   * Simulates the camera at many robot poses, writing each frame's result
+   * into caller-owned storage instead of publishing it to NetworkTables.
+   * The poses are spread across the threads of a WorkStealingPool. Targets
+   * and camera placement must not be changed while this runs.
+   *
+   * @param robotPoses The robot poses to simulate.
+   * @param results    Filled with the result for each pose. Must be the same
+   *                   size as robotPoses.
+   * @param pool       The threads to run on.
+   */
+  void ProcessFrames(wpi::ArrayRef<frc::Pose2d> robotPoses,
+                     wpi::MutableArrayRef<PhotonPipelineResult> results,
+                     WorkStealingPool& pool = WorkStealingPool::GetDefault());
+
  private:
   units::degree_t camDiagFOV;
   units::degree_t camPitch;
@@ -61,11 +249,78 @@ class SimVisionSystem {
   double minTargetArea;
   units::degree_t camHorizFOV;
   units::degree_t camVertFOV;
-  std::vector<SimVisionTarget> tgtList = {};
+  SimTargetStore tgtStore;
+  SimObstacleBvh obstacles;
+
+  // Working storage for simulating one frame; one per thread.
+  struct FrameScratch {
+    SimTargetStore::Scratch store;
+    wpi::SmallVector<size_t, 16> candidateIdxs;
+    std::vector<PhotonTrackedTarget> visibleTgtList;
+    // The store indices of the targets in visibleTgtList, before noise.
+    wpi::SmallVector<size_t, 16> visibleIdxs;
+    SimTargetGeometry geometry;
+    SimProjectedTargets projected;
+  };
+  FrameScratch scratch;
+  // One per worker of the pool ProcessFrames runs on.
+  std::vector<FrameScratch> workerScratch;
+
+  // Values derived from the camera's placement and field of view, in the
+  // plain doubles the per-target checks use. Angles are in degrees and
+  // lengths in meters.
+  struct CameraConstants {
+    frc::Transform2d robotToCamera;
+    double height = 0.0;
+    double pitch = 0.0;
+    double halfHorizFOV = 0.0;
+    double halfVertFOV = 0.0;
+    double range = 0.0;
+    // The area in square meters covered by one pixel at a distance of 1 m.
+    double m2PerPxAt1m = 0.0;
+    // The view the visibility kernel culls with, at the origin.
+    SimCameraView cullView{frc::Pose2d(), units::meter_t(0.0),
+                           units::radian_t(0.0), units::meter_t(0.0),
+                           units::radian_t(0.0), units::radian_t(0.0),
+                           0.0, 0.0};
+  };
+  CameraConstants constants;
+  SimFrameScheduler scheduler;
+  SimNoiseModel noise;
+  uint64_t frameCount = 0;
+  std::optional<SimCameraIntrinsics> intrinsics;
+  std::optional<SimLensDistortion> distortion;
+  // Held by pointer so that this header doesn't need OpenCV or cscore.
+  std::unique_ptr<SimFrameRenderer> renderer;
+  std::unique_ptr<cs::CvSource> frameSource;
+  // Set for the cameras of a SimRobotVision, whose targets, obstacles and
+  // frames belong to the robot rather than to this object.
+  bool mountedOnRobot = false;
 
-  double GetM2PerPx(units::meter_t dist);
-  bool CamCanSeeTarget(units::meter_t distHypot, units::degree_t yaw,
-                       units::degree_t pitch, double area);
+  void ComputeFrame(const frc::Pose2d& robotPose, uint64_t frameIndex,
+                    FrameScratch& frame) const;
+  SimCameraView MakeView(const frc::Pose2d& cameraPos) const;
+  // Runs the exact visibility checks on frame.candidateIdxs and fills
+  // frame.visibleTgtList.
+  void EvaluateCandidates(const frc::Pose2d& cameraPos,
+                          const SimTargetStore& targets,
+                          const SimObstacleBvh& occluders, uint64_t frameIndex,
+                          FrameScratch& frame) const;
+  // The pinhole model's version of the checks in EvaluateCandidates.
+  void EvaluateProjected(const frc::Pose2d& cameraPos,
+                         const SimTargetStore& targets,
+                         const SimObstacleBvh& occluders,
+                         FrameScratch& frame) const;
+  // Draws the visible targets, given by their indices in targets.
+  void RenderFrame(const frc::Pose2d& robotPose, const SimTargetStore& targets,
+                   wpi::ArrayRef<size_t> visibleIdxs);
+  // Recomputes constants after the camera's placement or field of view
+  // changes.
+  void UpdateCameraConstants();
+  // Reports and returns true if this is mounted on a SimRobotVision.
+  bool RejectIfMounted(const char* method) const;
+  bool CamCanSeeTarget(double distHypot, double yaw, double pitch,
+                       double area) const;
 
  public:
   SimPhotonCamera cam = photonlib::SimPhotonCamera("Default");
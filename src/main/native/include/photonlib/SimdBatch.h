@@ -0,0 +1,154 @@
+/**
+ * Copyright (C) 2020-2021 Photon Vision.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#define PHOTONLIB_SIMD_AVX 1
+#elif defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define PHOTONLIB_SIMD_SSE2 1
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define PHOTONLIB_SIMD_NEON 1
+#endif
+
+namespace photonlib {
+namespace simd {
+
+/**
+ * A single double, with the same interface as Batch. Used on targets without
+ * double-precision vector units (e.g. the 32-bit ARM roboRIO) and for the
+ * tail of arrays that don't fill a whole Batch.
+ */
+struct Scalar {
+  static constexpr size_t kWidth = 1;
+  using Mask = bool;
+
+  double v;
+
+  static Scalar Load(const double* p) { return {*p}; }
+  static Scalar Broadcast(double d) { return {d}; }
+  void Store(double* p) const { *p = v; }
+
+  friend Scalar operator+(Scalar a, Scalar b) { return {a.v + b.v}; }
+  friend Scalar operator-(Scalar a, Scalar b) { return {a.v - b.v}; }
+  friend Scalar operator*(Scalar a, Scalar b) { return {a.v * b.v}; }
+  friend Scalar operator/(Scalar a, Scalar b) { return {a.v / b.v}; }
+  friend Scalar Abs(Scalar a) { return {std::abs(a.v)}; }
+  friend Scalar Sqrt(Scalar a) { return {std::sqrt(a.v)}; }
+  friend Mask Less(Scalar a, Scalar b) { return a.v < b.v; }
+  static Mask And(Mask a, Mask b) { return a && b; }
+  static unsigned Bits(Mask m) { return m ? 1u : 0u; }
+};
+
+#if defined(PHOTONLIB_SIMD_AVX)
+
+/** Four doubles in an AVX register. */
+struct Batch {
+  static constexpr size_t kWidth = 4;
+  using Mask = __m256d;
+
+  __m256d v;
+
+  static Batch Load(const double* p) { return {_mm256_loadu_pd(p)}; }
+  static Batch Broadcast(double d) { return {_mm256_set1_pd(d)}; }
+  void Store(double* p) const { _mm256_storeu_pd(p, v); }
+
+  friend Batch operator+(Batch a, Batch b) { return {_mm256_add_pd(a.v, b.v)}; }
+  friend Batch operator-(Batch a, Batch b) { return {_mm256_sub_pd(a.v, b.v)}; }
+  friend Batch operator*(Batch a, Batch b) { return {_mm256_mul_pd(a.v, b.v)}; }
+  friend Batch operator/(Batch a, Batch b) { return {_mm256_div_pd(a.v, b.v)}; }
+  friend Batch Abs(Batch a) {
+    return {_mm256_andnot_pd(_mm256_set1_pd(-0.0), a.v)};
+  }
+  friend Batch Sqrt(Batch a) { return {_mm256_sqrt_pd(a.v)}; }
+  friend Mask Less(Batch a, Batch b) {
+    return _mm256_cmp_pd(a.v, b.v, _CMP_LT_OQ);
+  }
+  static Mask And(Mask a, Mask b) { return _mm256_and_pd(a, b); }
+  static unsigned Bits(Mask m) {
+    return static_cast<unsigned>(_mm256_movemask_pd(m));
+  }
+};
+
+#elif defined(PHOTONLIB_SIMD_SSE2)
+
+/** Two doubles in an SSE2 register. */
+struct Batch {
+  static constexpr size_t kWidth = 2;
+  using Mask = __m128d;
+
+  __m128d v;
+
+  static Batch Load(const double* p) { return {_mm_loadu_pd(p)}; }
+  static Batch Broadcast(double d) { return {_mm_set1_pd(d)}; }
+  void Store(double* p) const { _mm_storeu_pd(p, v); }
+
+  friend Batch operator+(Batch a, Batch b) { return {_mm_add_pd(a.v, b.v)}; }
+  friend Batch operator-(Batch a, Batch b) { return {_mm_sub_pd(a.v, b.v)}; }
+  friend Batch operator*(Batch a, Batch b) { return {_mm_mul_pd(a.v, b.v)}; }
+  friend Batch operator/(Batch a, Batch b) { return {_mm_div_pd(a.v, b.v)}; }
+  friend Batch Abs(Batch a) { return {_mm_andnot_pd(_mm_set1_pd(-0.0), a.v)}; }
+  friend Batch Sqrt(Batch a) { return {_mm_sqrt_pd(a.v)}; }
+  friend Mask Less(Batch a, Batch b) { return _mm_cmplt_pd(a.v, b.v); }
+  static Mask And(Mask a, Mask b) { return _mm_and_pd(a, b); }
+  static unsigned Bits(Mask m) {
+    return static_cast<unsigned>(_mm_movemask_pd(m));
+  }
+};
+
+#elif defined(PHOTONLIB_SIMD_NEON)
+
+/** Two doubles in a NEON register. */
+struct Batch {
+  static constexpr size_t kWidth = 2;
+  using Mask = uint64x2_t;
+
+  float64x2_t v;
+
+  static Batch Load(const double* p) { return {vld1q_f64(p)}; }
+  static Batch Broadcast(double d) { return {vdupq_n_f64(d)}; }
+  void Store(double* p) const { vst1q_f64(p, v); }
+
+  friend Batch operator+(Batch a, Batch b) { return {vaddq_f64(a.v, b.v)}; }
+  friend Batch operator-(Batch a, Batch b) { return {vsubq_f64(a.v, b.v)}; }
+  friend Batch operator*(Batch a, Batch b) { return {vmulq_f64(a.v, b.v)}; }
+  friend Batch operator/(Batch a, Batch b) { return {vdivq_f64(a.v, b.v)}; }
+  friend Batch Abs(Batch a) { return {vabsq_f64(a.v)}; }
+  friend Batch Sqrt(Batch a) { return {vsqrtq_f64(a.v)}; }
+  friend Mask Less(Batch a, Batch b) { return vcltq_f64(a.v, b.v); }
+  static Mask And(Mask a, Mask b) { return vandq_u64(a, b); }
+  static unsigned Bits(Mask m) {
+    return static_cast<unsigned>((vgetq_lane_u64(m, 0) & 1) |
+                                 ((vgetq_lane_u64(m, 1) & 1) << 1));
+  }
+};
+
+#else
+
+using Batch = Scalar;
+
+#endif
+
+}  // namespace simd
+}  // namespace photonlib
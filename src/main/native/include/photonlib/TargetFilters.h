@@ -0,0 +1,257 @@
+/**
+ * Copyright (C) 2020-2021 Photon Vision.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include <wpi/SmallVector.h>
+
+#include "photonlib/PhotonPipelineResult.h"
+#include "photonlib/PhotonTrackedTarget.h"
+
+namespace photonlib {
+
+/**
+ * An exponential moving average. Each update is O(1).
+ */
+class ExponentialFilter {
+ public:
+  /**
+   * Constructs an ExponentialFilter.
+   * @param alpha The weight (0-1) given to each new measurement.
+   */
+  explicit ExponentialFilter(double alpha) : alpha(alpha) {}
+
+  /**
+   * Adds a measurement and returns the filtered value.
+   * @param value The new measurement.
+   * @return The filtered value.
+   */
+  double Calculate(double value) {
+    state = initialized ? state + alpha * (value - state) : value;
+    initialized = true;
+    return state;
+  }
+
+  /**
+   * Forgets all past measurements.
+   */
+  void Reset() { initialized = false; }
+
+ private:
+  double alpha;
+  double state = 0.0;
+  bool initialized = false;
+};
+
+/**
+ * The mean of the last few measurements, kept as a running sum over a ring
+ * buffer. Each update is O(1).
+ */
+class MovingAverageFilter {
+ public:
+  /**
+   * Constructs a MovingAverageFilter.
+   * @param window The number of measurements to average over.
+   */
+  explicit MovingAverageFilter(size_t window);
+
+  /**
+   * Adds a measurement and returns the filtered value.
+   * @param value The new measurement.
+   * @return The mean of the measurements in the window.
+   */
+  double Calculate(double value);
+
+  /**
+   * Forgets all past measurements.
+   */
+  void Reset() {
+    count = 0;
+    next = 0;
+    sum = 0.0;
+  }
+
+ private:
+  std::vector<double> values;
+  size_t count = 0;
+  size_t next = 0;
+  double sum = 0.0;
+};
+
+/**
+ * The median of the last few measurements. The window is split across a
+ * max-heap of the lower half and a min-heap of the upper half; each heap
+ * entry tracks its ring buffer slot so the expiring measurement can be
+ * removed directly. Each update is O(log w).
+ */
+class MovingMedianFilter {
+ public:
+  /**
+   * Constructs a MovingMedianFilter.
+   * @param window The number of measurements to take the median of.
+   */
+  explicit MovingMedianFilter(size_t window);
+
+  /**
+   * Adds a measurement and returns the filtered value.
+   * @param value The new measurement.
+   * @return The median of the measurements in the window.
+   */
+  double Calculate(double value);
+
+  /**
+   * Forgets all past measurements.
+   */
+  void Reset() {
+    count = 0;
+    next = 0;
+    lowerSize = 0;
+    upperSize = 0;
+  }
+
+ private:
+  std::vector<double> values;
+  // Slot indices; lower is a max-heap and upper a min-heap of values.
+  std::vector<size_t> lower;
+  std::vector<size_t> upper;
+  // For each slot, whether it is in the upper heap and its position there.
+  std::vector<bool> inUpper;
+  std::vector<size_t> heapPos;
+  size_t lowerSize = 0;
+  size_t upperSize = 0;
+  size_t count = 0;
+  size_t next = 0;
+
+  bool Before(bool isUpper, size_t a, size_t b) const;
+  void Place(bool isUpper, size_t pos, size_t slot);
+  void SiftUp(bool isUpper, size_t pos);
+  void SiftDown(bool isUpper, size_t pos);
+  void Push(bool isUpper, size_t slot);
+  size_t Pop(bool isUpper);
+  void Remove(size_t slot);
+};
+
+/**
+ * A one-dimensional Kalman filter for a value modeled as a random walk.
+ * Each update is O(1).
+ */
+class KalmanFilter1d {
+ public:
+  /**
+   * Constructs a KalmanFilter1d.
+   * @param processVariance     How much the true value is expected to change
+   *                            between measurements (variance).
+   * @param measurementVariance The variance of the measurement noise.
+   */
+  KalmanFilter1d(double processVariance, double measurementVariance)
+      : processVariance(processVariance),
+        measurementVariance(measurementVariance) {}
+
+  /**
+   * Adds a measurement and returns the filtered value.
+   * @param value The new measurement.
+   * @return The filtered value.
+   */
+  double Calculate(double value);
+
+  /**
+   * Forgets all past measurements.
+   */
+  void Reset() { initialized = false; }
+
+ private:
+  double processVariance;
+  double measurementVariance;
+  double estimate = 0.0;
+  double errorVariance = 0.0;
+  bool initialized = false;
+};
+
+/**
+ * Smooths the yaw, pitch and area of tracked targets with one of the filters
+ * above. Targets are keyed by their position in the pipeline result, so a
+ * separate set of filters is kept for the best target, the second best, and
+ * so on. All filter state is allocated at construction.
+ *
+ * <pre>
+ * TargetFilter<MovingMedianFilter> filter{MovingMedianFilter(5)};
+ * auto result = filter.Calculate(camera.GetLatestResult());
+ * </pre>
+ *
+ * @tparam Filter The scalar filter type.
+ */
+template <typename Filter>
+class TargetFilter {
+ public:
+  /**
+   * Constructs a TargetFilter.
+   * @param prototype  The filter to copy for each value of each target.
+   * @param maxTargets The number of targets to keep filters for. Targets
+   *                   beyond this are passed through unfiltered.
+   */
+  explicit TargetFilter(const Filter& prototype, size_t maxTargets = 1)
+      : filters(3 * maxTargets, prototype) {}
+
+  /**
+   * Filters a single target.
+   * @param target The target to filter.
+   * @param slot   The key of the filter set to use.
+   * @return The target with smoothed yaw, pitch and area.
+   */
+  PhotonTrackedTarget Calculate(const PhotonTrackedTarget& target,
+                                size_t slot = 0) {
+    if (3 * slot >= filters.size()) return target;
+    Filter* f = &filters[3 * slot];
+    return PhotonTrackedTarget(
+        f[0].Calculate(target.GetYaw()), f[1].Calculate(target.GetPitch()),
+        f[2].Calculate(target.GetArea()), target.GetSkew(),
+        target.GetCameraRelativePose());
+  }
+
+  /**
+   * Filters every target in a pipeline result. Filters for targets that are
+   * no longer present are reset.
+   * @param result The result to filter.
+   * @return The result with smoothed targets.
+   */
+  PhotonPipelineResult Calculate(const PhotonPipelineResult& result) {
+    auto targets = result.GetTargets();
+    wpi::SmallVector<PhotonTrackedTarget, 10> filtered;
+    for (size_t i = 0; i < targets.size(); ++i) {
+      filtered.push_back(Calculate(targets[i], i));
+    }
+    for (size_t i = 3 * targets.size(); i < filters.size(); ++i) {
+      filters[i].Reset();
+    }
+    return PhotonPipelineResult(result.GetLatency(), filtered);
+  }
+
+  /**
+   * Resets every filter.
+   */
+  void Reset() {
+    for (auto& filter : filters) filter.Reset();
+  }
+
+ private:
+  std::vector<Filter> filters;
+};
+
+}  // namespace photonlib
@@ -0,0 +1,110 @@
+/**
+ * Copyright (C) 2020-2021 Photon Vision.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace photonlib {
+
+/**
+ * A fixed set of worker threads for running loops in parallel.
+ *
+ * Each call to ParallelFor splits the index range evenly between the workers.
+ * A worker takes small chunks from the front of its own range, and once that
+ * is empty steals the back half of another worker's range, so uneven
+ * per-index costs still keep every core busy. Each range is a single atomic
+ * word, so taking and stealing are both one compare-and-swap.
+ */
+class WorkStealingPool {
+ public:
+  /**
+   * The loop body, called with the index of the worker running it (less than
+   * Size()) and the loop index.
+   */
+  using Body = std::function<void(size_t worker, size_t index)>;
+
+  /**
+   * Constructs a WorkStealingPool.
+   * @param numWorkers The number of workers, including the thread calling
+   *                   ParallelFor. Zero uses one per hardware thread.
+   */
+  explicit WorkStealingPool(size_t numWorkers = 0);
+
+  ~WorkStealingPool();
+
+  WorkStealingPool(const WorkStealingPool&) = delete;
+  WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+  /**
+   * Returns the number of workers.
+   * @return The number of workers.
+   */
+  size_t Size() const { return threads.size() + 1; }
+
+  /**
+   * Calls body once for each index in [0, count) and waits for every call
+   * to finish. Calls from different threads are run one after another; body
+   * must not call ParallelFor on the same pool.
+   *
+   * @param count The number of indices.
+   * @param body  The loop body.
+   */
+  void ParallelFor(size_t count, const Body& body);
+
+  /**
+   * Returns a pool shared by the whole process, with one worker per
+   * hardware thread.
+   * @return The shared pool.
+   */
+  static WorkStealingPool& GetDefault();
+
+ private:
+  // A half-open index range, packed as begin << 32 | end. Padded so that
+  // workers hammering their own range don't share cache lines.
+  struct alignas(64) Range {
+    std::atomic<uint64_t> bounds{0};
+  };
+
+  std::vector<std::thread> threads;
+  std::unique_ptr<Range[]> ranges;
+
+  std::mutex callMutex;
+  std::mutex mutex;
+  std::condition_variable wake;
+  std::condition_variable done;
+  const Body* job = nullptr;
+  size_t jobBase = 0;
+  uint64_t generation = 0;
+  size_t active = 0;
+  bool stopping = false;
+
+  void WorkerLoop(size_t worker);
+  void Run(size_t worker, const Body& body, size_t base);
+  bool Take(size_t worker, uint32_t* begin, uint32_t* end);
+  bool Steal(size_t worker);
+};
+
+}  // namespace photonlib
@@ -0,0 +1,74 @@
+/**
+ * Copyright (C) 2020-2021 Photon Vision.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstdint>
+
+namespace photonlib {
+
+/**
+ * The xorshift64* random number generator (Vigna, "An experimental
+ * exploration of Marsaglia's xorshift generators, scrambled").
+ *
+ * A small, fast sequential generator for code that draws values one after
+ * another from a seed, such as RANSAC sampling and frame scheduling. Where a
+ * value must be drawn independently of draw order, use Philox4x32 instead.
+ */
+class XorShiftRandom {
+ public:
+  /**
+   * Constructs a generator.
+   * @param seed The seed.
+   */
+  explicit XorShiftRandom(uint64_t seed = 0) { Seed(seed); }
+
+  /**
+   * Restarts the sequence from a seed.
+   * @param seed The seed.
+   */
+  void Seed(uint64_t seed) {
+    // xorshift has a fixed point at zero, so fold in a constant.
+    state = seed ^ kSeedMix;
+    if (state == 0) state = kSeedMix;
+  }
+
+  /**
+   * Returns the next random word.
+   * @return The random word.
+   */
+  uint64_t Next() {
+    state ^= state >> 12;
+    state ^= state << 25;
+    state ^= state >> 27;
+    return state * 0x2545F4914F6CDD1Dull;
+  }
+
+  /**
+   * Returns the next value, uniform in [0, 1).
+   * @return The uniform value.
+   */
+  double NextUniform() {
+    return static_cast<double>(Next() >> 11) / (1ull << 53);
+  }
+
+ private:
+  static constexpr uint64_t kSeedMix = 0x9E3779B97F4A7C15ull;
+  uint64_t state;
+};
+
+}  // namespace photonlib
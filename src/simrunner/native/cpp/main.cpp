@@ -0,0 +1,146 @@
+/**
+ * Copyright (C) 2020-2021 Photon Vision.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Runs the vision simulation over a recorded or planned trajectory, without
+ * NetworkTables, and writes the result of every frame to a file.
+ *
+ * Usage: photonSimRunner <trajectory> <layout> <results.bin> [options]
+ *
+ * The trajectory is CSV if its name ends in .csv and SimTrajectory's binary
+ * form otherwise. The layout is JSON if its name ends in .json and a
+ * SimTargetLayoutFile otherwise. Options:
+ *   --fov <deg>         diagonal field of view (default 70)
+ *   --pitch <deg>       camera pitch (default 15)
+ *   --height <m>        camera height off the ground (default 0.5)
+ *   --range <m>         largest distance a target is seen at (default 20)
+ *   --res <w>x<h>       resolution (default 640x480)
+ *   --min-area <pct>    smallest target area reported (default 0.1)
+ *   --camera <x,y,deg>  camera to robot transform (default 0,0,0)
+ *   --trace <path>      write trace spans as Chrome trace JSON; needs a
+ *                       photonlib built with -PphotonTracing
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+#include <frc/geometry/Transform2d.h>
+#include <units/angle.h>
+#include <units/length.h>
+#include <wpi/StringRef.h>
+
+#include "photonlib/FieldLayout.h"
+#include "photonlib/PhotonTrace.h"
+#include "photonlib/SimTargetLayoutFile.h"
+#include "photonlib/SimTrajectory.h"
+#include "photonlib/SimTrajectoryRunner.h"
+#include "photonlib/SimVisionSystem.h"
+
+namespace {
+int Usage() {
+  std::fprintf(stderr,
+               "usage: photonSimRunner <trajectory> <layout> "
+               "<results.bin> [--fov deg] [--pitch deg] [--height m] "
+               "[--range m] [--res WxH] [--min-area pct] "
+               "[--camera x,y,deg] [--trace path]\n");
+  return 2;
+}
+}  // namespace
+
+int main(int argc, char** argv) {
+  if (argc < 4) return Usage();
+  std::string trajectoryPath = argv[1];
+  std::string layoutPath = argv[2];
+  std::string resultsPath = argv[3];
+
+  double fov = 70;
+  double pitch = 15;
+  double height = 0.5;
+  double range = 20;
+  int width = 640;
+  int heightPx = 480;
+  double minArea = 0.1;
+  double camX = 0, camY = 0, camRot = 0;
+  std::string tracePath;
+  for (int i = 4; i < argc; i += 2) {
+    if (i + 1 >= argc) return Usage();
+    std::string option = argv[i];
+    const char* value = argv[i + 1];
+    if (option == "--fov") {
+      fov = std::atof(value);
+    } else if (option == "--pitch") {
+      pitch = std::atof(value);
+    } else if (option == "--height") {
+      height = std::atof(value);
+    } else if (option == "--range") {
+      range = std::atof(value);
+    } else if (option == "--res") {
+      if (std::sscanf(value, "%dx%d", &width, &heightPx) != 2) return Usage();
+    } else if (option == "--min-area") {
+      minArea = std::atof(value);
+    } else if (option == "--camera") {
+      if (std::sscanf(value, "%lf,%lf,%lf", &camX, &camY, &camRot) != 3) {
+        return Usage();
+      }
+    } else if (option == "--trace") {
+      tracePath = value;
+    } else {
+      return Usage();
+    }
+  }
+
+  auto trajectory = photonlib::SimTrajectory::Load(trajectoryPath);
+  if (trajectory.Size() == 0) return 1;
+
+  photonlib::SimVisionSystem system(
+      "photonSimRunner", units::degree_t(fov), units::degree_t(pitch),
+      frc::Transform2d(frc::Translation2d(units::meter_t(camX),
+                                          units::meter_t(camY)),
+                       units::degree_t(camRot)),
+      units::meter_t(height), units::meter_t(range), width, heightPx,
+      minArea);
+  if (wpi::StringRef(layoutPath).endswith(".json")) {
+    auto layout = photonlib::FieldLayout::LoadJson(layoutPath);
+    if (layout.Size() == 0) return 1;
+    system.AddFieldLayout(layout);
+  } else {
+    photonlib::SimTargetLayoutFile layout(layoutPath);
+    if (!layout.IsOpen()) return 1;
+    system.AddTargetLayout(layout);
+  }
+
+  photonlib::SimTrajectoryRunner runner(system);
+  const auto& stats = runner.Run(trajectory);
+  if (!runner.WriteResults(resultsPath)) return 1;
+  if (!tracePath.empty() &&
+      !photonlib::PhotonTrace::WriteChromeJson(tracePath)) {
+    return 1;
+  }
+
+  std::printf("frames:              %zu\n", stats.frames);
+  std::printf("elapsed:             %.3f ms\n",
+              stats.elapsed.to<double>() * 1000.0);
+  std::printf("frames/s:            %.0f\n", stats.FramesPerSecond());
+  std::printf("frames with targets: %zu (%.1f%%)\n", stats.framesWithTargets,
+              stats.VisibleFraction() * 100.0);
+  std::printf("target sightings:    %zu (max %zu per frame)\n",
+              stats.targetSightings, stats.maxTargetsInFrame);
+  std::printf("longest blind:       %.3f s\n",
+              stats.longestBlindStretch.to<double>());
+  return 0;
+}
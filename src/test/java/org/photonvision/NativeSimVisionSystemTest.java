@@ -0,0 +1,132 @@
+/**
+ * Copyright (C) 2020-2021 Photon Vision.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+package org.photonvision;
+
+import static org.junit.jupiter.api.Assertions.assertEquals;
+import static org.junit.jupiter.api.Assertions.assertFalse;
+import static org.junit.jupiter.api.Assertions.assertThrows;
+import static org.junit.jupiter.api.Assertions.assertTrue;
+
+import java.util.List;
+
+import org.junit.jupiter.api.Test;
+
+import edu.wpi.first.wpilibj.geometry.Pose2d;
+import edu.wpi.first.wpilibj.geometry.Rotation2d;
+import edu.wpi.first.wpilibj.geometry.Transform2d;
+import edu.wpi.first.wpilibj.geometry.Translation2d;
+
+class NativeSimVisionSystemTest {
+    @Test
+    public void testNativeLibraryLoaded() {
+        assertTrue(NativeSimVisionSystem.isAvailable());
+    }
+
+    @Test
+    public void testBatchMatchesJava() {
+        final var targetPose = new Pose2d(new Translation2d(35,0), new Rotation2d());
+        var javaSys = new SimVisionSystem("JavaBatch", 80.0, 0.0, new Transform2d(), 1, 99999, 640, 480, 0);
+        javaSys.addSimVisionTarget(new SimVisionTarget(targetPose, 1.0, 3.0, 3.0));
+
+        try (var nativeSys = new NativeSimVisionSystem("NativeBatch", 80.0, 0.0, new Transform2d(), 1, 99999, 640, 480, 0)) {
+            nativeSys.addSimVisionTargets(List.of(new SimVisionTarget(targetPose, 1.0, 3.0, 3.0)));
+
+            var poses = List.of(
+                new Pose2d(new Translation2d(5,0), new Rotation2d()),
+                new Pose2d(new Translation2d(5,0), Rotation2d.fromDegrees(180)),
+                new Pose2d(new Translation2d(20,2), Rotation2d.fromDegrees(10)));
+            var results = nativeSys.processFrames(poses);
+            assertEquals(poses.size(), results.size());
+
+            for (int i = 0; i < poses.size(); i++) {
+                javaSys.processFrame(poses.get(i));
+                var expected = javaSys.cam.getLatestResult();
+                var actual = results.get(i);
+                assertEquals(expected.hasTargets(), actual.hasTargets());
+                if (expected.hasTargets()) {
+                    assertEquals(expected.getBestTarget().getYaw(), actual.getBestTarget().getYaw(), 1e-6);
+                    assertEquals(expected.getBestTarget().getPitch(), actual.getBestTarget().getPitch(), 1e-6);
+                }
+            }
+            assertTrue(results.get(0).hasTargets());
+            assertFalse(results.get(1).hasTargets());
+        }
+    }
+
+    @Test
+    public void testPackedArrays() {
+        try (var sys = new NativeSimVisionSystem("NativePacked", 80.0, 0.0, new Transform2d(), 1, 99999, 640, 480, 0)) {
+            for (int i = 0; i < 3; i++) {
+                sys.addSimVisionTarget(new SimVisionTarget(new Pose2d(new Translation2d(10, i - 1), new Rotation2d()), 1.0, 0.5, 0.5));
+            }
+
+            double[] poses = {0, 0, 0, 0, 0, 180};
+            int capacity = 2;
+            double[] results = new double[2 * NativeSimVisionSystem.resultStride(capacity)];
+            int[] counts = new int[2];
+            assertTrue(sys.processFrames(poses, 2, results, counts, capacity));
+            assertEquals(3, counts[0]);
+            assertEquals(0, counts[1]);
+
+            assertFalse(sys.processFrames(poses, 2, new double[1], counts, capacity));
+        }
+    }
+
+    @Test
+    public void testMoreTargetsThanInitialCapacity() {
+        try (var sys = new NativeSimVisionSystem("NativeMany", 80.0, 0.0, new Transform2d(), 1, 99999, 640, 480, 0)) {
+            for (int i = 0; i < 10; i++) {
+                sys.addSimVisionTarget(new SimVisionTarget(new Pose2d(new Translation2d(10, i * 0.5 - 2.5), new Rotation2d()), 1.0, 0.25, 0.25));
+            }
+
+            var results = sys.processFrames(List.of(new Pose2d(), new Pose2d(0, 0, Rotation2d.fromDegrees(180))));
+            assertEquals(10, results.get(0).getTargets().size());
+            assertEquals(0, results.get(1).getTargets().size());
+        }
+    }
+
+    @Test
+    public void testInvalidTargetThrows() {
+        try (var sys = new NativeSimVisionSystem("NativeInvalid", 80.0, 0.0, new Transform2d(), 1, 99999, 640, 480, 0)) {
+            var valid = new SimVisionTarget(new Pose2d(new Translation2d(10, 0), new Rotation2d()), 1.0, 0.5, 0.5);
+            var flat = new SimVisionTarget(new Pose2d(new Translation2d(10, 1), new Rotation2d()), 1.0, 0.0, 0.5);
+            var lost = new SimVisionTarget(new Pose2d(new Translation2d(Double.NaN, 0), new Rotation2d()), 1.0, 0.5, 0.5);
+            assertThrows(IllegalArgumentException.class, () -> sys.addSimVisionTarget(flat));
+            assertThrows(IllegalArgumentException.class, () -> sys.addSimVisionTargets(List.of(valid, lost)));
+
+            // The valid target was still added.
+            var result = sys.processFrames(List.of(new Pose2d())).get(0);
+            assertEquals(1, result.getTargets().size());
+        }
+    }
+
+    @Test
+    public void testClosedThrows() {
+        var sys = new NativeSimVisionSystem("NativeClosed", 80.0, 0.0, new Transform2d(), 1, 99999, 640, 480, 0);
+        sys.close();
+        sys.close();
+        var tgt = new SimVisionTarget(new Pose2d(), 1.0, 0.5, 0.5);
+        assertThrows(IllegalStateException.class, () -> sys.addSimVisionTarget(tgt));
+        assertThrows(IllegalStateException.class, () -> sys.moveCamera(new Transform2d(), 1, 0));
+        assertThrows(IllegalStateException.class, () -> sys.processFrames(List.of(new Pose2d())));
+
+        // The native side ignores a closed handle rather than crashing.
+        assertFalse(PhotonJNI.simAddTargets(0, new double[6], 1));
+        assertFalse(PhotonJNI.simProcessFrames(0, new double[3], 1, new double[NativeSimVisionSystem.resultStride(1)], new int[1], 1));
+    }
+}
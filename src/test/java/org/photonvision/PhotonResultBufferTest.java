@@ -0,0 +1,120 @@
+/**
+ * Copyright (C) 2020-2021 Photon Vision.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+package org.photonvision;
+
+import edu.wpi.first.wpilibj.geometry.Rotation2d;
+import edu.wpi.first.wpilibj.geometry.Transform2d;
+import edu.wpi.first.wpilibj.geometry.Translation2d;
+import org.junit.jupiter.api.Assertions;
+import org.junit.jupiter.api.Test;
+
+import java.nio.ByteBuffer;
+import java.nio.ByteOrder;
+import java.util.ArrayList;
+import java.util.List;
+
+class PhotonResultBufferTest {
+  private static byte[] encode(PhotonPipelineResult result) {
+    var p = new Packet(result.getPacketSize());
+    result.populatePacket(p);
+    return p.getData();
+  }
+
+  private static PhotonPipelineResult makeResult(int count) {
+    List<PhotonTrackedTarget> targets = new ArrayList<>();
+    for (int i = 0; i < count; i++) {
+      targets.add(new PhotonTrackedTarget(i + 0.5, -i, 2.0 * i, 0.25 * i,
+          new Transform2d(new Translation2d(i, -2.0 * i),
+              Rotation2d.fromDegrees(10.0 * i))));
+    }
+    return new PhotonPipelineResult(12.5, targets);
+  }
+
+  @Test
+  void testMatchesPacketDecode() {
+    var result = makeResult(3);
+    var buffer = new PhotonResultBuffer();
+    Assertions.assertTrue(buffer.decode(encode(result)));
+
+    Assertions.assertEquals(12.5, buffer.getLatencyMillis());
+    Assertions.assertTrue(buffer.hasTargets());
+    Assertions.assertEquals(3, buffer.getTargetCount());
+    for (int i = 0; i < 3; i++) {
+      var target = result.getTargets().get(i);
+      Assertions.assertEquals(target.getYaw(), buffer.getYaw(i));
+      Assertions.assertEquals(target.getPitch(), buffer.getPitch(i));
+      Assertions.assertEquals(target.getArea(), buffer.getArea(i));
+      Assertions.assertEquals(target.getSkew(), buffer.getSkew(i));
+      Assertions.assertEquals(target, buffer.getTarget(i));
+    }
+  }
+
+  @Test
+  void testNativeDecoderMatchesPacketDecode() {
+    Assertions.assertTrue(PhotonJNI.isLoaded());
+
+    var result = makeResult(3);
+    var packet = encode(result);
+    var input = ByteBuffer.allocateDirect(packet.length);
+    input.put(packet);
+    int capacity = 4;
+    var output = new double[1 + PhotonResultBuffer.COLUMNS * capacity];
+    Assertions.assertEquals(3,
+        PhotonJNI.decodeResult(input, packet.length, output, capacity));
+
+    Assertions.assertEquals(12.5, output[0]);
+    for (int i = 0; i < 3; i++) {
+      var target = result.getTargets().get(i);
+      Assertions.assertEquals(target.getYaw(),
+          output[1 + PhotonResultBuffer.YAW * capacity + i]);
+      Assertions.assertEquals(target.getPitch(),
+          output[1 + PhotonResultBuffer.PITCH * capacity + i]);
+      Assertions.assertEquals(target.getArea(),
+          output[1 + PhotonResultBuffer.AREA * capacity + i]);
+      Assertions.assertEquals(target.getSkew(),
+          output[1 + PhotonResultBuffer.SKEW * capacity + i]);
+    }
+    Assertions.assertEquals(-1,
+        PhotonJNI.decodeResult(input, packet.length - 1, output, capacity));
+
+    var direct = ByteBuffer.allocateDirect(output.length * Double.BYTES)
+        .order(ByteOrder.nativeOrder());
+    Assertions.assertEquals(3,
+        PhotonJNI.decodeResultDirect(input, packet.length, direct, capacity));
+    for (int i = 0; i < output.length; i++) {
+      Assertions.assertEquals(output[i], direct.getDouble(i * Double.BYTES));
+    }
+  }
+
+  @Test
+  void testGrowsAndRejectsMalformed() {
+    var buffer = new PhotonResultBuffer(2);
+    Assertions.assertTrue(buffer.decode(encode(makeResult(5))));
+    Assertions.assertEquals(5, buffer.getTargetCount());
+    Assertions.assertTrue(buffer.getCapacity() >= 5);
+    Assertions.assertEquals(4.5, buffer.getYaw(4));
+
+    Assertions.assertTrue(buffer.decode(encode(makeResult(0))));
+    Assertions.assertFalse(buffer.hasTargets());
+
+    var truncated = encode(makeResult(2));
+    Assertions.assertFalse(buffer.decode(truncated, truncated.length - 1));
+    Assertions.assertEquals(0, buffer.getTargetCount());
+    Assertions.assertFalse(buffer.decode(new byte[0]));
+  }
+}
@@ -0,0 +1,109 @@
+/**
+ * Copyright (C) 2020-2021 Photon Vision.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <vector>
+
+#include <units/angle.h>
+#include <units/length.h>
+
+#include "gtest/gtest.h"
+#include "photonlib/FieldLayout.h"
+#include "photonlib/SimVisionSystem.h"
+
+TEST(FieldLayoutTest, FromJson) {
+  auto layout = photonlib::FieldLayout::FromJson(R"({
+    "targets": [
+      {"x": 1.0, "y": 2.0, "rotation": 90.0,
+       "heightAboveGround": 2.5, "width": 1.0, "height": 0.5},
+      {"x": 15.0, "y": 6.0, "rotation": 0.0,
+       "heightAboveGround": 1.0, "width": 0.25, "height": 0.1}
+    ]
+  })");
+  ASSERT_EQ(2ul, layout.Size());
+  EXPECT_EQ(frc::Pose2d(1_m, 2_m, frc::Rotation2d(90_deg)),
+            layout.GetTargets()[0].pose);
+  EXPECT_DOUBLE_EQ(0.1, layout.GetTargets()[1].height.to<double>());
+}
+
+TEST(FieldLayoutTest, MalformedJson) {
+  EXPECT_EQ(0ul, photonlib::FieldLayout::FromJson("{\"targets\": 3").Size());
+  EXPECT_EQ(0ul, photonlib::FieldLayout::FromJson("{}").Size());
+}
+
+TEST(FieldLayoutTest, FindNearestMatchesBruteForce) {
+  std::vector<photonlib::FieldTarget> targets;
+  for (int i = 0; i < 200; ++i) {
+    // Scatter targets deterministically over a 16 x 8 m field.
+    double x = (i * 37 % 160) / 10.0;
+    double y = (i * 53 % 80) / 10.0;
+    targets.push_back({frc::Pose2d(units::meter_t(x), units::meter_t(y),
+                                   frc::Rotation2d()),
+                       1.0_m, 0.5_m, 0.5_m});
+  }
+  photonlib::FieldLayout layout(targets);
+
+  for (int q = 0; q < 100; ++q) {
+    frc::Translation2d point(units::meter_t(q * 0.163),
+                             units::meter_t(q * 0.071));
+    int expected = -1;
+    units::meter_t bestDist = 1.0_m;
+    for (size_t i = 0; i < targets.size(); ++i) {
+      auto dist = targets[i].pose.Translation().Distance(point);
+      if (dist < bestDist) {
+        bestDist = dist;
+        expected = static_cast<int>(i);
+      }
+    }
+    int found = layout.FindNearest(point, 1.0_m);
+    if (expected < 0) {
+      EXPECT_EQ(-1, found);
+    } else {
+      ASSERT_GE(found, 0);
+      EXPECT_DOUBLE_EQ(bestDist.to<double>(),
+                       targets[found]
+                           .pose.Translation()
+                           .Distance(point)
+                           .to<double>());
+    }
+  }
+}
+
+TEST(FieldLayoutTest, AssociateSimulatedTarget) {
+  std::vector<photonlib::FieldTarget> targets{
+      {frc::Pose2d(35_m, 2_m, frc::Rotation2d()), 1.0_m, 0.5_m, 0.5_m},
+      {frc::Pose2d(35_m, 0_m, frc::Rotation2d()), 1.0_m, 0.5_m, 0.5_m},
+      {frc::Pose2d(35_m, -2_m, frc::Rotation2d()), 1.0_m, 0.5_m, 0.5_m}};
+  photonlib::FieldLayout layout(targets);
+
+  photonlib::SimVisionSystem sys("LayoutTest", 80.0_deg, 0.0_deg,
+                                 frc::Transform2d(), 1.0_m, 99999.0_m, 640,
+                                 480, 0.0);
+  sys.AddFieldLayout(layout);
+
+  auto robotPose = frc::Pose2d(28_m, 0.5_m, frc::Rotation2d(5_deg));
+  sys.ProcessFrame(robotPose);
+  auto result = sys.cam.GetLatestResult();
+  ASSERT_EQ(3ul, result.GetTargets().size());
+
+  // Odometry that has drifted a little should still pick the right targets.
+  auto odometryPose = frc::Pose2d(28.2_m, 0.4_m, frc::Rotation2d(6_deg));
+  for (size_t i = 0; i < result.GetTargets().size(); ++i) {
+    EXPECT_EQ(static_cast<int>(i),
+              layout.Associate(odometryPose, frc::Transform2d(),
+                               result.GetTargets()[i], 0.75_m));
+  }
+}
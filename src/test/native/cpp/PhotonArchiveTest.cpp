@@ -0,0 +1,209 @@
+/**
+ * Copyright (C) 2020-2021 Photon Vision.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <units/angle.h>
+#include <units/length.h>
+#include <units/time.h>
+
+#include "gtest/gtest.h"
+#include "photonlib/Packet.h"
+#include "photonlib/PhotonArchive.h"
+#include "photonlib/SimVisionSystem.h"
+
+namespace {
+using photonlib::PhotonArchive;
+
+// Simulates a camera while the robot drives an arc past a few targets at
+// 50 Hz, as a practice session log would record.
+void MakeStream(size_t frames, std::vector<units::second_t>& times,
+                std::vector<photonlib::PhotonPipelineResult>& results) {
+  photonlib::SimVisionSystem sys("PhotonArchiveTest", 80_deg, 0_deg,
+                                 frc::Transform2d(), 1_m, 20_m, 640, 480,
+                                 0.0);
+  for (int i = 0; i < 3; ++i) {
+    frc::Pose2d pose(10_m, units::meter_t(i * 2.0 - 2.0), frc::Rotation2d());
+    sys.AddSimVisionTarget(photonlib::SimVisionTarget(pose, 2_m, 1_m, 0.5_m));
+  }
+
+  std::vector<frc::Pose2d> poses;
+  for (size_t i = 0; i < frames; ++i) {
+    double t = i * 0.02;
+    poses.emplace_back(units::meter_t(t * 0.2), units::meter_t(std::sin(t)),
+                       units::degree_t(20 * std::sin(t * 0.3)));
+    times.push_back(units::second_t(100.0 + t));
+  }
+  results.resize(frames);
+  sys.ProcessFrames(poses, results);
+  for (size_t i = 0; i < frames; ++i) {
+    // Latencies as reported, in whole milliseconds plus a little jitter.
+    auto targets = results[i].GetTargets();
+    results[i] = photonlib::PhotonPipelineResult(
+        units::second_t((20 + i % 3) / 1000.0 + (i % 7) * 1e-6),
+        std::vector<photonlib::PhotonTrackedTarget>(targets.begin(),
+                                                    targets.end()));
+  }
+}
+}  // namespace
+
+TEST(PhotonArchiveTest, RoundTrip) {
+  std::vector<units::second_t> times;
+  std::vector<photonlib::PhotonPipelineResult> results;
+  MakeStream(1000, times, results);
+
+  const std::string path = "PhotonArchiveTest-roundtrip.pvar";
+  {
+    photonlib::PhotonArchiveWriter writer(path, 256);
+    ASSERT_TRUE(writer.IsOpen());
+    for (size_t i = 0; i < results.size(); ++i) {
+      ASSERT_TRUE(writer.Append(times[i], results[i]));
+    }
+    ASSERT_TRUE(writer.Close());
+  }
+
+  photonlib::PhotonArchiveReader reader(path);
+  ASSERT_TRUE(reader.IsOpen());
+  EXPECT_EQ(4u, reader.GetBlockCount());
+  EXPECT_EQ(results.size(), reader.GetFrameCount());
+
+  std::vector<units::second_t> readTimes;
+  std::vector<photonlib::PhotonPipelineResult> readResults;
+  ASSERT_TRUE(reader.ReadAll(readTimes, readResults));
+  ASSERT_EQ(results.size(), readResults.size());
+  for (size_t i = 0; i < results.size(); ++i) {
+    EXPECT_NEAR(times[i].to<double>(), readTimes[i].to<double>(), 1e-9);
+    EXPECT_NEAR(results[i].GetLatency().to<double>(),
+                readResults[i].GetLatency().to<double>(), 1e-9);
+    // Target fields are stored exactly.
+    auto expected = results[i].GetTargets();
+    auto actual = readResults[i].GetTargets();
+    ASSERT_EQ(expected.size(), actual.size());
+    for (size_t j = 0; j < expected.size(); ++j) {
+      EXPECT_EQ(expected[j].GetYaw(), actual[j].GetYaw());
+      EXPECT_EQ(expected[j].GetPitch(), actual[j].GetPitch());
+      EXPECT_EQ(expected[j].GetArea(), actual[j].GetArea());
+      EXPECT_EQ(expected[j].GetSkew(), actual[j].GetSkew());
+      EXPECT_EQ(expected[j].GetCameraRelativePose(),
+                actual[j].GetCameraRelativePose());
+    }
+  }
+  std::remove(path.c_str());
+}
+
+TEST(PhotonArchiveTest, ReadsOnlyRequestedColumns) {
+  std::vector<units::second_t> times;
+  std::vector<photonlib::PhotonPipelineResult> results;
+  MakeStream(300, times, results);
+
+  const std::string path = "PhotonArchiveTest-columns.pvar";
+  {
+    photonlib::PhotonArchiveWriter writer(path);
+    for (size_t i = 0; i < results.size(); ++i) {
+      writer.Append(times[i], results[i]);
+    }
+  }
+
+  photonlib::PhotonArchiveReader reader(path);
+  ASSERT_EQ(1u, reader.GetBlockCount());
+  photonlib::PhotonArchiveBlock block;
+  ASSERT_TRUE(reader.ReadBlock(0, PhotonArchive::Mask(PhotonArchive::kYaw),
+                               block));
+  EXPECT_EQ(results.size(), block.Size());
+  EXPECT_TRUE(block.times.empty());
+  EXPECT_TRUE(block.latencyMillis.empty());
+  EXPECT_TRUE(block.targets[photonlib::PhotonResultColumns::kPitch].empty());
+
+  // The target counts come along to map targets to frames.
+  ASSERT_EQ(results.size(), block.targetCounts.size());
+  const auto& yaws = block.targets[photonlib::PhotonResultColumns::kYaw];
+  for (size_t i = 0; i < results.size(); ++i) {
+    auto targets = results[i].GetTargets();
+    ASSERT_EQ(targets.size(), block.targetCounts[i]);
+    for (size_t j = 0; j < targets.size(); ++j) {
+      EXPECT_EQ(targets[j].GetYaw(), yaws[block.firstTargets[i] + j]);
+    }
+  }
+  EXPECT_FALSE(reader.ReadBlock(1, PhotonArchive::kAllColumns, block));
+  std::remove(path.c_str());
+}
+
+TEST(PhotonArchiveTest, SmallerThanRawPackets) {
+  std::vector<units::second_t> times;
+  std::vector<photonlib::PhotonPipelineResult> results;
+  MakeStream(3000, times, results);
+
+  const std::string path = "PhotonArchiveTest-size.pvar";
+  size_t rawSize = 0;
+  {
+    photonlib::PhotonArchiveWriter writer(path);
+    for (size_t i = 0; i < results.size(); ++i) {
+      photonlib::Packet packet;
+      packet << results[i];
+      // A raw log stores the timestamp next to each packet.
+      rawSize += sizeof(double) + packet.GetDataSize();
+      writer.Append(times[i], results[i]);
+    }
+  }
+
+  std::ifstream file(path, std::ios::binary | std::ios::ate);
+  size_t archiveSize = file.tellg();
+  EXPECT_LT(archiveSize, rawSize);
+  std::remove(path.c_str());
+}
+
+TEST(PhotonArchiveTest, RejectsMalformedFile) {
+  std::vector<units::second_t> times;
+  std::vector<photonlib::PhotonPipelineResult> results;
+  MakeStream(100, times, results);
+
+  const std::string path = "PhotonArchiveTest-malformed.pvar";
+  {
+    photonlib::PhotonArchiveWriter writer(path);
+    for (size_t i = 0; i < results.size(); ++i) {
+      writer.Append(times[i], results[i]);
+    }
+  }
+  std::vector<char> contents;
+  {
+    std::ifstream file(path, std::ios::binary);
+    contents.assign(std::istreambuf_iterator<char>(file),
+                    std::istreambuf_iterator<char>());
+  }
+
+  // A truncated file fails when opened.
+  {
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file.write(contents.data(), contents.size() - 1);
+  }
+  EXPECT_FALSE(photonlib::PhotonArchiveReader(path).IsOpen());
+
+  // A corrupted frame count fails when its block is read.
+  contents[8] ^= 0x40;
+  {
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file.write(contents.data(), contents.size());
+  }
+  photonlib::PhotonArchiveReader reader(path);
+  ASSERT_TRUE(reader.IsOpen());
+  photonlib::PhotonArchiveBlock block;
+  EXPECT_FALSE(reader.ReadBlock(0, PhotonArchive::kAllColumns, block));
+  std::remove(path.c_str());
+}
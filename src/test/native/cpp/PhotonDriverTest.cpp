@@ -0,0 +1,173 @@
+/**
+ * Copyright (C) 2020-2021 Photon Vision.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <networktables/NetworkTableInstance.h>
+#include <units/angle.h>
+#include <units/length.h>
+
+#include "driverheader.h"
+#include "gtest/gtest.h"
+#include "photonlib/Packet.h"
+#include "photonlib/PhotonPipelineResult.h"
+#include "photonlib/PhotonResultChannel.h"
+#include "photonlib/SimPhotonCamera.h"
+
+namespace {
+std::string Encode(const photonlib::PhotonPipelineResult& result) {
+  photonlib::Packet packet;
+  packet << result;
+  auto& data = packet.GetData();
+  return std::string(data.begin(), data.end());
+}
+
+photonlib::PhotonPipelineResult MakeResult(int targets) {
+  std::vector<photonlib::PhotonTrackedTarget> list;
+  for (int i = 0; i < targets; ++i) {
+    list.emplace_back(
+        i * 1.5, -i * 0.5, i + 0.25, i * -2.0,
+        frc::Transform2d(frc::Translation2d(units::meter_t(i * 3.0),
+                                            units::meter_t(-i * 1.0)),
+                         units::degree_t(i * 10.0)));
+  }
+  return photonlib::PhotonPipelineResult(12_ms, list);
+}
+
+int Decode(const std::string& data, photon_result_t* result) {
+  return photon_decode(reinterpret_cast<const uint8_t*>(data.data()),
+                       data.size(), result);
+}
+}  // namespace
+
+TEST(PhotonDriverTest, DecodeRejectsNullPointers) {
+  auto data = Encode(MakeResult(2));
+  photon_target_t targets[2];
+  photon_result_t result{0.0, 0, 2, targets};
+  EXPECT_EQ(PHOTON_ERROR_ARGUMENT,
+            photon_decode(nullptr, data.size(), &result));
+  EXPECT_EQ(PHOTON_ERROR_ARGUMENT,
+            photon_decode(reinterpret_cast<const uint8_t*>(data.data()),
+                          data.size(), nullptr));
+  result.targets = nullptr;
+  EXPECT_EQ(PHOTON_ERROR_ARGUMENT, Decode(data, &result));
+
+  // With no room for targets, they are only counted.
+  result.capacity = 0;
+  EXPECT_EQ(0, Decode(data, &result));
+  EXPECT_EQ(2, result.target_count);
+}
+
+TEST(PhotonDriverTest, DecodeRejectsTruncatedPackets) {
+  auto data = Encode(MakeResult(3));
+  photon_target_t targets[3];
+  photon_result_t result{0.0, 0, 3, targets};
+  data.pop_back();
+  EXPECT_EQ(PHOTON_ERROR_MALFORMED, Decode(data, &result));
+  EXPECT_EQ(PHOTON_ERROR_MALFORMED, Decode(std::string(), &result));
+}
+
+TEST(PhotonDriverTest, DecodeWritesOnlyCapacityTargets) {
+  auto source = MakeResult(5);
+  auto data = Encode(source);
+
+  // One target more than the capacity, to check nothing is written past it.
+  photon_target_t targets[3];
+  targets[2].yaw = -100.0;
+  photon_result_t result{0.0, 0, 2, targets};
+  ASSERT_EQ(0, Decode(data, &result));
+  EXPECT_DOUBLE_EQ(12.0, result.latency_ms);
+  EXPECT_EQ(5, result.target_count);
+  EXPECT_EQ(-100.0, targets[2].yaw);
+
+  auto sourceTargets = source.GetTargets();
+  for (int i = 0; i < 2; ++i) {
+    auto pose = sourceTargets[i].GetCameraRelativePose();
+    EXPECT_EQ(sourceTargets[i].GetYaw(), targets[i].yaw);
+    EXPECT_EQ(sourceTargets[i].GetArea(), targets[i].area);
+    EXPECT_EQ(pose.Translation().X().to<double>(), targets[i].x);
+  }
+}
+
+TEST(PhotonDriverTest, PollReportsOnlyNewResults) {
+  EXPECT_EQ(nullptr, photon_camera_open(nullptr));
+  photon_camera_t* camera = photon_camera_open("driverTest");
+  ASSERT_NE(nullptr, camera);
+
+  photon_target_t targets[4];
+  photon_result_t result{0.0, 0, 4, targets};
+  EXPECT_EQ(PHOTON_ERROR_ARGUMENT, photon_camera_poll(nullptr, &result));
+  EXPECT_EQ(PHOTON_ERROR_ARGUMENT, photon_camera_poll(camera, nullptr));
+  EXPECT_EQ(0, photon_camera_poll(camera, &result));
+
+  // Published over NetworkTables. Publishing the same bytes again is still
+  // a new result.
+  auto table = nt::NetworkTableInstance::GetDefault()
+                   .GetTable("photonvision")
+                   ->GetSubTable("driverTest");
+  auto rawBytes = table->GetEntry("rawBytes");
+  rawBytes.SetRaw(Encode(MakeResult(3)));
+  EXPECT_EQ(1, photon_camera_poll(camera, &result));
+  EXPECT_EQ(3, result.target_count);
+  EXPECT_EQ(0, photon_camera_poll(camera, &result));
+  rawBytes.SetRaw(Encode(MakeResult(3)));
+  EXPECT_EQ(1, photon_camera_poll(camera, &result));
+  EXPECT_EQ(0, photon_camera_poll(camera, &result));
+
+  // Published in process by a simulated camera.
+  auto channel = photonlib::PhotonResultChannel::Get(table->GetPath());
+  auto publisher = std::make_shared<int>();
+  channel->Publish(MakeResult(1), publisher);
+  EXPECT_EQ(1, photon_camera_poll(camera, &result));
+  EXPECT_EQ(1, result.target_count);
+  EXPECT_EQ(0, photon_camera_poll(camera, &result));
+  channel->Publish(MakeResult(2), publisher);
+  EXPECT_EQ(1, photon_camera_poll(camera, &result));
+  EXPECT_EQ(2, result.target_count);
+  EXPECT_EQ(0, photon_camera_poll(camera, &result));
+
+  channel->Clear();
+  photon_camera_close(camera);
+  photon_camera_close(nullptr);
+}
+
+TEST(PhotonDriverTest, PollUsesNetworkTablesAfterSimCameraDestroyed) {
+  photon_camera_t* camera = photon_camera_open("driverDestroyTest");
+  ASSERT_NE(nullptr, camera);
+  photon_target_t targets[4];
+  photon_result_t result{0.0, 0, 4, targets};
+
+  {
+    photonlib::SimPhotonCamera sim("driverDestroyTest");
+    sim.SetDeliveryMode(photonlib::SimPhotonCamera::kInProcess);
+    auto published = MakeResult(1);
+    sim.SubmitProcessedFrame(published.GetLatency(), published.GetTargets());
+    EXPECT_EQ(1, photon_camera_poll(camera, &result));
+    EXPECT_EQ(1, result.target_count);
+  }
+
+  nt::NetworkTableInstance::GetDefault()
+      .GetTable("photonvision")
+      ->GetSubTable("driverDestroyTest")
+      ->GetEntry("rawBytes")
+      .SetRaw(Encode(MakeResult(3)));
+  EXPECT_EQ(1, photon_camera_poll(camera, &result));
+  EXPECT_EQ(3, result.target_count);
+  photon_camera_close(camera);
+}
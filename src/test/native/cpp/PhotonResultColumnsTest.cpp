@@ -0,0 +1,126 @@
+/**
+ * Copyright (C) 2020-2021 Photon Vision.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <vector>
+
+#include <units/angle.h>
+#include <units/length.h>
+
+#include "gtest/gtest.h"
+#include "photonlib/Packet.h"
+#include "photonlib/PhotonPipelineResult.h"
+#include "photonlib/PhotonResultColumns.h"
+
+namespace {
+using Columns = photonlib::PhotonResultColumns;
+
+std::vector<uint8_t> Encode(const photonlib::PhotonPipelineResult& result) {
+  photonlib::Packet packet;
+  packet << result;
+  auto& data = packet.GetData();
+  return std::vector<uint8_t>(data.begin(), data.end());
+}
+
+photonlib::PhotonPipelineResult MakeResult(int targets) {
+  std::vector<photonlib::PhotonTrackedTarget> list;
+  for (int i = 0; i < targets; ++i) {
+    list.emplace_back(
+        i * 1.5, -i * 0.5, i + 0.25, i * -2.0,
+        frc::Transform2d(frc::Translation2d(units::meter_t(i * 3.0),
+                                            units::meter_t(-i * 1.0)),
+                         units::degree_t(i * 10.0)));
+  }
+  return photonlib::PhotonPipelineResult(12_ms, list);
+}
+}  // namespace
+
+TEST(PhotonResultColumnsTest, MatchesPacketDecode) {
+  auto result = MakeResult(5);
+  auto data = Encode(result);
+
+  constexpr size_t kCapacity = 8;
+  std::vector<double> out(Columns::Size(kCapacity));
+  ASSERT_EQ(5, Columns::Decode(data, out.data(), kCapacity));
+  EXPECT_DOUBLE_EQ(12.0, out[0]);
+
+  auto targets = result.GetTargets();
+  for (size_t i = 0; i < targets.size(); ++i) {
+    auto& target = targets[i];
+    auto pose = target.GetCameraRelativePose();
+    EXPECT_EQ(target.GetYaw(), out[Columns::Index(Columns::kYaw, i, 8)]);
+    EXPECT_EQ(target.GetPitch(), out[Columns::Index(Columns::kPitch, i, 8)]);
+    EXPECT_EQ(target.GetArea(), out[Columns::Index(Columns::kArea, i, 8)]);
+    EXPECT_EQ(target.GetSkew(), out[Columns::Index(Columns::kSkew, i, 8)]);
+    EXPECT_EQ(pose.Translation().X().to<double>(),
+              out[Columns::Index(Columns::kX, i, 8)]);
+    EXPECT_EQ(pose.Translation().Y().to<double>(),
+              out[Columns::Index(Columns::kY, i, 8)]);
+    EXPECT_EQ(pose.Rotation().Degrees().to<double>(),
+              out[Columns::Index(Columns::kRotation, i, 8)]);
+  }
+}
+
+TEST(PhotonResultColumnsTest, CapacityAndMalformedInput) {
+  auto data = Encode(MakeResult(4));
+
+  // Only the targets that fit are written, but all are counted.
+  std::vector<double> out(Columns::Size(2), -1.0);
+  ASSERT_EQ(4, Columns::Decode(data, out.data(), 2));
+  EXPECT_EQ(1.5, out[Columns::Index(Columns::kYaw, 1, 2)]);
+  EXPECT_DOUBLE_EQ(1.25, out[Columns::Index(Columns::kArea, 1, 2)]);
+
+  auto empty = Encode(photonlib::PhotonPipelineResult());
+  EXPECT_EQ(0, Columns::Decode(empty, out.data(), 2));
+
+  data.pop_back();
+  EXPECT_EQ(-1, Columns::Decode(data, out.data(), 2));
+  EXPECT_EQ(-1, Columns::Decode(wpi::ArrayRef<uint8_t>(), out.data(), 2));
+}
+
+TEST(PhotonResultColumnsTest, WriteMatchesDecode) {
+  auto result = MakeResult(6);
+  auto data = Encode(result);
+
+  constexpr size_t kCapacity = 4;
+  std::vector<double> decoded(Columns::Size(kCapacity));
+  std::vector<double> written(Columns::Size(kCapacity));
+  ASSERT_EQ(6, Columns::Decode(data, decoded.data(), kCapacity));
+  ASSERT_EQ(6, Columns::Write(result, written.data(), kCapacity));
+  EXPECT_EQ(decoded, written);
+}
+
+TEST(PhotonResultColumnsTest, DecodeRowsMatchesDecode) {
+  auto data = Encode(MakeResult(5));
+
+  constexpr size_t kCapacity = 3;
+  std::vector<double> columns(Columns::Size(kCapacity));
+  std::vector<double> rows(Columns::kColumnCount * kCapacity);
+  double latency = 0;
+  ASSERT_EQ(5, Columns::Decode(data, columns.data(), kCapacity));
+  ASSERT_EQ(5, Columns::DecodeRows(data, &latency, rows.data(), kCapacity));
+  EXPECT_EQ(columns[0], latency);
+  for (size_t i = 0; i < kCapacity; ++i) {
+    for (int column = 0; column < Columns::kColumnCount; ++column) {
+      EXPECT_EQ(columns[Columns::Index(static_cast<Columns::Column>(column), i,
+                                       kCapacity)],
+                rows[i * Columns::kColumnCount + column]);
+    }
+  }
+
+  data.pop_back();
+  EXPECT_EQ(-1, Columns::DecodeRows(data, &latency, rows.data(), kCapacity));
+}
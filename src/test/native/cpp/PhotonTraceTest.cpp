@@ -0,0 +1,118 @@
+/**
+ * Copyright (C) 2020-2021 Photon Vision.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <thread>
+
+#include "gtest/gtest.h"
+#include "photonlib/PhotonTrace.h"
+#include "photonlib/SimVisionSystem.h"
+
+using photonlib::PhotonTrace;
+
+namespace {
+std::string ReadFile(const std::string& path) {
+  std::ifstream file(path);
+  return std::string{std::istreambuf_iterator<char>(file),
+                     std::istreambuf_iterator<char>()};
+}
+
+size_t CountOf(const std::string& text, const std::string& pattern) {
+  size_t count = 0;
+  for (size_t pos = text.find(pattern); pos != std::string::npos;
+       pos = text.find(pattern, pos + 1)) {
+    ++count;
+  }
+  return count;
+}
+}  // namespace
+
+TEST(PhotonTraceTest, WritesChromeJson) {
+  PhotonTrace::Clear();
+  {
+    photonlib::PhotonTraceScope outer("outer");
+    photonlib::PhotonTraceScope inner("inner \"quoted\"");
+  }
+  std::thread([] { photonlib::PhotonTraceScope span("other thread"); })
+      .join();
+  EXPECT_EQ(3u, PhotonTrace::GetSpanCount());
+
+  const std::string path = "PhotonTraceTest.json";
+  ASSERT_TRUE(PhotonTrace::WriteChromeJson(path));
+  auto json = ReadFile(path);
+  EXPECT_EQ(0u, json.find("{\"displayTimeUnit\":\"ms\",\"traceEvents\":["));
+  EXPECT_EQ(3u, CountOf(json, "\"ph\":\"X\""));
+  EXPECT_EQ(1u, CountOf(json, "\"name\":\"outer\""));
+  EXPECT_EQ(1u, CountOf(json, "\"name\":\"inner \\\"quoted\\\"\""));
+  EXPECT_EQ(1u, CountOf(json, "\"name\":\"other thread\""));
+  EXPECT_EQ("\n]}\n", json.substr(json.size() - 4));
+  std::remove(path.c_str());
+}
+
+TEST(PhotonTraceTest, DropsWhenFullOrDisabled) {
+  std::thread([] {
+    PhotonTrace::Clear();
+    for (size_t i = 0; i < PhotonTrace::kSpansPerThread + 5; ++i) {
+      photonlib::PhotonTraceScope span("span");
+    }
+    EXPECT_EQ(PhotonTrace::kSpansPerThread, PhotonTrace::GetSpanCount());
+    EXPECT_EQ(5u, PhotonTrace::GetDroppedCount());
+  }).join();
+
+  PhotonTrace::Clear();
+  PhotonTrace::SetEnabled(false);
+  { photonlib::PhotonTraceScope span("paused"); }
+  PhotonTrace::SetEnabled(true);
+  EXPECT_EQ(0u, PhotonTrace::GetSpanCount());
+}
+
+TEST(PhotonTraceTest, ReusesBuffersOfExitedThreads) {
+  PhotonTrace::Clear();
+  for (int i = 0; i < 4; ++i) {
+    std::thread([] { photonlib::PhotonTraceScope span("short-lived"); })
+        .join();
+  }
+  EXPECT_EQ(4u, PhotonTrace::GetSpanCount());
+
+  // Each thread took the buffer the one before it gave back.
+  const std::string path = "PhotonTraceTestReuse.json";
+  ASSERT_TRUE(PhotonTrace::WriteChromeJson(path));
+  auto json = ReadFile(path);
+  auto first = json.find("\"tid\":");
+  ASSERT_NE(std::string::npos, first);
+  auto tid = json.substr(first, json.find('}', first) - first);
+  EXPECT_EQ(4u, CountOf(json, tid + "}"));
+  std::remove(path.c_str());
+}
+
+TEST(PhotonTraceTest, InstrumentedOnlyWhenBuiltWithTracing) {
+  photonlib::SimVisionSystem sys("PhotonTraceTest", 80_deg, 0_deg,
+                                 frc::Transform2d(), 1_m, 20_m, 640, 480,
+                                 0.0);
+  PhotonTrace::Clear();
+  sys.ProcessFrame(frc::Pose2d());
+  sys.cam.GetLatestResult();
+#ifdef PHOTONLIB_TRACING
+  // ProcessFrame, SubmitProcessedFrame and GetLatestResult with its fetch
+  // and decode.
+  EXPECT_EQ(5u, PhotonTrace::GetSpanCount());
+#else
+  EXPECT_EQ(0u, PhotonTrace::GetSpanCount());
+#endif
+}
@@ -15,7 +15,52 @@
  * along with this program.  If not, see <https://www.gnu.org/licenses/>.
  */
 
+#include <units/angle.h>
+#include <units/length.h>
+#include <units/time.h>
+
 #include "gtest/gtest.h"
 #include "photonlib/PhotonUtils.h"
 
 TEST(PhotonUtilsTest, TestInclude) {}
+
+TEST(PhotonUtilsTest, EstimateFieldToRobotFromHistory) {
+  photonlib::PoseHistory history(10);
+  history.AddSample(0_s, frc::Pose2d(0_m, 0_m, frc::Rotation2d(0_deg)));
+  history.AddSample(1_s, frc::Pose2d(0_m, 0_m, frc::Rotation2d(20_deg)));
+
+  // The gyro at the 0.5 s capture time read 10 degrees, not the current 20.
+  auto fieldToTarget = frc::Pose2d(5_m, 0_m, frc::Rotation2d());
+  auto expected = photonlib::PhotonUtils::EstimateFieldToRobot(
+      1_m, 2_m, 0_deg, 10_deg, frc::Rotation2d(-10_deg),
+      frc::Rotation2d(10_deg), fieldToTarget, frc::Transform2d());
+  auto estimate = photonlib::PhotonUtils::EstimateFieldToRobot(
+      1_m, 2_m, 0_deg, 10_deg, frc::Rotation2d(-10_deg), history, 0.5_s,
+      fieldToTarget, frc::Transform2d());
+  ASSERT_TRUE(estimate.has_value());
+  EXPECT_EQ(expected, *estimate);
+
+  EXPECT_FALSE(photonlib::PhotonUtils::EstimateFieldToRobot(
+                   1_m, 2_m, 0_deg, 10_deg, frc::Rotation2d(-10_deg), history,
+                   -1_s, fieldToTarget, frc::Transform2d())
+                   .has_value());
+}
+
+TEST(PhotonUtilsTest, EstimateCameraToTargetFromHistory) {
+  photonlib::PoseHistory history(10);
+  history.AddSample(0_s, frc::Pose2d(0_m, 0_m, frc::Rotation2d(0_deg)));
+  history.AddSample(1_s, frc::Pose2d(0_m, 0_m, frc::Rotation2d(20_deg)));
+
+  auto translation = frc::Translation2d(4_m, 1_m);
+  auto fieldToTarget = frc::Pose2d(5_m, 0_m, frc::Rotation2d(180_deg));
+  auto estimate = photonlib::PhotonUtils::EstimateCameraToTarget(
+      translation, fieldToTarget, history, 0.5_s);
+  ASSERT_TRUE(estimate.has_value());
+  EXPECT_EQ(photonlib::PhotonUtils::EstimateCameraToTarget(
+                translation, fieldToTarget, frc::Rotation2d(10_deg)),
+            *estimate);
+
+  EXPECT_FALSE(photonlib::PhotonUtils::EstimateCameraToTarget(
+                   translation, fieldToTarget, history, -1_s)
+                   .has_value());
+}
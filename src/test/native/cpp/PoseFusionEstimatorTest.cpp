@@ -0,0 +1,88 @@
+/**
+ * Copyright (C) 2020-2021 Photon Vision.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <units/angle.h>
+#include <units/length.h>
+#include <units/time.h>
+
+#include "gtest/gtest.h"
+#include "photonlib/PoseFusionEstimator.h"
+
+namespace {
+// The robot drives an arc at 1 m/s and 0.5 rad/s.
+frc::Pose2d TruePose(units::second_t t) {
+  return frc::Pose2d().Exp(
+      frc::Twist2d{units::meter_t(t.to<double>()), 0_m,
+                   units::radian_t(0.5 * t.to<double>())});
+}
+
+// Odometry has drifted by a fixed offset in the field frame.
+frc::Pose2d OdometryPose(units::second_t t) {
+  frc::Pose2d drift(0.5_m, -0.3_m, frc::Rotation2d(0.1_rad));
+  return drift.TransformBy(frc::Transform2d(frc::Pose2d(), TruePose(t)));
+}
+}  // namespace
+
+TEST(PoseFusionEstimatorTest, RewindsToCaptureTime) {
+  photonlib::PoseFusionEstimator estimator(100, 1.0, 1.0);
+  for (int i = 0; i <= 50; ++i) {
+    units::second_t t = i * 0.02_s;
+    estimator.UpdateOdometry(OdometryPose(t), t);
+  }
+
+  // A perfect vision measurement from a frame captured 0.3 s ago, between
+  // two odometry samples.
+  units::second_t captureTime = 0.71_s;
+  ASSERT_TRUE(
+      estimator.AddVisionMeasurement(TruePose(captureTime), captureTime));
+
+  auto estimate = estimator.GetEstimatedPosition();
+  auto truth = TruePose(1.0_s);
+  EXPECT_NEAR(truth.X().to<double>(), estimate.X().to<double>(), 1e-3);
+  EXPECT_NEAR(truth.Y().to<double>(), estimate.Y().to<double>(), 1e-3);
+  EXPECT_NEAR(truth.Rotation().Radians().to<double>(),
+              estimate.Rotation().Radians().to<double>(), 1e-3);
+
+  // Further odometry continues from the corrected pose.
+  auto next = estimator.UpdateOdometry(OdometryPose(1.02_s), 1.02_s);
+  EXPECT_NEAR(TruePose(1.02_s).X().to<double>(), next.X().to<double>(), 1e-3);
+}
+
+TEST(PoseFusionEstimatorTest, PartialWeight) {
+  photonlib::PoseFusionEstimator estimator(10, 0.5, 0.0);
+  estimator.ResetPose(frc::Pose2d(), frc::Pose2d(), 0_s);
+  estimator.UpdateOdometry(frc::Pose2d(1_m, 0_m, frc::Rotation2d()), 1_s);
+
+  ASSERT_TRUE(estimator.AddVisionMeasurement(
+      frc::Pose2d(0_m, 2_m, frc::Rotation2d(1_rad)), 0_s));
+  auto estimate = estimator.GetEstimatedPosition();
+  EXPECT_NEAR(1.0, estimate.X().to<double>(), 1e-9);
+  EXPECT_NEAR(1.0, estimate.Y().to<double>(), 1e-9);
+  EXPECT_NEAR(0.0, estimate.Rotation().Radians().to<double>(), 1e-9);
+}
+
+TEST(PoseFusionEstimatorTest, RejectsMeasurementsOutsideHistory) {
+  photonlib::PoseFusionEstimator estimator(5);
+  EXPECT_FALSE(estimator.AddVisionMeasurement(frc::Pose2d(), 0_s));
+
+  for (int i = 0; i < 20; ++i) {
+    estimator.UpdateOdometry(frc::Pose2d(), i * 0.02_s);
+  }
+  // Only the last five samples (0.30 s - 0.38 s) are retained.
+  EXPECT_FALSE(estimator.AddVisionMeasurement(frc::Pose2d(), 0.2_s));
+  EXPECT_TRUE(estimator.AddVisionMeasurement(frc::Pose2d(), 0.31_s));
+}
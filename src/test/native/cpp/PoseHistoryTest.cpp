@@ -0,0 +1,71 @@
+/**
+ * Copyright (C) 2020-2021 Photon Vision.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <cmath>
+
+#include <units/angle.h>
+#include <units/length.h>
+#include <units/time.h>
+
+#include "gtest/gtest.h"
+#include "photonlib/PoseHistory.h"
+
+TEST(PoseHistoryTest, Empty) {
+  photonlib::PoseHistory history(10);
+  EXPECT_FALSE(history.Sample(0_s).has_value());
+}
+
+TEST(PoseHistoryTest, InterpolatesBetweenSamples) {
+  photonlib::PoseHistory history(10);
+  history.AddSample(1_s, frc::Pose2d(0_m, 0_m, frc::Rotation2d()));
+  history.AddSample(2_s, frc::Pose2d(1_m, 1_m, frc::Rotation2d(90_deg)));
+
+  auto pose = history.Sample(1.5_s);
+  ASSERT_TRUE(pose.has_value());
+  EXPECT_NEAR(45.0, pose->Rotation().Degrees().to<double>(), 1e-9);
+
+  // The midpoint of a quarter circle of radius 1 m centered at (0, 1).
+  EXPECT_NEAR(std::sqrt(2.0) / 2.0, pose->X().to<double>(), 1e-9);
+  EXPECT_NEAR(1.0 - std::sqrt(2.0) / 2.0, pose->Y().to<double>(), 1e-9);
+
+  EXPECT_EQ(frc::Pose2d(0_m, 0_m, frc::Rotation2d()), *history.Sample(1_s));
+  EXPECT_EQ(frc::Pose2d(1_m, 1_m, frc::Rotation2d(90_deg)),
+            *history.Sample(5_s));
+  EXPECT_FALSE(history.Sample(0.5_s).has_value());
+}
+
+TEST(PoseHistoryTest, OverwritesOldestSample) {
+  photonlib::PoseHistory history(4);
+  for (int i = 0; i < 10; ++i) {
+    history.AddSample(units::second_t(i),
+                      frc::Pose2d(units::meter_t(i), 0_m, frc::Rotation2d()));
+  }
+  EXPECT_EQ(4ul, history.Size());
+  EXPECT_FALSE(history.Sample(5.5_s).has_value());
+  for (double t = 6.0; t <= 9.0; t += 0.25) {
+    auto pose = history.Sample(units::second_t(t));
+    ASSERT_TRUE(pose.has_value());
+    EXPECT_NEAR(t, pose->X().to<double>(), 1e-9);
+  }
+}
+
+TEST(PoseHistoryTest, IgnoresOutOfOrderSamples) {
+  photonlib::PoseHistory history(4);
+  history.AddSample(2_s, frc::Pose2d(2_m, 0_m, frc::Rotation2d()));
+  history.AddSample(1_s, frc::Pose2d(1_m, 0_m, frc::Rotation2d()));
+  EXPECT_EQ(1ul, history.Size());
+}
@@ -0,0 +1,128 @@
+/**
+ * Copyright (C) 2020-2021 Photon Vision.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <cmath>
+#include <vector>
+
+#include <units/angle.h>
+#include <units/length.h>
+
+#include "gtest/gtest.h"
+#include "photonlib/RobustPoseEstimator.h"
+#include "photonlib/SimVisionSystem.h"
+
+namespace {
+std::vector<photonlib::PoseObservation> ObserveFrom(
+    const frc::Pose2d& robotPose, const std::vector<frc::Pose2d>& targets,
+    units::meter_t targetHeight) {
+  photonlib::SimVisionSystem sys("RobustTest", 160.0_deg, 0.0_deg,
+                                 frc::Transform2d(), 1.0_m, 99999.0_m, 640,
+                                 480, 0.0);
+  std::vector<photonlib::PoseObservation> observations;
+  for (auto pose : targets) {
+    sys.AddSimVisionTarget(
+        photonlib::SimVisionTarget(pose, targetHeight, 0.5_m, 0.5_m));
+  }
+  sys.ProcessFrame(robotPose);
+  auto result = sys.cam.GetLatestResult();
+  auto seen = result.GetTargets();
+  for (size_t i = 0; i < seen.size(); ++i) {
+    observations.push_back({seen[i], targets[i], targetHeight});
+  }
+  return observations;
+}
+}  // namespace
+
+TEST(RobustPoseEstimatorTest, Empty) {
+  photonlib::RobustPoseEstimator estimator(1.0_m, 0.0_rad, frc::Transform2d());
+  auto estimate = estimator.Estimate({}, frc::Rotation2d());
+  EXPECT_FALSE(estimate.valid);
+  EXPECT_TRUE(estimate.inliers.empty());
+}
+
+TEST(RobustPoseEstimatorTest, RejectsMismatchedTargets) {
+  auto robotPose =
+      frc::Pose2d(frc::Translation2d(30_m, 0_m), frc::Rotation2d());
+  std::vector<frc::Pose2d> targets{
+      frc::Pose2d(frc::Translation2d(35_m, 2_m), frc::Rotation2d()),
+      frc::Pose2d(frc::Translation2d(35_m, 0_m), frc::Rotation2d()),
+      frc::Pose2d(frc::Translation2d(35_m, -2_m), frc::Rotation2d()),
+      frc::Pose2d(frc::Translation2d(36_m, 1_m), frc::Rotation2d()),
+      frc::Pose2d(frc::Translation2d(36_m, -1_m), frc::Rotation2d())};
+  auto observations = ObserveFrom(robotPose, targets, 2.0_m);
+  ASSERT_EQ(targets.size(), observations.size());
+
+  // Associate two detections with the wrong field target, as a reflection
+  // would.
+  observations[0].fieldToTarget =
+      frc::Pose2d(frc::Translation2d(20_m, 5_m), frc::Rotation2d());
+  observations[3].fieldToTarget =
+      frc::Pose2d(frc::Translation2d(40_m, -6_m), frc::Rotation2d());
+
+  photonlib::RobustPoseEstimator estimator(1.0_m, 0.0_rad, frc::Transform2d(),
+                                           0.1_m, 64, 1_s, 1.0, 42);
+  auto estimate = estimator.Estimate(observations, frc::Rotation2d());
+  ASSERT_TRUE(estimate.valid);
+  ASSERT_EQ(3ul, estimate.inliers.size());
+  EXPECT_EQ(1ul, estimate.inliers[0]);
+  EXPECT_EQ(2ul, estimate.inliers[1]);
+  EXPECT_EQ(4ul, estimate.inliers[2]);
+  EXPECT_NEAR(30.0, estimate.fieldToRobot.X().to<double>(), 1e-6);
+  EXPECT_NEAR(0.0, estimate.fieldToRobot.Y().to<double>(), 1e-6);
+  EXPECT_GT(estimate.confidence, 0.9);
+}
+
+TEST(RobustPoseEstimatorTest, Deterministic) {
+  auto robotPose =
+      frc::Pose2d(frc::Translation2d(30_m, 1_m), frc::Rotation2d());
+  std::vector<frc::Pose2d> targets{
+      frc::Pose2d(frc::Translation2d(35_m, 2_m), frc::Rotation2d()),
+      frc::Pose2d(frc::Translation2d(35_m, 0_m), frc::Rotation2d()),
+      frc::Pose2d(frc::Translation2d(35_m, -2_m), frc::Rotation2d())};
+  auto observations = ObserveFrom(robotPose, targets, 2.0_m);
+  observations[2].fieldToTarget =
+      frc::Pose2d(frc::Translation2d(10_m, 0_m), frc::Rotation2d());
+
+  photonlib::RobustPoseEstimator a(1.0_m, 0.0_rad, frc::Transform2d(), 0.1_m,
+                                   4, 1_s, 1.0, 7);
+  photonlib::RobustPoseEstimator b(1.0_m, 0.0_rad, frc::Transform2d(), 0.1_m,
+                                   4, 1_s, 1.0, 7);
+  auto estimateA = a.Estimate(observations, frc::Rotation2d());
+  auto estimateB = b.Estimate(observations, frc::Rotation2d());
+  EXPECT_EQ(estimateA.fieldToRobot, estimateB.fieldToRobot);
+  EXPECT_EQ(estimateA.iterations, estimateB.iterations);
+  EXPECT_EQ(estimateA.inliers, estimateB.inliers);
+}
+
+TEST(RobustPoseEstimatorTest, ZeroIterationsStillEstimates) {
+  auto robotPose =
+      frc::Pose2d(frc::Translation2d(30_m, 1_m), frc::Rotation2d());
+  std::vector<frc::Pose2d> targets{
+      frc::Pose2d(frc::Translation2d(35_m, 2_m), frc::Rotation2d()),
+      frc::Pose2d(frc::Translation2d(35_m, 0_m), frc::Rotation2d())};
+  auto observations = ObserveFrom(robotPose, targets, 2.0_m);
+
+  photonlib::RobustPoseEstimator estimator(1.0_m, 0.0_rad, frc::Transform2d(),
+                                           0.1_m, 0, 1_s, 1.0, 3);
+  estimator.SetMaxIterations(0);
+  auto estimate = estimator.Estimate(observations, frc::Rotation2d());
+  ASSERT_TRUE(estimate.valid);
+  EXPECT_EQ(1, estimate.iterations);
+  EXPECT_FALSE(estimate.inliers.empty());
+  EXPECT_TRUE(std::isfinite(estimate.fieldToRobot.X().to<double>()));
+  EXPECT_TRUE(std::isfinite(estimate.confidence));
+}
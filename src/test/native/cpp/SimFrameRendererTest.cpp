@@ -0,0 +1,117 @@
+/**
+ * Copyright (C) 2020-2021 Photon Vision.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <cstdint>
+
+#include <units/angle.h>
+#include <units/length.h>
+
+#include "gtest/gtest.h"
+#include "photonlib/SimFrameRenderer.h"
+#include "photonlib/SimVisionSystem.h"
+
+namespace {
+size_t CountNonZero(const photonlib::SimFrameRenderer& renderer) {
+  size_t size = static_cast<size_t>(renderer.GetWidth()) *
+                renderer.GetHeight() *
+                (renderer.GetFormat() == photonlib::SimFrameRenderer::kBGR
+                     ? 3
+                     : 1);
+  size_t count = 0;
+  for (size_t i = 0; i < size; ++i) count += renderer.GetData()[i] != 0;
+  return count;
+}
+
+photonlib::SimTargetOutline Rectangle(double u0, double v0, double u1,
+                                      double v1) {
+  photonlib::SimTargetOutline outline;
+  outline.points[0] = {u0, v0};
+  outline.points[1] = {u1, v0};
+  outline.points[2] = {u1, v1};
+  outline.points[3] = {u0, v1};
+  outline.count = 4;
+  return outline;
+}
+}  // namespace
+
+TEST(SimFrameRendererTest, testFillPolygonCoversPixelCenters) {
+  photonlib::SimFrameRenderer renderer(64, 48);
+  renderer.FillPolygon(Rectangle(10, 10, 20, 20));
+  EXPECT_EQ(100u, CountNonZero(renderer));
+
+  // Half-pixel edges include only the pixels whose centers are inside.
+  renderer.Clear();
+  renderer.FillPolygon(Rectangle(10.4, 10.6, 12.6, 12.4));
+  EXPECT_EQ(3u * 1u, CountNonZero(renderer));
+
+  // Polygons are clipped to the frame.
+  renderer.Clear();
+  renderer.FillPolygon(Rectangle(-10, -10, 5, 100));
+  EXPECT_EQ(5u * 48u, CountNonZero(renderer));
+}
+
+TEST(SimFrameRendererTest, testConcavePolygon) {
+  // A U shape: the notch between the arms stays empty.
+  photonlib::SimTargetOutline outline;
+  const photonlib::SimPixel points[] = {{0, 0},  {30, 0}, {30, 30}, {20, 30},
+                                        {20, 10}, {10, 10}, {10, 30}, {0, 30}};
+  for (auto& point : points) outline.points[outline.count++] = point;
+
+  photonlib::SimFrameRenderer renderer(40, 40);
+  renderer.FillPolygon(outline);
+  EXPECT_EQ(30u * 30u - 10u * 20u, CountNonZero(renderer));
+}
+
+TEST(SimFrameRendererTest, testBGRColors) {
+  photonlib::SimFrameRenderer renderer(16, 16,
+                                       photonlib::SimFrameRenderer::kBGR);
+  renderer.SetColors({10, 20, 30}, {40, 50, 60});
+  renderer.FillPolygon(Rectangle(0, 0, 8, 16));
+
+  cv::Mat mat = renderer.GetMat();
+  EXPECT_EQ(CV_8UC3, mat.type());
+  const uint8_t* row = mat.ptr<uint8_t>(5);
+  EXPECT_EQ(40, row[0]);
+  EXPECT_EQ(50, row[1]);
+  EXPECT_EQ(60, row[2]);
+  EXPECT_EQ(10, row[8 * 3]);
+  EXPECT_EQ(20, row[8 * 3 + 1]);
+  EXPECT_EQ(30, row[8 * 3 + 2]);
+}
+
+TEST(SimFrameRendererTest, testSimVisionSystemRendersVisibleTargets) {
+  photonlib::SimVisionSystem sysUnderTest("RenderTest", 80.0_deg, 0.0_deg,
+                                          frc::Transform2d(), 1.0_m, 99999.0_m,
+                                          320, 240, 0.0);
+  sysUnderTest.EnableFrameRendering();
+  frc::Pose2d targetPose(4_m, 0_m, frc::Rotation2d(180_deg));
+  sysUnderTest.AddSimVisionTarget(
+      photonlib::SimVisionTarget(targetPose, 1.0_m, 0.5_m, 0.5_m));
+
+  sysUnderTest.ProcessFrame(frc::Pose2d());
+  auto* renderer = sysUnderTest.GetFrameRenderer();
+  ASSERT_NE(nullptr, renderer);
+  EXPECT_EQ(320, renderer->GetWidth());
+
+  // The target fills roughly its projected area.
+  auto intrinsics = photonlib::SimCameraIntrinsics::FromFOV(80_deg, 320, 240);
+  double side = intrinsics.fx * 0.5 / 4;
+  EXPECT_NEAR(side * side, CountNonZero(*renderer), 4 * side);
+
+  sysUnderTest.ProcessFrame(frc::Pose2d(0_m, 0_m, frc::Rotation2d(180_deg)));
+  EXPECT_EQ(0u, CountNonZero(*renderer));
+}
@@ -0,0 +1,107 @@
+/**
+ * Copyright (C) 2020-2021 Photon Vision.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <vector>
+
+#include <units/frequency.h>
+#include <units/time.h>
+
+#include "gtest/gtest.h"
+#include "photonlib/SimFrameScheduler.h"
+
+TEST(SimFrameSchedulerTest, testDefaultsAreImmediate) {
+  photonlib::SimFrameScheduler scheduler;
+  photonlib::SimPendingFrame frame;
+  for (int i = 0; i < 10; ++i) {
+    units::second_t now(i * 0.02);
+    ASSERT_TRUE(scheduler.ShouldCapture(now));
+    scheduler.Submit(now, {photonlib::PhotonTrackedTarget()});
+    ASSERT_TRUE(scheduler.PopCompleted(now, &frame));
+    EXPECT_EQ(now, frame.captureTime);
+    EXPECT_EQ(now, frame.completionTime);
+    EXPECT_EQ(1u, frame.targets.size());
+    EXPECT_FALSE(scheduler.PopCompleted(now, &frame));
+  }
+}
+
+TEST(SimFrameSchedulerTest, testFrameRate) {
+  photonlib::SimFrameScheduler scheduler(units::hertz_t(10.0));
+  int captures = 0;
+  // 50 Hz calls for 2 s against a 10 Hz camera.
+  for (int i = 0; i < 100; ++i) {
+    captures += scheduler.ShouldCapture(units::second_t(i * 0.02));
+  }
+  EXPECT_EQ(20, captures);
+
+  // A long gap skips the missed frames rather than bursting through them.
+  EXPECT_TRUE(scheduler.ShouldCapture(units::second_t(10.0)));
+  EXPECT_FALSE(scheduler.ShouldCapture(units::second_t(10.05)));
+  EXPECT_TRUE(scheduler.ShouldCapture(units::second_t(10.1)));
+}
+
+TEST(SimFrameSchedulerTest, testLatencyOrdering) {
+  photonlib::SimFrameScheduler scheduler(
+      units::hertz_t(0.0), units::second_t(0.05), units::second_t(0.03));
+  for (int i = 0; i < 200; ++i) {
+    scheduler.Submit(units::second_t(i * 0.01), {});
+  }
+  ASSERT_EQ(200u, scheduler.Pending());
+
+  photonlib::SimPendingFrame frame;
+  units::second_t lastCapture(-1.0);
+  units::second_t lastCompletion(-1.0);
+  double totalLatency = 0.0;
+  size_t popped = 0;
+  for (int i = 0; i < 400; ++i) {
+    units::second_t now(i * 0.01);
+    while (scheduler.PopCompleted(now, &frame)) {
+      EXPECT_LE(frame.completionTime, now);
+      EXPECT_GE(frame.completionTime, frame.captureTime);
+      EXPECT_GT(frame.captureTime, lastCapture);
+      EXPECT_GE(frame.completionTime, lastCompletion);
+      lastCapture = frame.captureTime;
+      lastCompletion = frame.completionTime;
+      totalLatency += (frame.completionTime - frame.captureTime).to<double>();
+      ++popped;
+    }
+  }
+  EXPECT_EQ(200u, popped);
+  // Queueing behind slow frames only ever adds to the mean.
+  EXPECT_GT(totalLatency / popped, 0.045);
+  EXPECT_LT(totalLatency / popped, 0.1);
+}
+
+TEST(SimFrameSchedulerTest, testDropsAreSeeded) {
+  auto countKept = [](uint64_t seed) {
+    photonlib::SimFrameScheduler scheduler(units::hertz_t(0.0),
+                                           units::second_t(0.0),
+                                           units::second_t(0.0), 0.3, seed);
+    std::vector<int> kept;
+    photonlib::SimPendingFrame frame;
+    for (int i = 0; i < 1000; ++i) {
+      units::second_t now(i * 0.01);
+      scheduler.Submit(now, {});
+      if (scheduler.PopCompleted(now, &frame)) kept.push_back(i);
+    }
+    return kept;
+  };
+
+  auto kept = countKept(42);
+  EXPECT_NEAR(700, static_cast<int>(kept.size()), 60);
+  EXPECT_EQ(kept, countKept(42));
+  EXPECT_NE(kept, countKept(43));
+}
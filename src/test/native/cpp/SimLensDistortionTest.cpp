@@ -0,0 +1,133 @@
+/**
+ * Copyright (C) 2020-2021 Photon Vision.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <cmath>
+#include <cstdint>
+
+#include <units/angle.h>
+#include <units/length.h>
+
+#include "SimTestHelpers.h"
+#include "gtest/gtest.h"
+#include "photonlib/SimLensDistortion.h"
+
+namespace {
+const photonlib::SimCameraIntrinsics kIntrinsics(500.0, 500.0, 320.0, 240.0,
+                                                 640, 480);
+const photonlib::SimDistortionCoefficients kBarrel(-0.25, 0.05, 0.001,
+                                                   -0.0005);
+
+photonlib::SimLensDistortion::Pixel DistortExact(
+    photonlib::SimLensDistortion::Pixel p) {
+  double x = (p.u - 320.0) / 500.0;
+  double y = (p.v - 240.0) / 500.0;
+  double r2 = x * x + y * y;
+  double radial = 1 + r2 * (kBarrel.k1 + r2 * kBarrel.k2);
+  double xd = x * radial + 2 * kBarrel.p1 * x * y +
+              kBarrel.p2 * (r2 + 2 * x * x);
+  double yd = y * radial + kBarrel.p1 * (r2 + 2 * y * y) +
+              2 * kBarrel.p2 * x * y;
+  return {320.0 + 500.0 * xd, 240.0 + 500.0 * yd};
+}
+
+photonlib::SimProjectedShape Measure(
+    frc::Pose2d targetPos, const photonlib::SimLensDistortion* distortion) {
+  return simtest::MeasureTarget(kIntrinsics, targetPos, 0.5_m, 0.5_m,
+                                distortion);
+}
+}  // namespace
+
+TEST(SimLensDistortionTest, testNoDistortionIsIdentity) {
+  photonlib::SimLensDistortion lens(
+      kIntrinsics, photonlib::SimDistortionCoefficients(0, 0, 0, 0));
+  simtest::Lcg rng(3);
+  for (int i = 0; i < 100; ++i) {
+    photonlib::SimLensDistortion::Pixel p{rng.Next(0, 640), rng.Next(0, 480)};
+    auto distorted = lens.Distort(p);
+    auto undistorted = lens.Undistort(p);
+    EXPECT_NEAR(p.u, distorted.u, 1e-9);
+    EXPECT_NEAR(p.v, distorted.v, 1e-9);
+    EXPECT_NEAR(p.u, undistorted.u, 1e-9);
+    EXPECT_NEAR(p.v, undistorted.v, 1e-9);
+  }
+  EXPECT_NEAR(0.0, lens.GetIdealBounds().minU, 1e-9);
+  EXPECT_NEAR(640.0, lens.GetIdealBounds().maxU, 1e-9);
+}
+
+TEST(SimLensDistortionTest, testTablesMatchModel) {
+  photonlib::SimLensDistortion lens(kIntrinsics, kBarrel);
+  const auto& bounds = lens.GetIdealBounds();
+
+  // Barrel distortion fits a wider view into the image.
+  EXPECT_LT(bounds.minU, -10.0);
+  EXPECT_GT(bounds.maxU, 650.0);
+  EXPECT_LT(bounds.minV, -10.0);
+  EXPECT_GT(bounds.maxV, 490.0);
+
+  simtest::Lcg rng(3);
+  for (int i = 0; i < 1000; ++i) {
+    photonlib::SimLensDistortion::Pixel ideal{
+        rng.Next(bounds.minU, bounds.maxU), rng.Next(bounds.minV, bounds.maxV)};
+    auto expected = DistortExact(ideal);
+    auto distorted = lens.Distort(ideal);
+    EXPECT_NEAR(expected.u, distorted.u, 0.05);
+    EXPECT_NEAR(expected.v, distorted.v, 0.05);
+
+    photonlib::SimLensDistortion::Pixel pixel{rng.Next(0, 640),
+                                              rng.Next(0, 480)};
+    auto roundTrip = DistortExact(lens.Undistort(pixel));
+    EXPECT_NEAR(pixel.u, roundTrip.u, 0.05);
+    EXPECT_NEAR(pixel.v, roundTrip.v, 0.05);
+  }
+}
+
+TEST(SimLensDistortionTest, testExtrapolatesPastTables) {
+  photonlib::SimLensDistortion lens(kIntrinsics, kBarrel);
+  const auto& bounds = lens.GetIdealBounds();
+
+  // Past the bounds the distortion carries on outward unchanged, including
+  // far past the table, e.g. for the corners of a clipped close target.
+  photonlib::SimLensDistortion::Pixel edge{bounds.maxU, 240.0};
+  auto distortedEdge = lens.Distort(edge);
+  for (double offset : {50.0, 1000.0, 1e5}) {
+    auto distorted = lens.Distort({edge.u + offset, 240.0});
+    EXPECT_NEAR(distortedEdge.u + offset, distorted.u, 1e-6 * offset);
+    EXPECT_NEAR(distortedEdge.v, distorted.v, 1e-6 * offset);
+  }
+
+  // Points well outside the image undistort to distinct points.
+  auto near = lens.Undistort({-100.0, 240.0});
+  auto far = lens.Undistort({-1000.0, 240.0});
+  EXPECT_LT(far.u, near.u - 500.0);
+}
+
+TEST(SimLensDistortionTest, testBarrelWidensView) {
+  photonlib::SimLensDistortion lens(kIntrinsics, kBarrel);
+
+  // Straight ahead, barrel distortion shrinks the target slightly.
+  frc::Pose2d ahead(4_m, 0_m, frc::Rotation2d(180_deg));
+  auto ideal = Measure(ahead, nullptr);
+  auto distorted = Measure(ahead, &lens);
+  EXPECT_LT(distorted.area, ideal.area);
+  EXPECT_GT(distorted.area, 0.9 * ideal.area);
+  EXPECT_NEAR(320.0, distorted.centerU, 0.5);
+
+  // Just past the ideal image's edge, it is pulled into view.
+  frc::Pose2d pastEdge(4_m, 2.9_m, frc::Rotation2d(180_deg));
+  EXPECT_EQ(0.0, Measure(pastEdge, nullptr).area);
+  EXPECT_GT(Measure(pastEdge, &lens).area, 0.0);
+}
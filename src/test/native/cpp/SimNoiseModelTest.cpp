@@ -0,0 +1,137 @@
+/**
+ * Copyright (C) 2020-2021 Photon Vision.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <cmath>
+#include <vector>
+
+#include <units/angle.h>
+#include <units/length.h>
+
+#include "gtest/gtest.h"
+#include "photonlib/Philox.h"
+#include "photonlib/SimNoiseModel.h"
+
+TEST(SimNoiseModelTest, testPhiloxKnownAnswers) {
+  // From the Random123 known-answer tests.
+  photonlib::Philox4x32 zero(0);
+  photonlib::Philox4x32::Block expectedZero = {0x6627e8d5, 0xe169c58d,
+                                               0xbc57ac4c, 0x9b00dbd8};
+  EXPECT_EQ(expectedZero, zero({0, 0, 0, 0}));
+
+  photonlib::Philox4x32 ones(0xffffffffffffffffull);
+  photonlib::Philox4x32::Block expectedOnes = {0x408f276d, 0x41c83b0e,
+                                               0xa20bc7c6, 0x6d5451fd};
+  EXPECT_EQ(expectedOnes,
+            ones({0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff}));
+}
+
+namespace {
+std::vector<photonlib::PhotonTrackedTarget> MakeTargets(size_t count,
+                                                        double distance) {
+  frc::Transform2d pose(frc::Translation2d(units::meter_t(distance), 0_m),
+                        frc::Rotation2d());
+  return std::vector<photonlib::PhotonTrackedTarget>(
+      count, photonlib::PhotonTrackedTarget(1.0, 2.0, 5.0, 0.0, pose));
+}
+}  // namespace
+
+TEST(SimNoiseModelTest, testDefaultIsNoiseless) {
+  photonlib::SimNoiseModel model;
+  EXPECT_FALSE(model.Enabled());
+  auto targets = MakeTargets(3, 4.0);
+  model.Apply(7, 60_deg, 45_deg, targets);
+  EXPECT_EQ(MakeTargets(3, 4.0), targets);
+}
+
+TEST(SimNoiseModelTest, testAngleNoiseGrowsWithDistance) {
+  photonlib::SimNoiseModel model(11);
+  model.SetAngleNoise(0.1_deg, 0.2_deg);
+  model.SetAreaNoise(0.1);
+
+  for (double distance : {0.0, 5.0}) {
+    double sigma = 0.1 + 0.2 * distance;
+    double yawSum = 0, yawSq = 0, pitchSum = 0, pitchSq = 0, areaSq = 0;
+    int n = 0;
+    for (uint64_t frame = 0; frame < 2000; ++frame) {
+      auto targets = MakeTargets(5, distance);
+      model.Apply(frame, 60_deg, 45_deg, targets);
+      ASSERT_EQ(5u, targets.size());
+      for (auto& t : targets) {
+        yawSum += t.GetYaw() - 1.0;
+        yawSq += (t.GetYaw() - 1.0) * (t.GetYaw() - 1.0);
+        pitchSum += t.GetPitch() - 2.0;
+        pitchSq += (t.GetPitch() - 2.0) * (t.GetPitch() - 2.0);
+        areaSq += (t.GetArea() / 5.0 - 1.0) * (t.GetArea() / 5.0 - 1.0);
+        ++n;
+      }
+    }
+    EXPECT_NEAR(0.0, yawSum / n, 0.05 * sigma);
+    EXPECT_NEAR(0.0, pitchSum / n, 0.05 * sigma);
+    EXPECT_NEAR(sigma, std::sqrt(yawSq / n), 0.05 * sigma);
+    EXPECT_NEAR(sigma, std::sqrt(pitchSq / n), 0.05 * sigma);
+    EXPECT_NEAR(0.1, std::sqrt(areaSq / n), 0.005);
+  }
+}
+
+TEST(SimNoiseModelTest, testFalseNegativesAndPositives) {
+  photonlib::SimNoiseModel model(5);
+  model.SetFalseNegativeRate(0.25);
+  model.SetFalsePositiveRate(0.1, 2.0);
+
+  size_t kept = 0;
+  size_t spurious = 0;
+  for (uint64_t frame = 0; frame < 4000; ++frame) {
+    auto targets = MakeTargets(4, 3.0);
+    model.Apply(frame, 60_deg, 40_deg, targets);
+    for (auto& t : targets) {
+      if (t.GetCameraRelativePose() == frc::Transform2d()) {
+        ++spurious;
+        EXPECT_LE(std::abs(t.GetYaw()), 30.0);
+        EXPECT_LE(std::abs(t.GetPitch()), 20.0);
+        EXPECT_LE(t.GetArea(), 2.0);
+      } else {
+        ++kept;
+      }
+    }
+  }
+  EXPECT_NEAR(0.75 * 16000, kept, 300);
+  EXPECT_NEAR(0.1 * 4000, spurious, 60);
+}
+
+TEST(SimNoiseModelTest, testDependsOnlyOnSeedAndFrame) {
+  photonlib::SimNoiseModel model(99);
+  model.SetAngleNoise(1_deg, 0_deg);
+  model.SetFalseNegativeRate(0.3);
+
+  auto first = MakeTargets(8, 2.0);
+  model.Apply(123, 60_deg, 45_deg, first);
+
+  // Other frames in between don't change frame 123.
+  auto other = MakeTargets(8, 2.0);
+  model.Apply(124, 60_deg, 45_deg, other);
+  auto second = MakeTargets(8, 2.0);
+  model.Apply(123, 60_deg, 45_deg, second);
+  EXPECT_EQ(first, second);
+  EXPECT_NE(first, other);
+
+  photonlib::SimNoiseModel reseeded(100);
+  reseeded.SetAngleNoise(1_deg, 0_deg);
+  reseeded.SetFalseNegativeRate(0.3);
+  auto third = MakeTargets(8, 2.0);
+  reseeded.Apply(123, 60_deg, 45_deg, third);
+  EXPECT_NE(first, third);
+}
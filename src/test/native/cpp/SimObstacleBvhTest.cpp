@@ -0,0 +1,124 @@
+/**
+ * Copyright (C) 2020-2021 Photon Vision.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <cstdint>
+#include <vector>
+
+#include <units/length.h>
+
+#include "SimTestHelpers.h"
+#include "gtest/gtest.h"
+#include "photonlib/SimObstacleBvh.h"
+
+namespace {
+double Cross(double ax, double ay, double bx, double by) {
+  return ax * by - ay * bx;
+}
+
+// Tests every obstacle.
+bool BruteForceOccludes(const std::vector<photonlib::SimObstacle>& obstacles,
+                        const frc::Translation2d& from, double fromHeight,
+                        const frc::Translation2d& to, double toHeight) {
+  double px = from.X().to<double>();
+  double py = from.Y().to<double>();
+  double rx = to.X().to<double>() - px;
+  double ry = to.Y().to<double>() - py;
+  for (auto& o : obstacles) {
+    double qx = o.start.X().to<double>() - px;
+    double qy = o.start.Y().to<double>() - py;
+    double sx = o.end.X().to<double>() - o.start.X().to<double>();
+    double sy = o.end.Y().to<double>() - o.start.Y().to<double>();
+    double denom = Cross(rx, ry, sx, sy);
+    if (denom == 0.0) continue;
+    double t = Cross(qx, qy, sx, sy) / denom;
+    double u = Cross(qx, qy, rx, ry) / denom;
+    if (u < 0 || u > 1 || t <= 0 || t >= 1 - 1e-6) continue;
+    if (fromHeight + t * (toHeight - fromHeight) < o.height.to<double>()) {
+      return true;
+    }
+  }
+  return false;
+}
+}  // namespace
+
+TEST(SimObstacleBvhTest, testEmpty) {
+  photonlib::SimObstacleBvh bvh;
+  EXPECT_FALSE(bvh.Occludes(frc::Translation2d(), 0_m,
+                            frc::Translation2d(5_m, 0_m), 0_m));
+}
+
+TEST(SimObstacleBvhTest, testWallHeight) {
+  photonlib::SimObstacleBvh bvh;
+  photonlib::SimObstacle wall{frc::Translation2d(2_m, -1_m),
+                              frc::Translation2d(2_m, 1_m), 1_m};
+  bvh.Add(wall);
+  frc::Translation2d camera;
+  frc::Translation2d target(4_m, 0_m);
+
+  // Looking straight through the wall, over it, and over it only once the
+  // line of sight has climbed high enough.
+  EXPECT_TRUE(bvh.Occludes(camera, 0.5_m, target, 0.5_m));
+  EXPECT_FALSE(bvh.Occludes(camera, 1.5_m, target, 1.5_m));
+  EXPECT_FALSE(bvh.Occludes(camera, 0.6_m, target, 1.6_m));
+  EXPECT_TRUE(bvh.Occludes(camera, 0.0_m, target, 1.6_m));
+
+  // Targets in front of the wall, or mounted on it, are seen.
+  EXPECT_FALSE(bvh.Occludes(camera, 0.5_m, frc::Translation2d(1.5_m, 0_m),
+                            0.5_m));
+  EXPECT_FALSE(bvh.Occludes(camera, 0.5_m, frc::Translation2d(2_m, 0.5_m),
+                            0.5_m));
+}
+
+TEST(SimObstacleBvhTest, testMatchesBruteForce) {
+  simtest::Lcg rng(3);
+  std::vector<photonlib::SimObstacle> obstacles;
+  for (int i = 0; i < 500; ++i) {
+    units::meter_t x(rng.Next(-8, 8));
+    units::meter_t y(rng.Next(-4, 4));
+    units::meter_t dx(rng.Next(-1, 1));
+    units::meter_t dy(rng.Next(-1, 1));
+    obstacles.push_back({frc::Translation2d(x, y),
+                         frc::Translation2d(x + dx, y + dy),
+                         units::meter_t(rng.Next(0, 2))});
+  }
+
+  photonlib::SimObstacleBvh bvh;
+  bvh.Add(wpi::ArrayRef<photonlib::SimObstacle>(obstacles).slice(0, 100));
+  bvh.Add(wpi::ArrayRef<photonlib::SimObstacle>(obstacles).slice(100, 400));
+  ASSERT_EQ(obstacles.size(), bvh.Size());
+
+  int occluded = 0;
+  for (int q = 0; q < 2000; ++q) {
+    frc::Translation2d from(units::meter_t(rng.Next(-9, 9)),
+                            units::meter_t(rng.Next(-5, 5)));
+    frc::Translation2d to(units::meter_t(rng.Next(-9, 9)),
+                          units::meter_t(rng.Next(-5, 5)));
+    double fromHeight = rng.Next(0, 2);
+    double toHeight = rng.Next(0, 2);
+    bool expected =
+        BruteForceOccludes(obstacles, from, fromHeight, to, toHeight);
+    ASSERT_EQ(expected, bvh.Occludes(from, units::meter_t(fromHeight), to,
+                                     units::meter_t(toHeight)))
+        << "query " << q;
+    occluded += expected;
+  }
+  EXPECT_GT(occluded, 100);
+  EXPECT_LT(occluded, 1900);
+
+  bvh.Clear();
+  EXPECT_EQ(0u, bvh.Size());
+}
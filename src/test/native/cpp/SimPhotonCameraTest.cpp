@@ -0,0 +1,112 @@
+/**
+ * Copyright (C) 2020-2021 Photon Vision.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <units/angle.h>
+#include <units/time.h>
+#include <wpi/SmallVector.h>
+
+#include "gtest/gtest.h"
+#include "photonlib/PhotonCamera.h"
+#include "photonlib/SimPhotonCamera.h"
+
+namespace {
+wpi::SmallVector<photonlib::PhotonTrackedTarget, 2> MakeTargets() {
+  return {photonlib::PhotonTrackedTarget{
+              3.0, -4.0, 9.0, 4.0,
+              frc::Transform2d(frc::Translation2d(1_m, 2_m), 1.5_rad)},
+          photonlib::PhotonTrackedTarget{
+              -1.0, 2.0, 0.5, 0.0,
+              frc::Transform2d(frc::Translation2d(4_m, -1_m), 0.2_rad)}};
+}
+}  // namespace
+
+TEST(SimPhotonCameraTest, testInProcessMatchesNetworkTables) {
+  photonlib::SimPhotonCamera sim("DeliveryTest");
+  photonlib::PhotonCamera reader("DeliveryTest");
+  auto targets = MakeTargets();
+
+  sim.SubmitProcessedFrame(25_ms, targets);
+  auto viaNT = reader.GetLatestResult();
+
+  sim.SetDeliveryMode(photonlib::SimPhotonCamera::kInProcess);
+  sim.SubmitProcessedFrame(25_ms, targets);
+  auto direct = reader.GetLatestResult();
+
+  EXPECT_EQ(viaNT, direct);
+  EXPECT_EQ(photonlib::PhotonPipelineResult(25_ms, targets), direct);
+}
+
+TEST(SimPhotonCameraTest, testSwitchingBackUsesNetworkTables) {
+  photonlib::SimPhotonCamera sim("DeliverySwitchTest");
+  photonlib::PhotonCamera reader("DeliverySwitchTest");
+  auto targets = MakeTargets();
+
+  sim.SetDeliveryMode(photonlib::SimPhotonCamera::kInProcess);
+  sim.SubmitProcessedFrame(10_ms, targets);
+  EXPECT_EQ(2u, reader.GetLatestResult().GetTargets().size());
+
+  // The in-process result must not shadow later NetworkTables results.
+  sim.SetDeliveryMode(photonlib::SimPhotonCamera::kNetworkTables);
+  sim.SubmitProcessedFrame(20_ms, {});
+  auto result = reader.GetLatestResult();
+  EXPECT_FALSE(result.HasTargets());
+  EXPECT_EQ(20_ms, result.GetLatency());
+}
+
+TEST(SimPhotonCameraTest, testResultPtrSharesInProcessResult) {
+  photonlib::SimPhotonCamera sim("DeliveryPtrTest");
+  photonlib::PhotonCamera reader("DeliveryPtrTest");
+  photonlib::PhotonCamera other("DeliveryPtrTest");
+  auto targets = MakeTargets();
+
+  sim.SubmitProcessedFrame(15_ms, targets);
+  auto viaNT = reader.GetLatestResultPtr();
+  ASSERT_NE(nullptr, viaNT);
+  EXPECT_EQ(reader.GetLatestResult(), *viaNT);
+  EXPECT_NE(viaNT, reader.GetLatestResultPtr());
+
+  // Every reader gets the published result itself, not a copy.
+  sim.SetDeliveryMode(photonlib::SimPhotonCamera::kInProcess);
+  sim.SubmitProcessedFrame(15_ms, targets);
+  auto direct = reader.GetLatestResultPtr();
+  EXPECT_EQ(direct, other.GetLatestResultPtr());
+  EXPECT_EQ(*viaNT, *direct);
+  EXPECT_TRUE(reader.HasTargets());
+
+  sim.SetDeliveryMode(photonlib::SimPhotonCamera::kNetworkTables);
+  EXPECT_NE(direct, reader.GetLatestResultPtr());
+}
+
+TEST(SimPhotonCameraTest, testDestroyedCameraUsesNetworkTables) {
+  photonlib::PhotonCamera reader("DeliveryDestroyTest");
+  auto targets = MakeTargets();
+  {
+    photonlib::SimPhotonCamera sim("DeliveryDestroyTest");
+    sim.SetDeliveryMode(photonlib::SimPhotonCamera::kInProcess);
+    sim.SubmitProcessedFrame(10_ms, targets);
+    EXPECT_EQ(2u, reader.GetLatestResult().GetTargets().size());
+  }
+
+  // A later camera on the same table publishing over NetworkTables is seen,
+  // not the destroyed camera's last result.
+  photonlib::SimPhotonCamera next("DeliveryDestroyTest");
+  next.SubmitProcessedFrame(30_ms, {});
+  auto result = reader.GetLatestResult();
+  EXPECT_FALSE(result.HasTargets());
+  EXPECT_EQ(30_ms, result.GetLatency());
+  EXPECT_EQ(result, *reader.GetLatestResultPtr());
+}
@@ -0,0 +1,122 @@
+/**
+ * Copyright (C) 2020-2021 Photon Vision.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <cmath>
+#include <cstdint>
+
+#include <units/angle.h>
+#include <units/length.h>
+
+#include "SimTestHelpers.h"
+#include "gtest/gtest.h"
+#include "photonlib/SimPinholeCamera.h"
+
+namespace {
+const photonlib::SimCameraIntrinsics kIntrinsics(500.0, 500.0, 320.0, 240.0,
+                                                 640, 480);
+
+photonlib::SimProjectedShape Measure(frc::Pose2d targetPos,
+                                     units::meter_t width,
+                                     units::meter_t height) {
+  return simtest::MeasureTarget(kIntrinsics, targetPos, width, height);
+}
+}  // namespace
+
+TEST(SimPinholeCameraTest, testFrontalTarget) {
+  frc::Pose2d targetPos(4_m, 0_m, frc::Rotation2d(180_deg));
+  auto shape = Measure(targetPos, 0.4_m, 0.2_m);
+
+  // A 0.4 x 0.2 m target 4 m away spans 50 x 25 pixels.
+  EXPECT_NEAR(50.0 * 25.0, shape.area, 1e-6);
+  EXPECT_NEAR(320.0, shape.centerU, 1e-9);
+  EXPECT_NEAR(240.0, shape.centerV, 1e-9);
+  EXPECT_NEAR(0.0, shape.skew.to<double>(), 1e-9);
+}
+
+TEST(SimPinholeCameraTest, testClippedAtImageEdge) {
+  // Centered on the left edge of the image, so half of it is cut off.
+  frc::Pose2d targetPos(4_m, units::meter_t(320.0 * 4 / 500),
+                        frc::Rotation2d(180_deg));
+  auto shape = Measure(targetPos, 0.4_m, 0.2_m);
+  EXPECT_NEAR(25.0 * 25.0, shape.area, 1e-6);
+  EXPECT_NEAR(12.5, shape.centerU, 1e-6);
+}
+
+TEST(SimPinholeCameraTest, testClippedBehindCamera) {
+  // A wide target straddling the camera: only the part in front shows.
+  frc::Pose2d targetPos(0_m, 1_m, frc::Rotation2d(-90_deg));
+  auto shape = Measure(targetPos, 4_m, 0.2_m);
+  EXPECT_GT(shape.area, 0.0);
+  EXPECT_LT(shape.centerU, 320.0);
+}
+
+TEST(SimPinholeCameraTest, testRotationGivesSkewAndShrinksArea) {
+  frc::Pose2d facing(4_m, 0_m, frc::Rotation2d(180_deg));
+  frc::Pose2d turnedLeft(4_m, 0_m, frc::Rotation2d(150_deg));
+  frc::Pose2d turnedRight(4_m, 0_m, frc::Rotation2d(-150_deg));
+  auto front = Measure(facing, 1_m, 1_m);
+  auto left = Measure(turnedLeft, 1_m, 1_m);
+  auto right = Measure(turnedRight, 1_m, 1_m);
+
+  EXPECT_LT(left.area, front.area);
+  EXPECT_NEAR(left.area, right.area, 1e-6);
+  EXPECT_GT(std::abs(left.skew.to<double>()), 0.1);
+  EXPECT_NEAR(left.skew.to<double>(), -right.skew.to<double>(), 1e-9);
+}
+
+TEST(SimPinholeCameraTest, testStatusesMatchClipping) {
+  simtest::Lcg rng(11);
+  photonlib::SimPinholeView view(frc::Pose2d(1_m, 2_m, 30_deg), 0.5_m,
+                                 10_deg, kIntrinsics);
+  photonlib::SimTargetGeometry geometry;
+  constexpr size_t kCount = 1003;
+  geometry.Resize(kCount);
+  for (size_t i = 0; i < kCount; ++i) {
+    frc::Pose2d pose(units::meter_t(rng.Next(-5, 7)),
+                     units::meter_t(rng.Next(-4, 8)),
+                     units::radian_t(rng.Next(-4, 4)));
+    geometry.Set(i, photonlib::SimVisionTarget(
+                        pose, units::meter_t(rng.Next(0, 2)),
+                        units::meter_t(rng.Next(0.1, 3)),
+                        units::meter_t(rng.Next(0.1, 1))));
+  }
+  photonlib::SimProjectedTargets projected;
+  photonlib::ProjectTargets(view, geometry, kCount, projected);
+
+  size_t inside = 0;
+  size_t hidden = 0;
+  for (size_t i = 0; i < kCount; ++i) {
+    auto status = projected.status[i];
+    auto shape = photonlib::MeasureProjectedTarget(view, projected, i);
+
+    // Measure again going through the clipping path.
+    projected.status[i] = photonlib::SimProjectedTargets::kClipped;
+    auto clipped = photonlib::MeasureProjectedTarget(view, projected, i);
+    projected.status[i] = status;
+
+    if (status == photonlib::SimProjectedTargets::kHidden) {
+      EXPECT_EQ(0.0, clipped.area) << "target " << i;
+      ++hidden;
+    } else {
+      EXPECT_NEAR(clipped.area, shape.area, 1e-6 * (1 + shape.area))
+          << "target " << i;
+    }
+    inside += status == photonlib::SimProjectedTargets::kInside;
+  }
+  EXPECT_GT(inside, 10u);
+  EXPECT_GT(hidden, kCount / 2);
+}
@@ -0,0 +1,158 @@
+/**
+ * Copyright (C) 2020-2021 Photon Vision.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <vector>
+
+#include <units/angle.h>
+#include <units/length.h>
+
+#include "gtest/gtest.h"
+#include "photonlib/SimRobotVision.h"
+
+namespace {
+struct Mount {
+  const char* name;
+  frc::Transform2d cameraToRobot;
+  units::meter_t height;
+  units::degree_t pitch;
+};
+
+// Four cameras facing out from the corners of the robot.
+const Mount kMounts[] = {
+    {"robotFront", frc::Transform2d(frc::Pose2d(0.3_m, 0.2_m, 0_deg), {}),
+     0.5_m, 10_deg},
+    {"robotLeft", frc::Transform2d(frc::Pose2d(-0.2_m, 0.3_m, 90_deg), {}),
+     0.6_m, 0_deg},
+    {"robotBack", frc::Transform2d(frc::Pose2d(-0.3_m, -0.2_m, 180_deg), {}),
+     0.4_m, -5_deg},
+    {"robotRight", frc::Transform2d(frc::Pose2d(0.2_m, -0.3_m, -90_deg), {}),
+     0.7_m, 20_deg},
+};
+}  // namespace
+
+TEST(SimRobotVisionTest, testMatchesSeparateSystems) {
+  photonlib::WorkStealingPool pool(3);
+  photonlib::SimRobotVision robot(pool);
+  std::vector<photonlib::SimVisionSystem> systems;
+  for (auto& mount : kMounts) {
+    robot.AddCamera(mount.name, 75_deg, mount.pitch, mount.cameraToRobot,
+                    mount.height, 8_m, 640, 480, 0.5);
+    systems.emplace_back(mount.name, 75_deg, mount.pitch, mount.cameraToRobot,
+                         mount.height, 8_m, 640, 480, 0.5);
+  }
+  ASSERT_EQ(4u, robot.GetCameraCount());
+
+  for (int i = 0; i < 200; ++i) {
+    frc::Pose2d targetPos(units::meter_t(i % 20 - 10.0),
+                          units::meter_t(i / 20 - 5.0), frc::Rotation2d());
+    photonlib::SimVisionTarget target(targetPos, units::meter_t(i % 4 * 0.4),
+                                      0.3_m, 0.3_m);
+    robot.AddSimVisionTarget(target);
+    for (auto& system : systems) system.AddSimVisionTarget(target);
+  }
+  photonlib::SimObstacle wall{frc::Translation2d(2_m, -3_m),
+                              frc::Translation2d(2_m, 3_m), 1_m};
+  robot.AddObstacles(wall);
+  for (auto& system : systems) system.AddObstacle(wall);
+
+  std::vector<photonlib::PhotonPipelineResult> results(4);
+  std::vector<photonlib::PhotonPipelineResult> expected(1);
+  size_t seen = 0;
+  for (int i = 0; i < 50; ++i) {
+    frc::Pose2d robotPose(units::meter_t(i % 10 - 5.0),
+                          units::meter_t(i % 7 - 3.0),
+                          frc::Rotation2d(units::degree_t(i * 23.0)));
+    robot.ProcessFrame(robotPose, results);
+    for (size_t c = 0; c < systems.size(); ++c) {
+      systems[c].ProcessFrames(robotPose, expected, pool);
+      EXPECT_EQ(expected[0], results[c]) << "pose " << i << " camera " << c;
+      seen += results[c].GetTargets().size();
+    }
+  }
+  EXPECT_GT(seen, 100u);
+}
+
+TEST(SimRobotVisionTest, testPublishesPerCamera) {
+  photonlib::SimRobotVision robot;
+  for (auto& mount : kMounts) {
+    robot.AddCamera(mount.name, 75_deg, 0_deg, mount.cameraToRobot, 0.5_m,
+                    20_m, 640, 480, 0.0);
+  }
+  frc::Pose2d targetPos(5_m, 0_m, frc::Rotation2d());
+  robot.AddSimVisionTarget(
+      photonlib::SimVisionTarget(targetPos, 0.5_m, 1_m, 1_m));
+
+  // The target is ahead of the robot; only the front camera sees it.
+  robot.ProcessFrame(frc::Pose2d());
+  EXPECT_TRUE(robot.GetCamera(0).cam.GetLatestResult().HasTargets());
+  for (size_t c = 1; c < robot.GetCameraCount(); ++c) {
+    EXPECT_FALSE(robot.GetCamera(c).cam.GetLatestResult().HasTargets());
+  }
+}
+
+TEST(SimRobotVisionTest, testCameraTargetsRejected) {
+  photonlib::SimRobotVision robot;
+  robot.AddCamera(kMounts[0].name, 75_deg, 0_deg, kMounts[0].cameraToRobot,
+                  0.5_m, 20_m, 640, 480, 0.0);
+  auto& camera = robot.GetCamera(0);
+
+  // Targets added to the camera itself would never be seen, since the robot
+  // simulates its cameras against its own store.
+  frc::Pose2d targetPos(5_m, 0_m, frc::Rotation2d());
+  photonlib::SimVisionTarget tgt(targetPos, 0.5_m, 1_m, 1_m);
+  auto handle = camera.AddSimVisionTarget(tgt);
+  EXPECT_FALSE(camera.UpdateTarget(handle, tgt));
+  EXPECT_FALSE(camera.AddTargets({{5.0, 0.0, 0.0, 0.5, 1.0, 1.0}}));
+
+  std::vector<photonlib::PhotonPipelineResult> results(1);
+  robot.ProcessFrame(frc::Pose2d(), results);
+  EXPECT_FALSE(results[0].HasTargets());
+
+  robot.AddSimVisionTarget(tgt);
+  camera.ProcessFrames(std::vector<frc::Pose2d>{frc::Pose2d()}, results);
+  EXPECT_FALSE(results[0].HasTargets());
+  robot.ProcessFrame(frc::Pose2d(), results);
+  EXPECT_TRUE(results[0].HasTargets());
+}
+
+TEST(SimRobotVisionTest, testCameraTiming) {
+  photonlib::SimRobotVision robot;
+  for (int c = 0; c < 2; ++c) {
+    robot.AddCamera(kMounts[0].name, 75_deg, 0_deg, kMounts[0].cameraToRobot,
+                    0.5_m, 20_m, 640, 480, 0.0);
+  }
+  frc::Pose2d targetPos(5_m, 0_m, frc::Rotation2d());
+  robot.AddSimVisionTarget(
+      photonlib::SimVisionTarget(targetPos, 0.5_m, 1_m, 1_m));
+  frc::Pose2d facingAway(0_m, 0_m, frc::Rotation2d(180_deg));
+
+  // Only the second camera is slowed down.
+  auto& slow = robot.GetCamera(1);
+  slow.SetFrameRate(units::hertz_t(10.0));
+  slow.SetLatency(0.05_s, 0_s);
+
+  robot.ProcessFrame(frc::Pose2d(), 0_s);
+  robot.ProcessFrame(frc::Pose2d(), 0.04_s);
+  EXPECT_TRUE(robot.GetCamera(0).cam.GetLatestResult().HasTargets());
+  EXPECT_FALSE(slow.cam.GetLatestResult().HasTargets());
+
+  robot.ProcessFrame(facingAway, 0.06_s);
+  EXPECT_FALSE(robot.GetCamera(0).cam.GetLatestResult().HasTargets());
+  auto result = slow.cam.GetLatestResult();
+  ASSERT_TRUE(result.HasTargets());
+  EXPECT_NEAR(0.06, result.GetLatency().to<double>(), 1e-9);
+}
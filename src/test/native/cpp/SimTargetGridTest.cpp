@@ -0,0 +1,139 @@
+/**
+ * Copyright (C) 2020-2021 Photon Vision.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include <units/angle.h>
+#include <units/length.h>
+
+#include "SimTestHelpers.h"
+#include "gtest/gtest.h"
+#include "photonlib/SimTargetGrid.h"
+
+class SimTargetGridTestFOVParam : public testing::TestWithParam<double> {};
+INSTANTIATE_TEST_SUITE_P(SimTargetGridTestFOVParamInst,
+                         SimTargetGridTestFOVParam,
+                         testing::Values(10.0, 60.0, 120.0, 179.0, 300.0));
+
+TEST_P(SimTargetGridTestFOVParam, testMatchesExhaustive) {
+  units::radian_t halfFOV = units::degree_t(GetParam() / 2);
+  simtest::Lcg rng(1);
+
+  std::vector<frc::Translation2d> targets;
+  photonlib::SimTargetGrid grid;
+  for (int i = 0; i < 2000; ++i) {
+    // Most targets on the field, a few well off it to exercise overflow.
+    double spread = i % 50 == 0 ? 100.0 : 16.0;
+    targets.emplace_back(units::meter_t(rng.Next(-spread, spread)),
+                         units::meter_t(rng.Next(-spread / 2, spread / 2)));
+    grid.Insert(targets.back());
+  }
+
+  wpi::SmallVector<size_t, 16> candidates;
+  size_t totalCandidates = 0;
+  for (int q = 0; q < 200; ++q) {
+    frc::Pose2d cameraPose(units::meter_t(rng.Next(-20, 20)),
+                           units::meter_t(rng.Next(-10, 10)),
+                           units::radian_t(rng.Next(-4, 4)));
+    units::meter_t range(rng.Next(0.5, 30));
+    grid.Query(cameraPose, range, halfFOV, candidates);
+    ASSERT_TRUE(std::is_sorted(candidates.begin(), candidates.end()));
+    totalCandidates += candidates.size();
+
+    for (size_t i = 0; i < targets.size(); ++i) {
+      frc::Transform2d camToTarget(cameraPose,
+                                   frc::Pose2d(targets[i], frc::Rotation2d()));
+      bool visible =
+          camToTarget.Translation().Norm() < range &&
+          units::math::abs(units::math::atan2(camToTarget.Translation().Y(),
+                                              camToTarget.Translation().X())) <
+              halfFOV;
+      if (visible) {
+        EXPECT_TRUE(std::binary_search(candidates.begin(), candidates.end(),
+                                       i))
+            << "query " << q << " missed target " << i;
+      }
+    }
+  }
+
+  // Narrow cameras should see only a small part of the field.
+  if (GetParam() <= 60.0) {
+    EXPECT_LT(totalCandidates, 200 * targets.size() / 5);
+  }
+}
+
+TEST(SimTargetGridTest, testMoveAndRemoveMatchRebuiltGrid) {
+  simtest::Lcg rng(1);
+  std::vector<frc::Translation2d> targets;
+  std::vector<bool> removed;
+  photonlib::SimTargetGrid grid;
+  for (int i = 0; i < 500; ++i) {
+    targets.emplace_back(units::meter_t(rng.Next(-8, 8)),
+                         units::meter_t(rng.Next(-4, 4)));
+    removed.push_back(false);
+    grid.Insert(targets.back());
+  }
+
+  wpi::SmallVector<size_t, 16> candidates;
+  wpi::SmallVector<size_t, 16> expected;
+  for (int step = 0; step < 50; ++step) {
+    // Nudge every target, drift some off the field, and remove or restore
+    // a few.
+    for (size_t i = 0; i < targets.size(); ++i) {
+      double drift = i % 37 == 0 ? 2.0 : 0.1;
+      targets[i] = frc::Translation2d(
+          targets[i].X() + units::meter_t(rng.Next(-drift, drift)),
+          targets[i].Y() + units::meter_t(rng.Next(-drift, drift)));
+      if (rng.Next(0, 1) < 0.02) {
+        removed[i] = !removed[i];
+        if (removed[i]) grid.Remove(i);
+      }
+      if (!removed[i]) grid.Move(i, targets[i]);
+    }
+
+    photonlib::SimTargetGrid rebuilt;
+    for (auto& target : targets) rebuilt.Insert(target);
+
+    frc::Pose2d cameraPose(units::meter_t(rng.Next(-10, 10)),
+                           units::meter_t(rng.Next(-5, 5)),
+                           units::radian_t(rng.Next(-4, 4)));
+    units::meter_t range(rng.Next(1, 20));
+    grid.Query(cameraPose, range, 35_deg, candidates);
+    rebuilt.Query(cameraPose, range, 35_deg, expected);
+
+    // Both grids are conservative, so compare them on the targets that are
+    // actually in the wedge.
+    for (size_t i = 0; i < targets.size(); ++i) {
+      frc::Transform2d camToTarget(cameraPose,
+                                   frc::Pose2d(targets[i], frc::Rotation2d()));
+      bool inView =
+          camToTarget.Translation().Norm() < range &&
+          units::math::abs(units::math::atan2(camToTarget.Translation().Y(),
+                                              camToTarget.Translation().X())) <
+              35_deg;
+      bool found =
+          std::binary_search(candidates.begin(), candidates.end(), i);
+      EXPECT_FALSE(removed[i] && found) << "step " << step << " target " << i;
+      if (!removed[i] && inView) {
+        EXPECT_TRUE(found) << "step " << step << " target " << i;
+      }
+    }
+  }
+}
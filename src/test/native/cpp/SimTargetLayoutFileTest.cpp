@@ -0,0 +1,177 @@
+/**
+ * Copyright (C) 2020-2021 Photon Vision.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <cstdio>
+#include <fstream>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include <units/angle.h>
+#include <units/length.h>
+
+#include "gtest/gtest.h"
+#include "photonlib/SimTargetLayoutFile.h"
+#include "photonlib/SimVisionSystem.h"
+
+namespace {
+std::vector<photonlib::SimPackedTarget> RandomField(size_t count) {
+  std::vector<photonlib::SimPackedTarget> targets;
+  uint32_t state = 12345;
+  auto next = [&state] {
+    state = state * 1664525u + 1013904223u;
+    return (state >> 8) / 16777216.0;
+  };
+  for (size_t i = 0; i < count; ++i) {
+    targets.push_back({next() * 16.0, next() * 8.0, next() * 6.28,
+                       next() * 2.5, 0.1 + next() * 0.5, 0.1 + next() * 0.5});
+  }
+  return targets;
+}
+}  // namespace
+
+TEST(SimTargetLayoutFileTest, WriteAndMap) {
+  auto targets = RandomField(100);
+  const std::string path = "SimTargetLayoutFileTest-write.bin";
+  ASSERT_TRUE(photonlib::SimTargetLayoutFile::Write(path, targets));
+
+  photonlib::SimTargetLayoutFile layout(path);
+  ASSERT_TRUE(layout.IsOpen());
+  ASSERT_EQ(targets.size(), layout.GetTargets().size());
+  for (size_t i = 0; i < targets.size(); ++i) {
+    EXPECT_EQ(targets[i].x, layout.GetTargets()[i].x);
+    EXPECT_EQ(targets[i].rotation, layout.GetTargets()[i].rotation);
+    EXPECT_EQ(targets[i].height, layout.GetTargets()[i].height);
+  }
+
+  photonlib::SimTargetLayoutFile moved(std::move(layout));
+  EXPECT_FALSE(layout.IsOpen());
+  EXPECT_EQ(targets.size(), moved.GetTargets().size());
+  std::remove(path.c_str());
+}
+
+TEST(SimTargetLayoutFileTest, RejectsBadFiles) {
+  photonlib::SimTargetLayoutFile missing("SimTargetLayoutFileTest-none.bin");
+  EXPECT_FALSE(missing.IsOpen());
+  EXPECT_TRUE(missing.GetTargets().empty());
+
+  const std::string path = "SimTargetLayoutFileTest-bad.bin";
+  ASSERT_TRUE(photonlib::SimTargetLayoutFile::Write(path, RandomField(3)));
+  std::vector<char> contents;
+  {
+    std::ifstream in(path, std::ios::binary);
+    contents.assign(std::istreambuf_iterator<char>(in),
+                    std::istreambuf_iterator<char>());
+  }
+  {
+    // One byte short of the last target.
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out.write(contents.data(), contents.size() - 1);
+  }
+  EXPECT_FALSE(photonlib::SimTargetLayoutFile(path).IsOpen());
+  {
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out.write("JSON", 4);
+    out.write(contents.data() + 4, contents.size() - 4);
+  }
+  EXPECT_FALSE(photonlib::SimTargetLayoutFile(path).IsOpen());
+  std::remove(path.c_str());
+}
+
+TEST(SimTargetLayoutFileTest, RejectsInvalidTargets) {
+  const std::string path = "SimTargetLayoutFileTest-invalid.bin";
+  auto targets = RandomField(3);
+  targets[1].x = std::numeric_limits<double>::quiet_NaN();
+  ASSERT_TRUE(photonlib::SimTargetLayoutFile::Write(path, targets));
+  EXPECT_FALSE(photonlib::SimTargetLayoutFile(path).IsOpen());
+
+  targets = RandomField(3);
+  targets[2].y = std::numeric_limits<double>::infinity();
+  ASSERT_TRUE(photonlib::SimTargetLayoutFile::Write(path, targets));
+  EXPECT_FALSE(photonlib::SimTargetLayoutFile(path).IsOpen());
+
+  targets = RandomField(3);
+  targets[0].width = 0.0;
+  ASSERT_TRUE(photonlib::SimTargetLayoutFile::Write(path, targets));
+  photonlib::SimTargetLayoutFile layout(path);
+  EXPECT_FALSE(layout.IsOpen());
+  EXPECT_TRUE(layout.GetTargets().empty());
+  std::remove(path.c_str());
+}
+
+TEST(SimTargetLayoutFileTest, ConvertJson) {
+  const std::string jsonPath = "SimTargetLayoutFileTest.json";
+  const std::string path = "SimTargetLayoutFileTest-json.bin";
+  {
+    std::ofstream json(jsonPath);
+    json << R"({"targets": [
+      {"x": 1.0, "y": 2.0, "rotation": 90.0,
+       "heightAboveGround": 2.5, "width": 1.0, "height": 0.5},
+      {"x": 15.0, "y": 6.0, "rotation": 0.0,
+       "heightAboveGround": 0.5, "width": 0.3, "height": 0.3}]})";
+  }
+  ASSERT_TRUE(photonlib::SimTargetLayoutFile::ConvertJson(jsonPath, path));
+  photonlib::SimTargetLayoutFile layout(path);
+  ASSERT_EQ(2u, layout.GetTargets().size());
+  EXPECT_DOUBLE_EQ(2.0, layout.GetTargets()[0].y);
+  EXPECT_NEAR(1.5707963267948966, layout.GetTargets()[0].rotation, 1e-12);
+  EXPECT_DOUBLE_EQ(2.5, layout.GetTargets()[0].heightAboveGround);
+  EXPECT_DOUBLE_EQ(0.3, layout.GetTargets()[1].width);
+  std::remove(jsonPath.c_str());
+  std::remove(path.c_str());
+}
+
+TEST(SimTargetLayoutFileTest, BulkLoadMatchesSingleAdds) {
+  auto targets = RandomField(50000);
+  const std::string path = "SimTargetLayoutFileTest-bulk.bin";
+  ASSERT_TRUE(photonlib::SimTargetLayoutFile::Write(path, targets));
+
+  photonlib::SimVisionSystem bulk("layoutFileBulk", 70_deg, 10_deg,
+                                  frc::Transform2d(), 0.6_m, 6_m, 640, 480,
+                                  0.5);
+  photonlib::SimVisionSystem single("layoutFileSingle", 70_deg, 10_deg,
+                                    frc::Transform2d(), 0.6_m, 6_m, 640, 480,
+                                    0.5);
+
+  photonlib::SimTargetLayoutFile layout(path);
+  bulk.AddTargetLayout(layout);
+
+  for (auto& tgt : targets) {
+    frc::Pose2d targetPos(units::meter_t(tgt.x), units::meter_t(tgt.y),
+                          units::radian_t(tgt.rotation));
+    single.AddSimVisionTarget(photonlib::SimVisionTarget(
+        targetPos, units::meter_t(tgt.heightAboveGround),
+        units::meter_t(tgt.width), units::meter_t(tgt.height)));
+  }
+
+  std::vector<frc::Pose2d> poses;
+  for (int i = 0; i < 64; ++i) {
+    poses.emplace_back(units::meter_t(i % 8 * 2.0), units::meter_t(i / 8),
+                       units::degree_t(i * 37.0));
+  }
+  std::vector<photonlib::PhotonPipelineResult> bulkResults(poses.size());
+  std::vector<photonlib::PhotonPipelineResult> singleResults(poses.size());
+  bulk.ProcessFrames(poses, bulkResults);
+  single.ProcessFrames(poses, singleResults);
+  size_t seen = 0;
+  for (size_t i = 0; i < poses.size(); ++i) {
+    EXPECT_EQ(singleResults[i], bulkResults[i]);
+    seen += bulkResults[i].GetTargets().size();
+  }
+  EXPECT_GT(seen, 0u);
+  std::remove(path.c_str());
+}
@@ -0,0 +1,252 @@
+/**
+ * Copyright (C) 2020-2021 Photon Vision.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include <units/angle.h>
+#include <units/length.h>
+
+#include "SimTestHelpers.h"
+#include "gtest/gtest.h"
+#include "photonlib/SimTargetStore.h"
+
+namespace {
+// The per-target math from SimVisionSystem::ProcessFrame.
+bool ScalarCanSee(const frc::Pose2d& cameraPose, units::meter_t camHeight,
+                  units::degree_t camPitch, units::meter_t range,
+                  units::degree_t horizFOV, units::degree_t vertFOV,
+                  double m2PerPxAt1m, double minTargetArea,
+                  const photonlib::SimVisionTarget& tgt) {
+  frc::Transform2d camToTarget(cameraPose, tgt.targetPos);
+  units::meter_t ground = camToTarget.Translation().Norm();
+  units::meter_t vertical = tgt.targetHeightAboveGround - camHeight;
+  double area = tgt.tgtArea.to<double>() /
+                (m2PerPxAt1m * ground.to<double>() * ground.to<double>());
+  units::degree_t yaw =
+      -1.0 * units::math::atan2(camToTarget.Translation().Y(),
+                                camToTarget.Translation().X());
+  units::degree_t pitch = units::math::atan2(vertical, ground) - camPitch;
+  return units::math::hypot(ground, vertical) < range &&
+         units::math::abs(yaw) < horizFOV / 2 &&
+         units::math::abs(pitch) < vertFOV / 2 && area > minTargetArea;
+}
+}  // namespace
+
+TEST(SimTargetStoreTest, testKernelMatchesScalar) {
+  simtest::Lcg rng(7);
+  std::vector<photonlib::SimVisionTarget> targets;
+  std::vector<double> xs, ys, heights, areas;
+  for (int i = 0; i < 1003; ++i) {
+    frc::Pose2d pose(units::meter_t(rng.Next(-16, 16)),
+                     units::meter_t(rng.Next(-8, 8)), frc::Rotation2d());
+    targets.emplace_back(pose, units::meter_t(rng.Next(0, 3)),
+                         units::meter_t(rng.Next(0.05, 1)),
+                         units::meter_t(rng.Next(0.05, 1)));
+    xs.push_back(pose.X().to<double>());
+    ys.push_back(pose.Y().to<double>());
+    heights.push_back(targets.back().targetHeightAboveGround.to<double>());
+    areas.push_back(targets.back().tgtArea.to<double>());
+  }
+
+  std::vector<uint8_t> visible(targets.size());
+  size_t totalVisible = 0;
+  for (int q = 0; q < 100; ++q) {
+    frc::Pose2d cameraPose(units::meter_t(rng.Next(-16, 16)),
+                           units::meter_t(rng.Next(-8, 8)),
+                           units::radian_t(rng.Next(-4, 4)));
+    units::meter_t camHeight(rng.Next(0, 1.5));
+    units::degree_t camPitch(rng.Next(-30, 30));
+    units::meter_t range(rng.Next(2, 25));
+    units::degree_t horizFOV(rng.Next(20, 170));
+    units::degree_t vertFOV(rng.Next(20, 120));
+    double m2PerPxAt1m = rng.Next(1e-6, 1e-4);
+    double minTargetArea = rng.Next(0, 100);
+
+    photonlib::SimCameraView view(cameraPose, camHeight, camPitch, range,
+                                  horizFOV, vertFOV, m2PerPxAt1m,
+                                  minTargetArea);
+    size_t marked = photonlib::ComputeVisibilityMask(
+        view, xs.data(), ys.data(), heights.data(), areas.data(),
+        targets.size(), visible.data());
+
+    size_t count = 0;
+    for (size_t i = 0; i < targets.size(); ++i) {
+      count += visible[i];
+      // Random targets are never within the tolerance of an edge, so the
+      // mask should agree exactly.
+      bool expected =
+          ScalarCanSee(cameraPose, camHeight, camPitch, range, horizFOV,
+                       vertFOV, m2PerPxAt1m, minTargetArea, targets[i]);
+      ASSERT_EQ(expected, visible[i] != 0) << "query " << q << " target " << i;
+
+      // Whole batches and the scalar tail give the same answer.
+      uint8_t single;
+      photonlib::ComputeVisibilityMask(view, &xs[i], &ys[i], &heights[i],
+                                       &areas[i], 1, &single);
+      ASSERT_EQ(visible[i], single);
+    }
+    EXPECT_EQ(count, marked);
+    totalVisible += count;
+  }
+  EXPECT_GT(totalVisible, 0u);
+}
+
+TEST(SimTargetStoreTest, testEdgeTargetsKept) {
+  // A target exactly on the horizontal FOV edge is not visible, but the
+  // kernel keeps it for the exact check rather than risk dropping it.
+  frc::Pose2d cameraPose;
+  photonlib::SimCameraView view(cameraPose, 0_m, 0_deg, 100_m, 90_deg,
+                                90_deg, 1e-5, 0.0);
+  double xs[] = {1.0, 1.0, 1.0};
+  double ys[] = {1.0, 1.1, 0.5};
+  double heights[] = {0.0, 0.0, 0.0};
+  double areas[] = {1.0, 1.0, 1.0};
+  uint8_t visible[3];
+  photonlib::ComputeVisibilityMask(view, xs, ys, heights, areas, 3, visible);
+  EXPECT_EQ(1, visible[0]);
+  EXPECT_EQ(0, visible[1]);
+  EXPECT_EQ(1, visible[2]);
+}
+
+TEST(SimTargetStoreTest, testFindCandidatesOrdered) {
+  photonlib::SimTargetStore store;
+  for (int i = 0; i < 20; ++i) {
+    frc::Pose2d pose(units::meter_t(i - 10.0), 0_m, frc::Rotation2d());
+    store.Add(photonlib::SimVisionTarget(pose, 0_m, 1_m, 1_m));
+  }
+  ASSERT_EQ(20u, store.Size());
+
+  frc::Pose2d cameraPose(-0.5_m, 0_m, frc::Rotation2d());
+  photonlib::SimCameraView view(cameraPose, 0_m, 0_deg, 5.2_m, 60_deg, 60_deg,
+                                1e-5, 0.0);
+  photonlib::SimTargetStore::Scratch scratch;
+  wpi::SmallVector<size_t, 16> candidates;
+  store.FindCandidates(view, scratch, candidates);
+
+  // Targets at x = 0..4 are ahead of the camera and in range.
+  ASSERT_EQ(5u, candidates.size());
+  for (size_t i = 0; i < candidates.size(); ++i) {
+    EXPECT_EQ(10 + i, candidates[i]);
+    EXPECT_DOUBLE_EQ(i, store[candidates[i]].targetPos.X().to<double>());
+  }
+}
+
+TEST(SimTargetStoreTest, testUpdateAndRemoveByHandle) {
+  photonlib::SimTargetStore store;
+  std::vector<photonlib::SimTargetHandle> handles;
+  for (int i = 0; i < 20; ++i) {
+    frc::Pose2d pose(units::meter_t(i - 10.0), 0_m, frc::Rotation2d());
+    handles.push_back(
+        store.Add(photonlib::SimVisionTarget(pose, 0_m, 1_m, 1_m)));
+  }
+
+  frc::Pose2d cameraPose(-0.5_m, 0_m, frc::Rotation2d());
+  photonlib::SimCameraView view(cameraPose, 0_m, 0_deg, 5.2_m, 60_deg, 60_deg,
+                                1e-5, 0.0);
+  photonlib::SimTargetStore::Scratch scratch;
+  wpi::SmallVector<size_t, 16> candidates;
+
+  // Move a target from behind the camera into view, and remove one in view.
+  frc::Pose2d ahead(2.5_m, 0.1_m, frc::Rotation2d());
+  EXPECT_TRUE(store.Update(handles[0],
+                           photonlib::SimVisionTarget(ahead, 0_m, 1_m, 1_m)));
+  EXPECT_TRUE(store.Remove(handles[12]));
+  EXPECT_FALSE(store.Contains(handles[12]));
+  EXPECT_EQ(19u, store.Size());
+
+  store.FindCandidates(view, scratch, candidates);
+  std::vector<size_t> expected{0, 10, 11, 13, 14};
+  EXPECT_EQ(expected, std::vector<size_t>(candidates.begin(),
+                                          candidates.end()));
+
+  // The removed target's handle stays stale after its slot is reused.
+  frc::Pose2d far(50_m, 0_m, frc::Rotation2d());
+  auto reused = store.Add(photonlib::SimVisionTarget(far, 0_m, 1_m, 1_m));
+  EXPECT_EQ(handles[12].slot, reused.slot);
+  EXPECT_NE(handles[12], reused);
+  EXPECT_FALSE(store.Remove(handles[12]));
+  EXPECT_FALSE(store.Update(handles[12],
+                            photonlib::SimVisionTarget(ahead, 0_m, 1_m, 1_m)));
+  EXPECT_TRUE(store.Contains(reused));
+  EXPECT_EQ(20u, store.Size());
+
+  store.FindCandidates(view, scratch, candidates);
+  expected = {0, 10, 11, 13, 14};
+  EXPECT_EQ(expected, std::vector<size_t>(candidates.begin(),
+                                          candidates.end()));
+}
+
+TEST(SimTargetStoreTest, testAddBulk) {
+  photonlib::SimTargetStore store;
+  frc::Pose2d first(3_m, 0_m, frc::Rotation2d());
+  auto handle = store.Add(photonlib::SimVisionTarget(first, 0_m, 1_m, 1_m));
+  ASSERT_TRUE(store.Remove(handle));
+
+  // Bulk targets go after every existing slot, even a free one.
+  std::vector<photonlib::SimPackedTarget> packed;
+  for (int i = 0; i < 20; ++i) {
+    packed.push_back({i - 10.0, 0.0, 0.0, 0.0, 1.0, 1.0});
+  }
+  EXPECT_TRUE(store.AddBulk(packed));
+  EXPECT_EQ(20u, store.Size());
+  EXPECT_FALSE(store.Contains(handle));
+  EXPECT_TRUE(store.Contains(photonlib::SimTargetHandle{20, 0}));
+  EXPECT_DOUBLE_EQ(1.0, store[5].tgtArea.to<double>());
+
+  frc::Pose2d cameraPose(-0.5_m, 0_m, frc::Rotation2d());
+  photonlib::SimCameraView view(cameraPose, 0_m, 0_deg, 5.2_m, 60_deg, 60_deg,
+                                1e-5, 0.0);
+  photonlib::SimTargetStore::Scratch scratch;
+  wpi::SmallVector<size_t, 16> candidates;
+  store.FindCandidates(view, scratch, candidates);
+  std::vector<size_t> expected{11, 12, 13, 14, 15};
+  EXPECT_EQ(expected, std::vector<size_t>(candidates.begin(),
+                                          candidates.end()));
+
+  // Bulk targets can be updated and removed like any other.
+  EXPECT_TRUE(store.Remove(photonlib::SimTargetHandle{13, 0}));
+  store.FindCandidates(view, scratch, candidates);
+  expected = {11, 12, 14, 15};
+  EXPECT_EQ(expected, std::vector<size_t>(candidates.begin(),
+                                          candidates.end()));
+}
+
+TEST(SimTargetStoreTest, testAddBulkSkipsInvalid) {
+  photonlib::SimTargetStore store;
+  constexpr double kNaN = std::numeric_limits<double>::quiet_NaN();
+  constexpr double kInf = std::numeric_limits<double>::infinity();
+  std::vector<photonlib::SimPackedTarget> packed{
+      {1.0, 0.0, 0.0, 0.0, 1.0, 1.0},  {kNaN, 0.0, 0.0, 0.0, 1.0, 1.0},
+      {2.0, kInf, 0.0, 0.0, 1.0, 1.0}, {3.0, 0.0, 0.0, 0.0, -1.0, 1.0},
+      {4.0, 0.0, 0.0, 0.0, 1.0, 1.0},  {5.0, 0.0, kNaN, 0.0, 1.0, 1.0}};
+  EXPECT_FALSE(store.AddBulk(packed));
+  ASSERT_EQ(2u, store.Size());
+  EXPECT_DOUBLE_EQ(1.0, store[0].targetPos.X().to<double>());
+  EXPECT_DOUBLE_EQ(4.0, store[1].targetPos.X().to<double>());
+
+  frc::Pose2d cameraPose(0_m, 0_m, frc::Rotation2d());
+  photonlib::SimCameraView view(cameraPose, 0_m, 0_deg, 10_m, 60_deg, 60_deg,
+                                1e-5, 0.0);
+  photonlib::SimTargetStore::Scratch scratch;
+  wpi::SmallVector<size_t, 16> candidates;
+  store.FindCandidates(view, scratch, candidates);
+  std::vector<size_t> expected{0, 1};
+  EXPECT_EQ(expected, std::vector<size_t>(candidates.begin(),
+                                          candidates.end()));
+}
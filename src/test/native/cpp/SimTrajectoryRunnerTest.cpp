@@ -0,0 +1,205 @@
+/**
+ * Copyright (C) 2020-2021 Photon Vision.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <units/angle.h>
+#include <units/length.h>
+#include <units/time.h>
+
+#include "gtest/gtest.h"
+#include "photonlib/SimTrajectory.h"
+#include "photonlib/SimTrajectoryRunner.h"
+
+namespace {
+// A robot spinning in place at the origin, once per second, facing a target
+// 3 m down the x axis at the start.
+photonlib::SimTrajectory SpinInPlace(units::second_t duration,
+                                     units::second_t step) {
+  std::vector<photonlib::SimTrajectory::Sample> samples;
+  for (int i = 0; i * step <= duration; ++i) {
+    units::second_t t = i * step;
+    samples.push_back({t, frc::Pose2d(0_m, 0_m, units::degree_t(
+                                                    t.to<double>() * 360.0))});
+  }
+  return photonlib::SimTrajectory(samples);
+}
+
+photonlib::SimVisionSystem MakeSystem(const std::string& name) {
+  photonlib::SimVisionSystem system(name, 80_deg, 0_deg, frc::Transform2d(),
+                                    0.5_m, 20_m, 640, 480, 0.0);
+  frc::Pose2d targetPos(3_m, 0_m, 180_deg);
+  system.AddSimVisionTarget(
+      photonlib::SimVisionTarget(targetPos, 0.5_m, 0.5_m, 0.5_m));
+  return system;
+}
+}  // namespace
+
+TEST(SimTrajectoryRunnerTest, ParseCsv) {
+  auto trajectory = photonlib::SimTrajectory::FromCsv(
+      "time,x,y,rotation\n"
+      "# start\n"
+      "0.0, 1.0, 2.0, 90\n"
+      "\n"
+      "0.5,1.5,2.5,-45\r\n");
+  ASSERT_EQ(2u, trajectory.Size());
+  auto samples = trajectory.GetSamples();
+  EXPECT_DOUBLE_EQ(0.5, samples[1].time.to<double>());
+  EXPECT_DOUBLE_EQ(2.0, samples[0].pose.Y().to<double>());
+  EXPECT_NEAR(90.0, samples[0].pose.Rotation().Degrees().to<double>(), 1e-9);
+  EXPECT_NEAR(-45.0, samples[1].pose.Rotation().Degrees().to<double>(), 1e-9);
+
+  EXPECT_EQ(0u,
+            photonlib::SimTrajectory::FromCsv("0,1,2,3\n0,1,oops,3\n").Size());
+  EXPECT_EQ(0u, photonlib::SimTrajectory::FromCsv("0,1,2\n").Size());
+
+  // Fields must be whole numbers, though whitespace around them is fine.
+  EXPECT_EQ(1u, photonlib::SimTrajectory::FromCsv("0 ,1\t, 2 ,3 \n").Size());
+  EXPECT_EQ(0u,
+            photonlib::SimTrajectory::FromCsv("0,1,2,3\n0,1m,2,3\n").Size());
+  EXPECT_EQ(0u, photonlib::SimTrajectory::FromCsv("0,1,2,3\n0,1,,3\n").Size());
+
+  // A first line with a number in it is a bad sample, not a header.
+  EXPECT_EQ(0u,
+            photonlib::SimTrajectory::FromCsv("0,1x,2,3\n1,1,2,3\n").Size());
+  EXPECT_EQ(1u,
+            photonlib::SimTrajectory::FromCsv("t,x,,r\n1,1,2,3\n").Size());
+}
+
+TEST(SimTrajectoryRunnerTest, BinaryRoundTrip) {
+  auto trajectory = SpinInPlace(1_s, 0.1_s);
+  const std::string path = "SimTrajectoryRunnerTest-trajectory.bin";
+  ASSERT_TRUE(trajectory.SaveBinary(path));
+  auto loaded = photonlib::SimTrajectory::Load(path);
+  std::remove(path.c_str());
+
+  ASSERT_EQ(trajectory.Size(), loaded.Size());
+  for (size_t i = 0; i < loaded.Size(); ++i) {
+    auto& expected = trajectory.GetSamples()[i];
+    auto& actual = loaded.GetSamples()[i];
+    EXPECT_EQ(expected.time, actual.time);
+    EXPECT_EQ(expected.pose, actual.pose);
+  }
+
+  EXPECT_EQ(0u, photonlib::SimTrajectory::Load("missing.bin").Size());
+}
+
+TEST(SimTrajectoryRunnerTest, StatsAndResults) {
+  auto system = MakeSystem("trajectoryRunnerStats");
+  auto trajectory = SpinInPlace(2_s, 0.01_s);
+  photonlib::WorkStealingPool pool(3);
+  photonlib::SimTrajectoryRunner runner(system, pool);
+  const auto& stats = runner.Run(trajectory);
+
+  ASSERT_EQ(trajectory.Size(), stats.frames);
+  EXPECT_EQ(stats.framesWithTargets, stats.targetSightings);
+  EXPECT_EQ(1u, stats.maxTargetsInFrame);
+  EXPECT_GT(stats.FramesPerSecond(), 0.0);
+
+  std::vector<frc::Pose2d> poses;
+  for (auto& sample : trajectory.GetSamples()) poses.push_back(sample.pose);
+  std::vector<photonlib::PhotonPipelineResult> expected(poses.size());
+  system.ProcessFrames(poses, expected, pool);
+  size_t framesWithTargets = 0;
+  for (auto& result : expected) framesWithTargets += result.HasTargets();
+  EXPECT_EQ(framesWithTargets, stats.framesWithTargets);
+  EXPECT_GT(stats.VisibleFraction(), 0.1);
+  EXPECT_LT(stats.VisibleFraction(), 0.3);
+
+  // The target is seen once per turn, so the longest blind stretch is the
+  // rest of the turn.
+  EXPECT_NEAR(1.0 - stats.VisibleFraction(),
+              stats.longestBlindStretch.to<double>(), 0.02);
+
+  ASSERT_EQ(expected.size(), runner.GetResults().size());
+  for (size_t i = 0; i < expected.size(); ++i) {
+    EXPECT_EQ(expected[i], runner.GetResults()[i]);
+  }
+}
+
+TEST(SimTrajectoryRunnerTest, ResultsFileRoundTrip) {
+  auto system = MakeSystem("trajectoryRunnerFile");
+  photonlib::SimTrajectoryRunner runner(system);
+  runner.Run(SpinInPlace(1_s, 0.05_s));
+  const std::string path = "SimTrajectoryRunnerTest-results.bin";
+  ASSERT_TRUE(runner.WriteResults(path));
+
+  std::vector<units::second_t> times;
+  std::vector<photonlib::PhotonPipelineResult> results;
+  ASSERT_TRUE(
+      photonlib::SimTrajectoryRunner::ReadResults(path, times, results));
+  ASSERT_EQ(runner.GetResults().size(), results.size());
+  for (size_t i = 0; i < results.size(); ++i) {
+    EXPECT_EQ(runner.GetTimes()[i], times[i]);
+    EXPECT_EQ(runner.GetResults()[i], results[i]);
+  }
+
+  // A truncated file is rejected rather than read past its end.
+  std::vector<char> contents;
+  {
+    std::ifstream in(path, std::ios::binary);
+    contents.assign(std::istreambuf_iterator<char>(in),
+                    std::istreambuf_iterator<char>());
+  }
+  {
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out.write(contents.data(), contents.size() - 9);
+  }
+  EXPECT_FALSE(
+      photonlib::SimTrajectoryRunner::ReadResults(path, times, results));
+  EXPECT_TRUE(results.empty());
+  std::remove(path.c_str());
+}
+
+TEST(SimTrajectoryRunnerTest, ResultsFileHoldsCrowdedFrames) {
+  // More targets in view than an int8 count holds.
+  photonlib::SimVisionSystem system("trajectoryRunnerCrowded", 80_deg, 0_deg,
+                                    frc::Transform2d(), 0.5_m, 20_m, 640, 480,
+                                    0.0);
+  for (int i = 0; i < 200; ++i) {
+    frc::Pose2d targetPos(units::meter_t(5.0 + i % 10),
+                          units::meter_t((i / 10 - 10) * 0.2), 180_deg);
+    system.AddSimVisionTarget(
+        photonlib::SimVisionTarget(targetPos, 0.5_m, 0.1_m, 0.1_m));
+  }
+  photonlib::SimTrajectoryRunner runner(system);
+  const auto& stats = runner.Run(SpinInPlace(1_s, 0.25_s));
+  ASSERT_GT(stats.maxTargetsInFrame, 127u);
+
+  const std::string path = "SimTrajectoryRunnerTest-crowded.bin";
+  ASSERT_TRUE(runner.WriteResults(path));
+  std::vector<units::second_t> times;
+  std::vector<photonlib::PhotonPipelineResult> results;
+  ASSERT_TRUE(
+      photonlib::SimTrajectoryRunner::ReadResults(path, times, results));
+  ASSERT_EQ(runner.GetResults().size(), results.size());
+  for (size_t i = 0; i < results.size(); ++i) {
+    EXPECT_EQ(runner.GetResults()[i], results[i]);
+  }
+  std::remove(path.c_str());
+}
+
+TEST(SimTrajectoryRunnerTest, FifteenSecondAutoAtOneKilohertz) {
+  auto system = MakeSystem("trajectoryRunnerAuto");
+  photonlib::SimTrajectoryRunner runner(system);
+  const auto& stats = runner.Run(SpinInPlace(15_s, 1_ms));
+  EXPECT_EQ(15001u, stats.frames);
+  EXPECT_GT(stats.framesWithTargets, 0u);
+}
@@ -15,6 +15,12 @@
  * along with this program.  If not, see <https://www.gnu.org/licenses/>.
  */
 
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <memory>
+#include <vector>
+
 #include <networktables/NetworkTable.h>
 #include <networktables/NetworkTableEntry.h>
 #include <networktables/NetworkTableInstance.h>
@@ -399,3 +405,290 @@ TEST(SimVisionSystemTest, testMultipleTargets) {
   auto tgtList = result.GetTargets();
   EXPECT_EQ(11ul, tgtList.size());
 }
+
+TEST(SimVisionSystemTest, testProcessFramesMatchesProcessFrame) {
+  photonlib::SimVisionSystem sysUnderTest("test", 100.0_deg, 5.0_deg,
+                                          frc::Transform2d(), 0.5_m, 20.0_m,
+                                          640, 480, 1.0);
+  for (int i = 0; i < 40; ++i) {
+    auto targetPose = frc::Pose2d(
+        frc::Translation2d(units::meter_t(i % 8 * 2.0),
+                           units::meter_t(i / 8 * 2.0 - 4.0)),
+        frc::Rotation2d());
+    sysUnderTest.AddSimVisionTarget(photonlib::SimVisionTarget(
+        targetPose, units::meter_t(i % 3 * 0.5), 0.5_m, 0.5_m));
+  }
+
+  std::vector<frc::Pose2d> robotPoses;
+  for (int i = 0; i < 500; ++i) {
+    robotPoses.emplace_back(units::meter_t(i % 25 * 0.6 - 2.0),
+                            units::meter_t(i % 7 - 3.0),
+                            frc::Rotation2d(units::degree_t(i * 37.0)));
+  }
+  std::vector<photonlib::PhotonPipelineResult> results(robotPoses.size());
+  photonlib::WorkStealingPool pool(4);
+  sysUnderTest.ProcessFrames(robotPoses, results, pool);
+
+  size_t withTargets = 0;
+  for (size_t i = 0; i < robotPoses.size(); ++i) {
+    sysUnderTest.ProcessFrame(robotPoses[i]);
+    EXPECT_EQ(sysUnderTest.cam.GetLatestResult(), results[i]) << i;
+    withTargets += results[i].HasTargets();
+  }
+  EXPECT_GT(withTargets, 0u);
+  EXPECT_LT(withTargets, robotPoses.size());
+}
+
+TEST(SimVisionSystemTest, testObstacleHidesTarget) {
+  auto targetPose =
+      frc::Pose2d(frc::Translation2d(10_m, 0_m), frc::Rotation2d());
+
+  photonlib::SimVisionSystem sysUnderTest("Test", 80.0_deg, 0.0_deg,
+                                          frc::Transform2d(), 1.0_m, 99999.0_m,
+                                          320, 240, 0.0);
+  sysUnderTest.AddSimVisionTarget(
+      photonlib::SimVisionTarget(targetPose, 1.0_m, 1.0_m, 1.0_m));
+  // The wall the target is mounted on doesn't hide it.
+  sysUnderTest.AddObstacle({frc::Translation2d(10_m, -2_m),
+                            frc::Translation2d(10_m, 2_m)});
+
+  sysUnderTest.ProcessFrame(frc::Pose2d());
+  EXPECT_TRUE(sysUnderTest.cam.GetLatestResult().HasTargets());
+
+  // A robot parked between the camera and the target does.
+  sysUnderTest.AddObstacle(
+      {frc::Translation2d(5_m, -0.5_m), frc::Translation2d(5_m, 0.5_m), 2_m});
+  sysUnderTest.ProcessFrame(frc::Pose2d());
+  EXPECT_FALSE(sysUnderTest.cam.GetLatestResult().HasTargets());
+
+  // Until the camera moves to look past it.
+  sysUnderTest.ProcessFrame(frc::Pose2d(0_m, 2_m, frc::Rotation2d()));
+  EXPECT_TRUE(sysUnderTest.cam.GetLatestResult().HasTargets());
+}
+
+TEST(SimVisionSystemTest, testSimulatedLatency) {
+  auto targetPose =
+      frc::Pose2d(frc::Translation2d(10_m, 0_m), frc::Rotation2d());
+  photonlib::SimVisionSystem sysUnderTest("LatencyTest", 80.0_deg, 0.0_deg,
+                                          frc::Transform2d(), 1.0_m, 99999.0_m,
+                                          320, 240, 0.0);
+  sysUnderTest.AddSimVisionTarget(
+      photonlib::SimVisionTarget(targetPose, 1.0_m, 1.0_m, 1.0_m));
+  auto facingAway = frc::Pose2d(0_m, 0_m, frc::Rotation2d(180_deg));
+  sysUnderTest.ProcessFrame(facingAway);
+  EXPECT_FALSE(sysUnderTest.cam.GetLatestResult().HasTargets());
+
+  sysUnderTest.SetFrameRate(units::hertz_t(10.0));
+  sysUnderTest.SetLatency(0.05_s, 0_s);
+
+  // Captured at 0 s, still in the pipeline at 40 ms.
+  sysUnderTest.ProcessFrame(frc::Pose2d(), 0_s);
+  sysUnderTest.ProcessFrame(frc::Pose2d(), 0.04_s);
+  EXPECT_FALSE(sysUnderTest.cam.GetLatestResult().HasTargets());
+
+  // Published on the first call after it completes, dated from capture. The
+  // robot has turned away since, but the result shows the old pose.
+  sysUnderTest.ProcessFrame(facingAway, 0.06_s);
+  auto result = sysUnderTest.cam.GetLatestResult();
+  ASSERT_TRUE(result.HasTargets());
+  EXPECT_NEAR(0.06, result.GetLatency().to<double>(), 1e-9);
+}
+
+TEST(SimVisionSystemTest, testTimingSeedAndReset) {
+  auto targetPose =
+      frc::Pose2d(frc::Translation2d(10_m, 0_m), frc::Rotation2d());
+  photonlib::SimVisionSystem sysUnderTest("TimingTest", 80.0_deg, 0.0_deg,
+                                          frc::Transform2d(), 1.0_m, 99999.0_m,
+                                          320, 240, 0.0);
+  sysUnderTest.AddSimVisionTarget(
+      photonlib::SimVisionTarget(targetPose, 1.0_m, 1.0_m, 1.0_m));
+  auto facingAway = frc::Pose2d(0_m, 0_m, frc::Rotation2d(180_deg));
+
+  sysUnderTest.SetFrameRate(units::hertz_t(50.0));
+  sysUnderTest.SetLatency(0.03_s, 0.01_s);
+  sysUnderTest.SetFrameDropRate(0.3);
+  auto run = [&] {
+    sysUnderTest.ResetTiming();
+    sysUnderTest.SetTimingSeed(7);
+    sysUnderTest.ProcessFrame(facingAway);
+    std::vector<double> latencies;
+    for (int i = 0; i < 50; ++i) {
+      sysUnderTest.ProcessFrame(frc::Pose2d(), units::second_t(i * 0.01));
+      latencies.push_back(
+          sysUnderTest.cam.GetLatestResult().GetLatency().to<double>());
+    }
+    return latencies;
+  };
+  EXPECT_EQ(run(), run());
+
+  // A frame still in the pipeline is forgotten.
+  sysUnderTest.SetLatency(0.05_s, 0_s);
+  sysUnderTest.SetFrameDropRate(0.0);
+  sysUnderTest.ProcessFrame(facingAway);
+  sysUnderTest.ProcessFrame(frc::Pose2d(), 1_s);
+  sysUnderTest.ResetTiming();
+  sysUnderTest.ProcessFrame(facingAway, 0_s);
+  sysUnderTest.ProcessFrame(facingAway, 1.06_s);
+  EXPECT_FALSE(sysUnderTest.cam.GetLatestResult().HasTargets());
+}
+
+TEST(SimVisionSystemTest, testNoiseReproducibleAcrossThreads) {
+  photonlib::SimVisionSystem sysUnderTest("test", 100.0_deg, 0.0_deg,
+                                          frc::Transform2d(), 0.5_m, 20.0_m,
+                                          640, 480, 0.0);
+  for (int i = 0; i < 10; ++i) {
+    auto targetPose = frc::Pose2d(
+        frc::Translation2d(5_m, units::meter_t(i - 5.0)), frc::Rotation2d());
+    sysUnderTest.AddSimVisionTarget(
+        photonlib::SimVisionTarget(targetPose, 0.5_m, 0.5_m, 0.5_m));
+  }
+  photonlib::SimNoiseModel noise(1234);
+  noise.SetAngleNoise(0.2_deg, 0.05_deg);
+  noise.SetAreaNoise(0.05);
+  noise.SetFalseNegativeRate(0.1);
+  noise.SetFalsePositiveRate(0.1);
+
+  std::vector<frc::Pose2d> robotPoses;
+  for (int i = 0; i < 300; ++i) {
+    robotPoses.emplace_back(units::meter_t(i % 10 * 0.2), 0_m,
+                            frc::Rotation2d(units::degree_t(i % 20 - 10.0)));
+  }
+
+  auto run = [&](size_t workers) {
+    sysUnderTest.SetNoiseModel(noise);
+    std::vector<photonlib::PhotonPipelineResult> results(robotPoses.size());
+    photonlib::WorkStealingPool pool(workers);
+    sysUnderTest.ProcessFrames(robotPoses, results, pool);
+    return results;
+  };
+  auto serial = run(1);
+  auto parallel = run(4);
+
+  // The second run continues the frame numbering, so its noise differs...
+  size_t differing = 0;
+  for (size_t i = 0; i < serial.size(); ++i) {
+    differing += serial[i] != parallel[i];
+  }
+  EXPECT_GT(differing, serial.size() / 2);
+
+  // ...but a fresh system reproduces the first run exactly in parallel.
+  photonlib::SimVisionSystem fresh("test", 100.0_deg, 0.0_deg,
+                                   frc::Transform2d(), 0.5_m, 20.0_m, 640,
+                                   480, 0.0);
+  for (int i = 0; i < 10; ++i) {
+    auto targetPose = frc::Pose2d(
+        frc::Translation2d(5_m, units::meter_t(i - 5.0)), frc::Rotation2d());
+    fresh.AddSimVisionTarget(
+        photonlib::SimVisionTarget(targetPose, 0.5_m, 0.5_m, 0.5_m));
+  }
+  fresh.SetNoiseModel(noise);
+  std::vector<photonlib::PhotonPipelineResult> results(robotPoses.size());
+  photonlib::WorkStealingPool pool(4);
+  fresh.ProcessFrames(robotPoses, results, pool);
+  for (size_t i = 0; i < serial.size(); ++i) {
+    EXPECT_EQ(serial[i], results[i]) << i;
+  }
+}
+
+TEST(SimVisionSystemTest, testPinholePartiallyVisibleTarget) {
+  photonlib::SimVisionSystem sysUnderTest("PinholeTest", 80.0_deg, 0.0_deg,
+                                          frc::Transform2d(), 1.0_m, 99999.0_m,
+                                          320, 240, 0.0);
+  sysUnderTest.SetCameraIntrinsics(
+      photonlib::SimCameraIntrinsics(250.0, 250.0, 160.0, 120.0, 320, 240));
+
+  // The target's center is just past the left edge of the image, so the
+  // FOV-based model would drop it, but its right half is in view.
+  auto targetPose = frc::Pose2d(frc::Translation2d(4_m, 2.6_m),
+                                frc::Rotation2d(180_deg));
+  sysUnderTest.AddSimVisionTarget(
+      photonlib::SimVisionTarget(targetPose, 1.0_m, 0.4_m, 0.4_m));
+
+  std::vector<photonlib::PhotonPipelineResult> results(1);
+  sysUnderTest.ProcessFrames(frc::Pose2d(), results);
+  ASSERT_TRUE(results[0].HasTargets());
+  auto target = results[0].GetBestTarget();
+
+  // About 10 of its 25 pixel columns are visible, at the image's left edge.
+  EXPECT_NEAR(100.0 * 10 * 25 / (320 * 240), target.GetArea(), 0.01);
+  units::degree_t yaw = units::radian_t(-std::atan2(155.0, 250.0));
+  EXPECT_NEAR(yaw.to<double>(), target.GetYaw(), 0.01);
+  EXPECT_NEAR(0.0, target.GetPitch(), 1e-9);
+}
+
+TEST(SimVisionSystemTest, testPinholeAreaSettingsInPixels) {
+  auto makeSystem = [](double minTargetArea) {
+    auto sys = std::make_unique<photonlib::SimVisionSystem>(
+        "PinholeAreaTest", 80.0_deg, 0.0_deg, frc::Transform2d(), 1.0_m,
+        99999.0_m, 320, 240, minTargetArea);
+    sys->SetCameraIntrinsics(
+        photonlib::SimCameraIntrinsics(250.0, 250.0, 160.0, 120.0, 320, 240));
+    auto targetPose =
+        frc::Pose2d(frc::Translation2d(4_m, 0_m), frc::Rotation2d(180_deg));
+    sys->AddSimVisionTarget(
+        photonlib::SimVisionTarget(targetPose, 1.0_m, 0.4_m, 0.4_m));
+    return sys;
+  };
+
+  // The target covers 25 x 25 pixels, or about 0.8% of the image.
+  std::vector<photonlib::PhotonPipelineResult> results(1);
+  makeSystem(600.0)->ProcessFrames(frc::Pose2d(), results);
+  ASSERT_TRUE(results[0].HasTargets());
+  EXPECT_NEAR(100.0 * 25 * 25 / (320 * 240),
+              results[0].GetBestTarget().GetArea(), 0.01);
+  makeSystem(650.0)->ProcessFrames(frc::Pose2d(), results);
+  EXPECT_FALSE(results[0].HasTargets());
+
+  // Spurious targets as large as the image report at most 100%.
+  auto sys = makeSystem(0.0);
+  photonlib::SimNoiseModel noise(3);
+  noise.SetFalsePositiveRate(1.0, 320 * 240);
+  sys->SetNoiseModel(noise);
+  auto facingAway = frc::Pose2d(0_m, 0_m, frc::Rotation2d(180_deg));
+  std::vector<frc::Pose2d> robotPoses(50, facingAway);
+  results.resize(robotPoses.size());
+  sys->ProcessFrames(robotPoses, results);
+  for (auto& result : results) {
+    ASSERT_TRUE(result.HasTargets());
+    EXPECT_LE(result.GetBestTarget().GetArea(), 100.0);
+  }
+}
+
+// A timing benchmark rather than a check, so it only runs when asked for with
+// --gtest_also_run_disabled_tests.
+TEST(SimVisionSystemTest, DISABLED_benchmarkPerTargetCost) {
+  // Every target sits in front of the camera, in range and in view, so each
+  // one passes the grid and visibility kernel and the time is spent in the
+  // exact per-target checks.
+  photonlib::SimVisionSystem sysUnderTest("PerTargetBenchmark", 100.0_deg,
+                                          0.0_deg, frc::Transform2d(), 0.5_m,
+                                          50.0_m, 640, 480, 0.0);
+  for (int i = 0; i < 2000; ++i) {
+    units::meter_t dist(2.0 + i % 50 * 0.5);
+    units::degree_t bearing((i / 50 - 20) * 1.2);
+    auto targetPose =
+        frc::Pose2d(frc::Translation2d(dist * units::math::cos(bearing),
+                                       dist * units::math::sin(bearing)),
+                    frc::Rotation2d(180_deg));
+    sysUnderTest.AddSimVisionTarget(photonlib::SimVisionTarget(
+        targetPose, units::meter_t(i % 4 * 0.2), 0.3_m, 0.3_m));
+  }
+
+  std::vector<frc::Pose2d> robotPoses;
+  for (int i = 0; i < 500; ++i) {
+    robotPoses.emplace_back(units::meter_t(i % 5 * -0.01), 0_m,
+                            frc::Rotation2d(units::degree_t(i % 3 - 1.0)));
+  }
+  std::vector<photonlib::PhotonPipelineResult> results(robotPoses.size());
+  photonlib::WorkStealingPool pool(1);
+  auto start = std::chrono::steady_clock::now();
+  sysUnderTest.ProcessFrames(robotPoses, results, pool);
+  std::chrono::duration<double, std::nano> elapsed =
+      std::chrono::steady_clock::now() - start;
+
+  size_t sightings = 0;
+  for (auto& result : results) sightings += result.GetTargets().size();
+  ASSERT_GT(sightings, 0u);
+  std::printf("Per-target cost: %.1f ns over %zu sightings\n",
+              elapsed.count() / sightings, sightings);
+}
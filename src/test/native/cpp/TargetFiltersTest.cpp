@@ -0,0 +1,105 @@
+/**
+ * Copyright (C) 2020-2021 Photon Vision.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+#include <units/angle.h>
+#include <units/length.h>
+#include <units/time.h>
+
+#include "gtest/gtest.h"
+#include "photonlib/TargetFilters.h"
+
+TEST(TargetFiltersTest, ExponentialFilter) {
+  photonlib::ExponentialFilter filter(0.25);
+  EXPECT_DOUBLE_EQ(4.0, filter.Calculate(4.0));
+  EXPECT_DOUBLE_EQ(5.0, filter.Calculate(8.0));
+  filter.Reset();
+  EXPECT_DOUBLE_EQ(-1.0, filter.Calculate(-1.0));
+}
+
+TEST(TargetFiltersTest, MovingAverageFilter) {
+  photonlib::MovingAverageFilter filter(3);
+  EXPECT_DOUBLE_EQ(3.0, filter.Calculate(3.0));
+  EXPECT_DOUBLE_EQ(4.0, filter.Calculate(5.0));
+  EXPECT_DOUBLE_EQ(5.0, filter.Calculate(7.0));
+  EXPECT_DOUBLE_EQ(7.0, filter.Calculate(9.0));
+}
+
+TEST(TargetFiltersTest, MovingMedianFilterMatchesSort) {
+  for (size_t window : {1u, 2u, 5u, 8u}) {
+    photonlib::MovingMedianFilter filter(window);
+    std::deque<double> recent;
+    uint32_t seed = 12345;
+    for (int i = 0; i < 500; ++i) {
+      seed = seed * 1664525u + 1013904223u;
+      // Draw from a small range so the window contains duplicates.
+      double value = static_cast<double>(seed >> 28);
+      recent.push_back(value);
+      if (recent.size() > window) recent.pop_front();
+
+      std::vector<double> sorted(recent.begin(), recent.end());
+      std::sort(sorted.begin(), sorted.end());
+      size_t n = sorted.size();
+      double expected = n % 2 == 1
+                            ? sorted[n / 2]
+                            : (sorted[n / 2 - 1] + sorted[n / 2]) / 2.0;
+      ASSERT_DOUBLE_EQ(expected, filter.Calculate(value))
+          << "window " << window << " step " << i;
+    }
+  }
+}
+
+TEST(TargetFiltersTest, KalmanFilter1dConverges) {
+  photonlib::KalmanFilter1d filter(1e-4, 1.0);
+  double estimate = 0.0;
+  for (int i = 0; i < 200; ++i) {
+    estimate = filter.Calculate(i % 2 == 0 ? 11.0 : 9.0);
+  }
+  EXPECT_NEAR(10.0, estimate, 0.2);
+}
+
+TEST(TargetFiltersTest, TargetFilterKeysBySlot) {
+  photonlib::TargetFilter<photonlib::MovingAverageFilter> filter(
+      photonlib::MovingAverageFilter(2), 2);
+
+  wpi::SmallVector<photonlib::PhotonTrackedTarget, 2> first{
+      photonlib::PhotonTrackedTarget(1.0, 2.0, 3.0, 0.0, frc::Transform2d()),
+      photonlib::PhotonTrackedTarget(10.0, 20.0, 30.0, 0.0,
+                                     frc::Transform2d())};
+  wpi::SmallVector<photonlib::PhotonTrackedTarget, 2> second{
+      photonlib::PhotonTrackedTarget(3.0, 4.0, 5.0, 0.0, frc::Transform2d()),
+      photonlib::PhotonTrackedTarget(30.0, 40.0, 50.0, 0.0,
+                                     frc::Transform2d())};
+  filter.Calculate(photonlib::PhotonPipelineResult(1_ms, first));
+  auto result = filter.Calculate(photonlib::PhotonPipelineResult(1_ms, second));
+
+  ASSERT_EQ(2ul, result.GetTargets().size());
+  EXPECT_DOUBLE_EQ(2.0, result.GetTargets()[0].GetYaw());
+  EXPECT_DOUBLE_EQ(3.0, result.GetTargets()[0].GetPitch());
+  EXPECT_DOUBLE_EQ(4.0, result.GetTargets()[0].GetArea());
+  EXPECT_DOUBLE_EQ(20.0, result.GetTargets()[1].GetYaw());
+
+  // Losing the second target resets its filters.
+  filter.Calculate(photonlib::PhotonPipelineResult(
+      1_ms, wpi::ArrayRef<photonlib::PhotonTrackedTarget>(first).slice(0, 1)));
+  result = filter.Calculate(photonlib::PhotonPipelineResult(1_ms, second));
+  EXPECT_DOUBLE_EQ(30.0, result.GetTargets()[1].GetYaw());
+}
@@ -0,0 +1,69 @@
+/**
+ * Copyright (C) 2020-2021 Photon Vision.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "photonlib/WorkStealingPool.h"
+
+class WorkStealingPoolTestSizeParam : public testing::TestWithParam<size_t> {};
+INSTANTIATE_TEST_SUITE_P(WorkStealingPoolTestSizeParamInst,
+                         WorkStealingPoolTestSizeParam,
+                         testing::Values(1, 2, 3, 8));
+
+TEST_P(WorkStealingPoolTestSizeParam, testEachIndexOnce) {
+  photonlib::WorkStealingPool pool(GetParam());
+  ASSERT_EQ(GetParam(), pool.Size());
+
+  for (size_t count : {0, 1, 5, 1000, 12345}) {
+    std::vector<std::atomic<int>> visits(count);
+    std::atomic<bool> badWorker{false};
+    pool.ParallelFor(count, [&](size_t worker, size_t i) {
+      if (worker >= pool.Size()) badWorker = true;
+      visits[i]++;
+    });
+    EXPECT_FALSE(badWorker);
+    for (size_t i = 0; i < count; ++i) {
+      ASSERT_EQ(1, visits[i].load()) << "count " << count << " index " << i;
+    }
+  }
+}
+
+TEST(WorkStealingPoolTest, testUnevenWorkIsStolen) {
+  photonlib::WorkStealingPool pool(4);
+
+  // All of the slow indices land in the first worker's initial range, so
+  // the others only get any of them by stealing.
+  std::vector<std::atomic<int>> byWorker(pool.Size());
+  pool.ParallelFor(400, [&](size_t worker, size_t i) {
+    if (i < 100) std::this_thread::sleep_for(std::chrono::microseconds(200));
+    byWorker[worker]++;
+  });
+
+  int total = 0;
+  int busyWorkers = 0;
+  for (auto& count : byWorker) {
+    total += count;
+    busyWorkers += count > 0;
+  }
+  EXPECT_EQ(400, total);
+  EXPECT_GT(byWorker[1] + byWorker[2] + byWorker[3], 300);
+  EXPECT_EQ(4, busyWorkers);
+}
@@ -0,0 +1,71 @@
+/**
+ * Copyright (C) 2020-2021 Photon Vision.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstdint>
+
+#include <frc/geometry/Pose2d.h>
+#include <units/angle.h>
+#include <units/length.h>
+
+#include "photonlib/SimPinholeCamera.h"
+
+/*
+ * Helpers shared by the simulation tests.
+ */
+namespace simtest {
+
+/**
+ * A 64 bit linear congruential generator, so that randomized tests see the
+ * same inputs on every run and platform.
+ */
+class Lcg {
+ public:
+  explicit Lcg(uint64_t seed) : state(seed) {}
+
+  /**
+   * Returns the next value, uniform in [lo, hi).
+   */
+  double Next(double lo, double hi) {
+    state = state * 6364136223846793005ull + 1442695040888963407ull;
+    return lo + (hi - lo) * static_cast<double>(state >> 11) / (1ull << 53);
+  }
+
+ private:
+  uint64_t state;
+};
+
+/**
+ * Projects one target seen by a level camera at the origin, and measures it
+ * in the image.
+ */
+inline photonlib::SimProjectedShape MeasureTarget(
+    const photonlib::SimCameraIntrinsics& intrinsics, frc::Pose2d targetPos,
+    units::meter_t width, units::meter_t height,
+    const photonlib::SimLensDistortion* distortion = nullptr) {
+  photonlib::SimPinholeView view(frc::Pose2d(), 0_m, 0_deg, intrinsics,
+                                 distortion);
+  photonlib::SimTargetGeometry geometry;
+  geometry.Resize(1);
+  geometry.Set(0, photonlib::SimVisionTarget(targetPos, 0_m, width, height));
+  photonlib::SimProjectedTargets projected;
+  photonlib::ProjectTargets(view, geometry, 1, projected);
+  return photonlib::MeasureProjectedTarget(view, projected, 0);
+}
+
+}  // namespace simtest